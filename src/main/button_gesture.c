@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "button_gesture.h"
+
+#define MS_TO_US(_ms) ((microseconds) (_ms) * 1000U)
+
+// Wrap safe, timestamps are at most half the counter range apart
+static bool is_reached(microseconds now, microseconds at) {
+    return (int32_t) (now - at) >= 0;
+}
+
+static void arm(button_gesture_t* button, microseconds at, miliseconds timeout) {
+    button->has_deadline = timeout != 0;
+    button->deadline     = at + MS_TO_US(timeout);
+}
+
+void button_gesture_init(button_gesture_t* button, const button_gesture_timing_t* timing) {
+    memset(button, 0, sizeof(*button));
+    button->timing = *timing;
+}
+
+void button_gesture_input(button_gesture_t* button, microseconds timestamp, bool is_pressed) {
+    if (is_pressed == button->raw)
+        return;
+    // Every bounce starts the debounce over
+    button->raw       = is_pressed;
+    button->raw_since = timestamp;
+}
+
+static button_gesture_type on_press(button_gesture_t* button, microseconds at) {
+    switch (button->state) {
+        case BUTTON_STATE_RELEASED:
+            button->state = BUTTON_STATE_PRESSED;
+            arm(button, at, button->timing.long_press);
+            break;
+
+        case BUTTON_STATE_CLICKED:
+            button->state = BUTTON_STATE_DOUBLE_PRESSED;
+            button->has_deadline = false;
+            return BUTTON_GESTURE_DOUBLE_CLICK;
+
+        default:
+            break;
+    }
+    return BUTTON_GESTURE_NONE;
+}
+
+static button_gesture_type on_release(button_gesture_t* button, microseconds at) {
+    const bool is_click = button->state == BUTTON_STATE_PRESSED;
+
+    button->state        = BUTTON_STATE_RELEASED;
+    button->has_deadline = false;
+    if (!is_click)
+        return BUTTON_GESTURE_NONE;
+    if (!button->timing.double_click)
+        return BUTTON_GESTURE_CLICK;
+
+    button->state = BUTTON_STATE_CLICKED;
+    arm(button, at, button->timing.double_click);
+    return BUTTON_GESTURE_NONE;
+}
+
+static button_gesture_type on_timeout(button_gesture_t* button) {
+    switch (button->state) {
+        case BUTTON_STATE_PRESSED:
+            button->state = BUTTON_STATE_HELD;
+            // Repeats keep their cadence however late they are ticked
+            arm(button, button->deadline, button->timing.hold_repeat);
+            return BUTTON_GESTURE_LONG_PRESS;
+
+        case BUTTON_STATE_HELD:
+            arm(button, button->deadline, button->timing.hold_repeat);
+            return BUTTON_GESTURE_HOLD_REPEAT;
+
+        case BUTTON_STATE_CLICKED:
+            button->state        = BUTTON_STATE_RELEASED;
+            button->has_deadline = false;
+            return BUTTON_GESTURE_CLICK;
+
+        default:
+            button->has_deadline = false;
+            break;
+    }
+    return BUTTON_GESTURE_NONE;
+}
+
+button_gesture_type button_gesture_tick(button_gesture_t* button, microseconds now) {
+    const bool is_edge_pending = button->raw != button->is_pressed;
+    const bool is_timed_out    = button->has_deadline && is_reached(now, button->deadline);
+
+    // An edge from before the deadline decides first, once it held or bounced back
+    if (is_timed_out && !(is_edge_pending && !is_reached(button->raw_since, button->deadline)))
+        return on_timeout(button);
+
+    if (!is_edge_pending || !is_reached(now, button->raw_since + MS_TO_US(button->timing.debounce)))
+        return BUTTON_GESTURE_NONE;
+
+    // Gestures are timed from the edge, not from when its debounce ran out
+    button->is_pressed = button->raw;
+    return button->is_pressed ? on_press(button, button->raw_since) : on_release(button, button->raw_since);
+}
+
+bool button_gesture_wait(const button_gesture_t* button, microseconds now, microseconds* wait) {
+    const bool is_edge_pending = button->raw != button->is_pressed;
+
+    if (!is_edge_pending && !button->has_deadline)
+        return false;
+
+    // A deadline the pending edge came after is due first, an earlier one waits for the edge
+    const bool is_edge_first = is_edge_pending && !(button->has_deadline &&
+                                                   is_reached(button->raw_since, button->deadline));
+    const microseconds at    = is_edge_first ? button->raw_since + MS_TO_US(button->timing.debounce)
+                                             : button->deadline;
+    *wait = is_reached(now, at) ? 0 : at - now;
+    return true;
+}
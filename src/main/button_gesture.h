@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_BUTTON_GESTURE_
+#define _MAIN_BUTTON_GESTURE_
+
+#include <stdbool.h>
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BUTTON_GESTURE_NONE,
+    BUTTON_GESTURE_CLICK,
+    BUTTON_GESTURE_DOUBLE_CLICK,
+    BUTTON_GESTURE_LONG_PRESS,
+    BUTTON_GESTURE_HOLD_REPEAT,
+} button_gesture_type;
+
+typedef struct {
+    miliseconds debounce;      // a level has to hold this long before it counts
+    miliseconds double_click;  // window for the second press, 0 reports clicks on release
+    miliseconds long_press;    // 0 turns long presses off
+    miliseconds hold_repeat;   // period of repeats after a long press, 0 turns them off
+} button_gesture_timing_t;
+
+typedef enum {
+    BUTTON_STATE_RELEASED,
+    BUTTON_STATE_PRESSED,
+    BUTTON_STATE_CLICKED,         // released, waiting out the double click window
+    BUTTON_STATE_DOUBLE_PRESSED,
+    BUTTON_STATE_HELD,            // long press reported, repeating until released
+} button_gesture_state;
+
+// Raw levels go in as they are captured, gestures come out of ticks. Nothing
+// runs on its own: the owner ticks on every input and by the next deadline.
+typedef struct {
+    button_gesture_timing_t timing;
+    button_gesture_state    state;
+    bool                    raw;          // last level fed, true while pressed
+    microseconds            raw_since;
+    bool                    is_pressed;   // debounced level
+    bool                    has_deadline;
+    microseconds            deadline;     // of the state timeout
+} button_gesture_t;
+
+void button_gesture_init(button_gesture_t* button, const button_gesture_timing_t* timing);
+void button_gesture_input(button_gesture_t* button, microseconds timestamp, bool is_pressed);
+// At most one gesture per call, tick until BUTTON_GESTURE_NONE
+button_gesture_type button_gesture_tick(button_gesture_t* button, microseconds now);
+// Time left until something is due to tick, false while nothing is
+bool button_gesture_wait(const button_gesture_t* button, microseconds now, microseconds* wait);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_BUTTON_GESTURE_
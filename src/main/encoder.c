@@ -22,14 +22,24 @@
 #include <stdint.h>
 #include <limits.h>
 
+#include "button_gesture.h"
 #include "encoder.h"
-#include "encoder_fsm.h"
+#include "encoder_decoder.h"
+#include "input_storm.h"
+#include "menu.h"
 
-#include "utilities/timer.h"
+#include "utilities/addons.h"
 #include "utilities/scheduler.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
 #include <esp_attr.h>
+#include <esp_timer.h>
 #include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#include <soc/gpio_struct.h>
 
 #define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_DEBUG
 #include "utilities/logger.h"
@@ -38,50 +48,196 @@
 #define ENCODER_A_PIN    GPIO_NUM_20
 #define ENCODER_B_PIN    GPIO_NUM_21
 
-static void process_detected_state(void* args, uint32_t state) {
-    encoder_event_type event = ENCODER_EVENT_LAST;
+// Above the scheduler loop in app_main, so detents reach the menu queue in order
+#define ENCODER_TASK_PRIORITY   (tskIDLE_PRIORITY + 2)
+#define ENCODER_TASK_STACK_SIZE 2048U
 
-    switch (state) {
-        case ENCODER_DIRECTION_CLOCKWISE:
+// Notification bits of the encoder task
+#define ENCODER_NOTIFY_SAMPLES  (1UL << 0)
+#define ENCODER_NOTIFY_STORM    (1UL << 1) // interrupts masked, edge budget spent
+#define ENCODER_NOTIFY_DEBOUNCE (1UL << 2) // interrupts masked, push button edge
+#define ENCODER_NOTIFY_SETTLED  (1UL << 3)
+
+_Static_assert(!INPUT_BUTTON_DOUBLE_CLICK_MS || INPUT_BUTTON_DEBOUNCE_MS < INPUT_BUTTON_DOUBLE_CLICK_MS,
+               "a debounced second press can never make the double click window");
+_Static_assert(!INPUT_BUTTON_LONG_PRESS_MS || INPUT_BUTTON_DEBOUNCE_MS < INPUT_BUTTON_LONG_PRESS_MS,
+               "long presses would fire before the press is debounced");
+
+// DRAM, mask_pins() reads it with the flash cache possibly off
+static const DRAM_ATTR gpio_num_t encoder_pins[] = {ENCODER_A_PIN, ENCODER_B_PIN, ENCODER_PUSH_PIN};
+
+static struct {
+    encoder_decoder_t  knob;
+    input_storm_t      storm;
+    button_gesture_t   button;
+    TaskHandle_t       task;
+    esp_timer_handle_t poll_timer;
+} ctx;
+
+// Straight from the input register, gpio_get_level() lives in flash
+static IRAM_ATTR uint8_t read_levels(void) {
+    const uint32_t input = REG_READ(GPIO_IN_REG);
+
+    return (input & (1UL << ENCODER_A_PIN) ? ENCODER_LEVEL_A : 0)
+         | (input & (1UL << ENCODER_B_PIN) ? ENCODER_LEVEL_B : 0)
+         | (input & (1UL << ENCODER_PUSH_PIN) ? ENCODER_LEVEL_PUSH : 0);
+}
+
+// Through the HAL, it is inlined where gpio_intr_disable() would run from flash
+static IRAM_ATTR void mask_pins(void) {
+    for (unsigned i = 0; i < COUNT_OF(encoder_pins); i++)
+        gpio_ll_intr_disable(&GPIO, encoder_pins[i]);
+}
+
+static void unmask_pins(void) {
+    for (unsigned i = 0; i < COUNT_OF(encoder_pins); i++) {
+        gpio_ll_clear_intr_status_bit(&GPIO, encoder_pins[i]);
+        gpio_intr_enable(encoder_pins[i]);
+    }
+}
+
+// Shared by all three pins, it only samples them and leaves the decoding to
+// encoder_task. Push button edges and edge storms mask the pins until polling
+// has seen them settle.
+IRAM_ATTR void gpio_encoder_isr_routine(void* arg) {
+    const microseconds now = (microseconds) esp_timer_get_time();
+    const uint8_t raw      = read_levels();
+    const bool is_admitted = input_storm_admit(&ctx.storm, now);
+    const bool is_push     = (raw ^ ctx.storm.levels) & ENCODER_LEVEL_PUSH;
+    uint32_t notification  = ENCODER_NOTIFY_SAMPLES;
+    BaseType_t is_woken    = pdFALSE;
+
+    encoder_decoder_capture(&ctx.knob, now, raw);
+    if (!is_admitted || is_push) {
+        mask_pins();
+        notification |= is_admitted ? ENCODER_NOTIFY_DEBOUNCE : ENCODER_NOTIFY_STORM;
+    }
+    xTaskNotifyFromISR(ctx.task, notification, eSetBits, &is_woken);
+    input_storm_account_edge(&ctx.storm, (microseconds) esp_timer_get_time() - now);
+    portYIELD_FROM_ISR(is_woken);
+}
+
+// esp_timer task, the pins stay masked while this runs, which keeps it the
+// only producer of the knob ring until unmask_pins()
+static void on_poll(void* args) {
+    const microseconds now = (microseconds) esp_timer_get_time();
+    const uint8_t previous = ctx.storm.levels;
+    uint8_t levels;
+
+    const bool is_polling = input_storm_poll(&ctx.storm, now, read_levels(), &levels);
+    uint32_t notification = levels != previous && encoder_decoder_capture(&ctx.knob, now, levels)
+                          ? ENCODER_NOTIFY_SAMPLES : 0;
+    if (!is_polling) {
+        esp_timer_stop(ctx.poll_timer);
+        unmask_pins();
+        notification |= ENCODER_NOTIFY_SETTLED;
+        // An edge between the last poll and the unmasking raised no interrupt
+        notification |= read_levels() != ctx.storm.levels ? ENCODER_NOTIFY_DEBOUNCE : 0;
+    }
+    if (notification)
+        xTaskNotify(ctx.task, notification, eSetBits);
+}
+
+static void start_polling(bool is_storm) {
+    // A late edge found by on_poll asks for polling with the pins unmasked
+    mask_pins();
+    input_storm_begin_polling(&ctx.storm, (microseconds) esp_timer_get_time(), read_levels(), is_storm);
+    esp_timer_start_periodic(ctx.poll_timer, INPUT_POLL_PERIOD_US);
+}
+
+void encoder_get_input_stats(struct input_storm_stats* stats) {
+    *stats = ctx.storm.stats;
+}
+
+static void forward_to_menu(const encoder_decoded_t* decoded) {
+    menu_event_t event = {.type = MENU_EVENT_ENCODER_LAST, .velocity = decoded->velocity};
+
+    switch (decoded->type) {
+        case ENCODER_EVENT_UP:
             log_info("Up!");
-            event = ENCODER_EVENT_UP;
+            event.type = MENU_EVENT_ENCODER_UP;
             break;
 
-        case ENCODER_DIRECTION_COUNTERCLOCKWISE:
-            event = ENCODER_EVENT_DOWN;
+        case ENCODER_EVENT_DOWN:
             log_info("Down!");
+            event.type = MENU_EVENT_ENCODER_DOWN;
             break;
 
+        case ENCODER_EVENT_PUSH:
+        case ENCODER_EVENT_RELEASE:
+            // The menu gets gestures, see forward_gesture()
+            button_gesture_input(&ctx.button, decoded->timestamp, decoded->type == ENCODER_EVENT_PUSH);
+            return;
+
         default:
             break;
     }
     scheduler_enqueue(SchedulerQueueMenu, &event);
 }
 
-static void process_button_click(void* args, uint32_t state) {
-    log_info("Click!");
-    encoder_event_type event = ENCODER_EVENT_PUSH;
-    scheduler_enqueue(SchedulerQueueMenu, &event);
-}
+static void forward_gesture(button_gesture_type gesture) {
+    menu_event_t event = {.type = MENU_EVENT_ENCODER_LAST};
 
-IRAM_ATTR void gpio_encoder_isr_routine(void* arg) {
-    encoder_fsm_output direction = encoder_fms_process(gpio_get_level(ENCODER_A_PIN), gpio_get_level(ENCODER_B_PIN));
+    switch (gesture) {
+        case BUTTON_GESTURE_CLICK:
+            log_info("Click!");
+            event.type = MENU_EVENT_ENCODER_PUSH;
+            break;
 
-    switch (direction) {
-        case ENCODER_DIRECTION_CLOCKWISE:
-        case ENCODER_DIRECTION_COUNTERCLOCKWISE:
-            timer_soft_irq(process_detected_state, NULL, (uint32_t) direction);
+        case BUTTON_GESTURE_DOUBLE_CLICK:
+            log_info("Double click!");
+            event.type = MENU_EVENT_ENCODER_BACK;
             break;
-        default:
+
+        case BUTTON_GESTURE_LONG_PRESS:
+            log_info("Long press!");
+            event.type = MENU_EVENT_ENCODER_CANCEL;
             break;
+
+        default:
+            return;
     }
+    scheduler_enqueue(SchedulerQueueMenu, &event);
 }
 
-IRAM_ATTR void gpio_encoder_push_isr_routine(void* arg) {
-    bool is_pressed = !gpio_get_level(ENCODER_PUSH_PIN);
+// Until the next gesture deadline, rounded up so the wake up finds it due
+static TickType_t gesture_timeout(void) {
+    microseconds wait;
 
-    if (is_pressed)
-        timer_soft_irq(process_button_click, NULL, 0);
+    if (!button_gesture_wait(&ctx.button, (microseconds) esp_timer_get_time(), &wait))
+        return portMAX_DELAY;
+    const miliseconds wait_ms = (wait + 999U) / 1000U;
+    return (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+// The esp_timer task runs above this one, so a settle and the request to poll
+// again that an edge right after the unmasking makes always arrive together.
+static void encoder_task(void* args) {
+    encoder_decoded_t decoded;
+    button_gesture_type gesture;
+    uint32_t notification = 0;
+    bool is_polling       = false;
+
+    while (true) {
+        // A timeout is no notification, it leaves only the gestures to tick
+        notification = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notification, gesture_timeout());
+        if (notification & ENCODER_NOTIFY_SETTLED) {
+            is_polling = false;
+            log_debug("input settled, %u edges, %u storms, %u debounces, slowest edge %u us",
+              ctx.storm.stats.edges, ctx.storm.stats.storms, ctx.storm.stats.debounces, ctx.storm.stats.slowest_edge);
+        }
+        if (!is_polling && (notification & (ENCODER_NOTIFY_STORM | ENCODER_NOTIFY_DEBOUNCE))) {
+            is_polling = true;
+            start_polling(notification & ENCODER_NOTIFY_STORM);
+        }
+        while (encoder_decoder_next(&ctx.knob, &decoded))
+            forward_to_menu(&decoded);
+
+        const microseconds now = (microseconds) esp_timer_get_time();
+        while (BUTTON_GESTURE_NONE != (gesture = button_gesture_tick(&ctx.button, now)))
+            forward_gesture(gesture);
+    }
 }
 
 error_status_t encoder_init(void) {
@@ -101,7 +257,30 @@ error_status_t encoder_init(void) {
     };
 
     gpio_config(&io_conf_isr);
-    gpio_isr_handler_add(ENCODER_PUSH_PIN, gpio_encoder_push_isr_routine, NULL);
+    encoder_decoder_init(&ctx.knob, read_levels());
+    input_storm_init(&ctx.storm, read_levels());
+
+    const button_gesture_timing_t button_timing = {
+        .debounce     = INPUT_BUTTON_DEBOUNCE_MS,
+        .double_click = INPUT_BUTTON_DOUBLE_CLICK_MS,
+        .long_press   = INPUT_BUTTON_LONG_PRESS_MS,
+        .hold_repeat  = INPUT_BUTTON_HOLD_REPEAT_MS,
+    };
+    button_gesture_init(&ctx.button, &button_timing);
+
+    const esp_timer_create_args_t poll_timer = {
+        .callback = on_poll,
+        .name     = "encoder_poll",
+    };
+    if (ESP_OK != esp_timer_create(&poll_timer, &ctx.poll_timer))
+        return ERROR_RESOURCE_UNAVAILABLE;
+
+    static StaticTask_t task_buffer;
+    static StackType_t task_stack[ENCODER_TASK_STACK_SIZE];
+    ctx.task = xTaskCreateStatic(encoder_task, "encoder", ENCODER_TASK_STACK_SIZE, NULL, ENCODER_TASK_PRIORITY,
+                                 task_stack, &task_buffer);
+
+    gpio_isr_handler_add(ENCODER_PUSH_PIN, gpio_encoder_isr_routine, NULL);
     gpio_isr_handler_add(ENCODER_A_PIN, gpio_encoder_isr_routine, NULL);
     gpio_isr_handler_add(ENCODER_B_PIN, gpio_encoder_isr_routine, NULL);
 
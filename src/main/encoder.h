@@ -24,11 +24,15 @@
 #include "utilities/error.h"
 
 error_status_t encoder_init(void);
+struct input_storm_stats;
+// Counters of the interrupt and polling input handling, may be mid update
+void encoder_get_input_stats(struct input_storm_stats* stats);
 
 typedef enum {
     ENCODER_EVENT_UP,
     ENCODER_EVENT_DOWN,
     ENCODER_EVENT_PUSH,
+    ENCODER_EVENT_RELEASE,
     ENCODER_EVENT_LAST
 } encoder_event_type;
 
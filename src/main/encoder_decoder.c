@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "encoder_decoder.h"
+
+void encoder_decoder_init(encoder_decoder_t* decoder, uint8_t levels) {
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->levels = levels;
+}
+
+static bool encoder_decoder_peek(encoder_decoder_t* decoder, encoder_sample_t* sample) {
+    const unsigned tail = __atomic_load_n(&decoder->tail, __ATOMIC_RELAXED);
+
+    if (tail == __atomic_load_n(&decoder->head, __ATOMIC_ACQUIRE))
+        return false;
+    *sample = decoder->samples[tail & (ENCODER_RING_LENGTH - 1)];
+    return true;
+}
+
+static void encoder_decoder_drop(encoder_decoder_t* decoder) {
+    const unsigned tail = __atomic_load_n(&decoder->tail, __ATOMIC_RELAXED);
+    __atomic_store_n(&decoder->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool encoder_decoder_next(encoder_decoder_t* decoder, encoder_decoded_t* decoded) {
+    encoder_sample_t sample;
+
+    while (encoder_decoder_peek(decoder, &sample)) {
+        // Presses and releases are reported on their own, the sample stays queued for a rotation edge taken with it
+        const bool is_pressed = !(sample.levels & ENCODER_LEVEL_PUSH);
+        if (is_pressed != !(decoder->levels & ENCODER_LEVEL_PUSH)) {
+            decoder->levels = (decoder->levels & ~ENCODER_LEVEL_PUSH) | (sample.levels & ENCODER_LEVEL_PUSH);
+            *decoded = (encoder_decoded_t) {
+                .type      = is_pressed ? ENCODER_EVENT_PUSH : ENCODER_EVENT_RELEASE,
+                .timestamp = sample.timestamp,
+            };
+            return true;
+        }
+
+        encoder_decoder_drop(decoder);
+        decoder->levels = sample.levels;
+        const encoder_fsm_output direction = encoder_fsm_process(&decoder->fsm, sample.levels & ENCODER_LEVEL_A,
+                                                                 sample.levels & ENCODER_LEVEL_B);
+        if (ENCODER_DIRECTION_ANY == direction)
+            continue;
+
+        const bool clockwise = ENCODER_DIRECTION_CLOCKWISE == direction;
+        __atomic_fetch_add(&decoder->position, clockwise ? 1 : -1, __ATOMIC_RELAXED);
+        *decoded = (encoder_decoded_t) {
+            .type      = clockwise ? ENCODER_EVENT_UP : ENCODER_EVENT_DOWN,
+            .velocity  = encoder_velocity_update(&decoder->velocity, sample.timestamp / 1000, clockwise),
+            .timestamp = sample.timestamp,
+        };
+        return true;
+    }
+    return false;
+}
+
+int encoder_decoder_position(encoder_decoder_t* decoder) {
+    return __atomic_load_n(&decoder->position, __ATOMIC_RELAXED);
+}
+
+unsigned encoder_decoder_overflows(encoder_decoder_t* decoder) {
+    return __atomic_load_n(&decoder->overflows, __ATOMIC_RELAXED);
+}
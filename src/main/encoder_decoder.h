@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_ENCODER_DECODER_
+#define _MAIN_ENCODER_DECODER_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "encoder.h"
+#include "encoder_fsm.h"
+#include "encoder_velocity.h"
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pin levels of one sample, pulled up, so the push bit is clear while pressed
+#define ENCODER_LEVEL_A    (1U << 0)
+#define ENCODER_LEVEL_B    (1U << 1)
+#define ENCODER_LEVEL_PUSH (1U << 2)
+#define ENCODER_LEVEL_IDLE (ENCODER_LEVEL_A | ENCODER_LEVEL_B | ENCODER_LEVEL_PUSH)
+
+// Power of two, a fast spin queues four edges per detent plus the bounce
+#define ENCODER_RING_LENGTH 32U
+
+typedef struct {
+    microseconds timestamp;
+    uint8_t      levels;
+} encoder_sample_t;
+
+// Single producer, single consumer: head and overflows are only written by the
+// capturing side, tail and everything below it by the decoding task. Capture
+// runs in the pin interrupt and, while the pins are masked, in the poll timer
+// callback; the two never overlap only because polling starts after the pins
+// are masked and unmasks them once it stopped. Anything else capturing has to
+// keep to that or make capture multi-producer safe. The shared fields go
+// through the __atomic builtins, <stdatomic.h> doesn't build as C++11.
+typedef struct {
+    encoder_sample_t   samples[ENCODER_RING_LENGTH];
+    unsigned           head;
+    unsigned           tail;
+    unsigned           overflows;
+    int                position;  // detents, clockwise positive, readable from any task
+    encoder_fsm_t      fsm;
+    encoder_velocity_t velocity;
+    uint8_t            levels;    // as of the last decoded sample
+} encoder_decoder_t;
+
+typedef struct {
+    encoder_event_type type;
+    unsigned           velocity;  // detents per second, 0 for a press or release
+    microseconds       timestamp; // of the captured sample
+} encoder_decoded_t;
+
+void encoder_decoder_init(encoder_decoder_t* decoder, uint8_t levels);
+
+// Called from the pin interrupt, always inlined so the capture path stays in
+// IRAM with the ISR, and from the poll callback while the pins are masked. Pin
+// interrupts don't nest and masking shuts them out during polling, so one ring
+// has one producer at a time.
+__attribute__((always_inline))
+static inline bool encoder_decoder_capture(encoder_decoder_t* decoder, microseconds timestamp, uint8_t levels) {
+    const unsigned head = __atomic_load_n(&decoder->head, __ATOMIC_RELAXED);
+
+    if (head - __atomic_load_n(&decoder->tail, __ATOMIC_ACQUIRE) >= ENCODER_RING_LENGTH) {
+        // Plain load and store, the ISR is the only writer and RV32IMC has no atomic read-modify-write
+        __atomic_store_n(&decoder->overflows, __atomic_load_n(&decoder->overflows, __ATOMIC_RELAXED) + 1,
+                         __ATOMIC_RELAXED);
+        return false;
+    }
+    encoder_sample_t* sample = &decoder->samples[head & (ENCODER_RING_LENGTH - 1)];
+    sample->timestamp = timestamp;
+    sample->levels    = levels;
+    __atomic_store_n(&decoder->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Decodes captured samples up to the next detent, press or release, false once the ring is drained
+bool encoder_decoder_next(encoder_decoder_t* decoder, encoder_decoded_t* decoded);
+int encoder_decoder_position(encoder_decoder_t* decoder);
+unsigned encoder_decoder_overflows(encoder_decoder_t* decoder);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_ENCODER_DECODER_
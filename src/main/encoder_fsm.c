@@ -32,7 +32,7 @@ typedef enum {
     ENCODER_FSM_LAST
 } ENCODER_FSM_STATE;
 
-const uint8_t ttable[ENCODER_FSM_LAST][4] = {
+static const uint8_t ttable[ENCODER_FSM_LAST][4] = {
     // start
     { ENCODER_FSM_START,             ENCODER_FSM_CLOCK_BEGIN,             ENCODER_FSM_CONTERCLOCK_BEGIN,
       ENCODER_FSM_START                                                  },
@@ -57,10 +57,9 @@ const uint8_t ttable[ENCODER_FSM_LAST][4] = {
       ENCODER_FSM_START                                                                                                                                                                                        },
 };
 
-encoder_fsm_output encoder_fms_process(bool a_state, bool b_state) {
-    static uint8_t state = ENCODER_FSM_START;
-    uint8_t pinstate     = ((b_state << 1) | a_state) & 0xF;
+encoder_fsm_output encoder_fsm_process(encoder_fsm_t* fsm, bool a_state, bool b_state) {
+    uint8_t pinstate = ((b_state << 1) | a_state) & 0xF;
 
-    state = ttable[state & 0xf][pinstate];
-    return (encoder_fsm_output) (state & 0x30);
+    fsm->state = ttable[fsm->state & 0xf][pinstate];
+    return (encoder_fsm_output) (fsm->state & 0x30);
 }
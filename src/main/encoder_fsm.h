@@ -18,7 +18,15 @@
  * under the License.
  */
 
+#ifndef _MAIN_ENCODER_FSM_
+#define _MAIN_ENCODER_FSM_
+
 #include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef enum {
     ENCODER_DIRECTION_ANY              = 0x0,
@@ -26,4 +34,16 @@ typedef enum {
     ENCODER_DIRECTION_COUNTERCLOCKWISE = 0x20,
 } encoder_fsm_output;
 
-encoder_fsm_output encoder_fms_process(bool a_state, bool b_state);
+// One decoder per encoder, zero initialized it waits in the detent position
+typedef struct {
+    uint8_t state;
+} encoder_fsm_t;
+
+// Full quadrature cycle per detent, bounce only moves between neighbouring states
+encoder_fsm_output encoder_fsm_process(encoder_fsm_t* fsm, bool a_state, bool b_state);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_ENCODER_FSM_
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "encoder_velocity.h"
+
+unsigned encoder_velocity_update(encoder_velocity_t* tracker, miliseconds timestamp, bool clockwise) {
+    const miliseconds interval = timestamp - tracker->last;
+    const bool is_running = tracker->run > 0 && tracker->clockwise == clockwise && interval < ENCODER_VELOCITY_IDLE_MS;
+
+    tracker->last      = timestamp;
+    tracker->clockwise = clockwise;
+    if (!is_running) {
+        tracker->run      = 1;
+        tracker->velocity = 0;
+        return 0;
+    }
+
+    // Halving the history keeps a single late or early detent from jerking the step size
+    const unsigned instant = 1000U / (interval > 0 ? interval : 1);
+    tracker->velocity = tracker->run++ == 1 ? instant : (tracker->velocity + instant) / 2;
+    return tracker->velocity;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_ENCODER_VELOCITY_
+#define _MAIN_ENCODER_VELOCITY_
+
+#include <stdbool.h>
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A pause this long or a change of direction starts a new run at velocity 0
+#define ENCODER_VELOCITY_IDLE_MS 200U
+
+typedef struct {
+    miliseconds last;      // timestamp of the previous detent
+    unsigned    run;       // detents in the current run
+    unsigned    velocity;  // detents per second, averaged over the run
+    bool        clockwise;
+} encoder_velocity_t;
+
+// Feeds one detent, returns the rotational velocity in detents per second.
+// The first detent of a run always reads 0, so single clicks stay precise.
+unsigned encoder_velocity_update(encoder_velocity_t* tracker, miliseconds timestamp, bool clockwise);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_ENCODER_VELOCITY_
@@ -19,6 +19,7 @@
  */
 
 #include "utilities/timer.h"
+#include "utilities/scheduler.h"
 
 #define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_DEBUG
 #include "utilities/logger.h"
@@ -28,38 +29,66 @@
 #include <stdint.h>
 #include <limits.h>
 #include <driver/gpio.h>
+#include "FreeRTOS.h"
+#include "task.h"
 #include "pid.h"
-#include "spi.h"
+#include "thermocouple_sampler.h"
 #include "heater_calculator.h"
+#include "heater_definitions.h"
+#include "heater_learning_storage.h"
+#include "heating_profile.h"
 #include "utilities/addons.h"
 
 const unsigned invalid_stage_index = UINT_MAX;
 
-typedef struct {
-    struct {
-        seconds from;
-        seconds to;
-    }       time;
-    celcius temperature;
-} temperature_stage;
-
 typedef struct {
     seconds                duration;
-    temperature_stage    * stages;
+    heating_profile        profile;
+    heating_profile_id     profile_id;
     unsigned               actual_stage;
-    unsigned               stage_count;
+    unsigned               stale_windows; // control windows skipped in a row for lack of a fresh sample
+    heater_learning_t*     learning;
     heat_completion_marker completed_routine;
 } heating_mode_descriptor;
 
 static struct {
-    heating_mode_state state;
-    uint16_t           last_readout;
+    heating_mode_state       state;
+    heater_learning_t        learning[HEATING_PROFILE_LAST];
+    bool                     is_learning_loaded[HEATING_PROFILE_LAST];
+    heat_controller_status_t status; // written by the timer task only
 } ctx;
 
 static void execute_heating_mode_periodic(void* heating_mode);
 
-unsigned heat_controller_get_temperature(void) {
-    return ctx.last_readout;
+temperature_t heat_controller_get_temperature(void) {
+    thermocouple_sample_t sample;
+    miliseconds age;
+
+    return thermocouple_sampler_latest(&sample, &age) ? sample.temperature : 0;
+}
+
+// The timer task runs above every reader, so only the reader has to keep the
+// copy from being interrupted by an update.
+bool heat_controller_get_status(heat_controller_status_t* status) {
+    vTaskSuspendAll();
+    *status = ctx.status;
+    bool heating = ctx.state == HEATING_STATE_CONSTANT || ctx.state == HEATING_STATE_MULTI_STAGE;
+    xTaskResumeAll();
+    return heating;
+}
+
+static void publish_status(const heating_mode_descriptor* heating_mode, float percent) {
+    celcius setpoint = 0;
+    seconds duration = heating_profile_duration(&heating_mode->profile);
+
+    (void) heating_profile_setpoint_at(&heating_mode->profile, heating_mode->duration, &setpoint);
+    ctx.status = (heat_controller_status_t) {
+        .setpoint  = setpoint,
+        .power     = (unsigned) (percent + 0.5f),
+        .stage     = heating_mode->actual_stage,
+        .elapsed   = heating_mode->duration,
+        .remaining = duration > heating_mode->duration ? duration - heating_mode->duration : 0,
+    };
 }
 
 error_status_t setup_toggler_pin(void) {
@@ -104,30 +133,41 @@ static void handle_cancel_action_with_callback(heating_mode_descriptor* heating_
     stop_ongoing_request(heating_mode);
 }
 
-static bool is_time_in_range(temperature_stage stage, seconds time) {
-    if (stage.time.from <= time && stage.time.to > time)
-        return true;
-
-    return false;
+static void set_actual_stage(heating_mode_descriptor* heating_mode) {
+    if (!heating_profile_stage_at(&heating_mode->profile, heating_mode->duration, &heating_mode->actual_stage))
+        heating_mode->actual_stage = invalid_stage_index;
 }
 
-static void set_actual_stage(heating_mode_descriptor* heating_mode) {
-    unsigned i    = 0;
-    bool is_found = false;
-
-    for (i = heating_mode->actual_stage; i < heating_mode->stage_count; i++) {
-        is_time_in_range(heating_mode->stages[i], heating_mode->duration) ? ({
-            is_found = true;
-            break;
-        }) : ({ });
+static heater_learning_t* begin_learning(heating_profile_id profile_id, const heating_profile* profile) {
+    if (!HEATER_LEARNING_ENABLED)
+        return NULL;
+
+    heater_learning_t* learning = &ctx.learning[profile_id];
+    if (!ctx.is_learning_loaded[profile_id]) {
+        (void) heater_learning_load(profile_id, learning);
+        ctx.is_learning_loaded[profile_id] = true;
     }
-    heating_mode->actual_stage = i;
-    if (!is_found)
-        heating_mode->actual_stage = invalid_stage_index;
+    heater_learning_begin(learning, heating_profile_duration(profile));
+    return learning;
+}
+
+// Runs in the scheduler task, the NVS commit is far too slow for the timer task.
+// Runs start from the scheduler task as well and this queue is drained ahead of
+// their requests, so the table is stored before the next run touches it.
+static void store_learning(void* data) {
+    heating_profile_id profile_id = *(heating_profile_id*) data;
+
+    if (ERROR_ANY != heater_learning_store(profile_id, &ctx.learning[profile_id]))
+        log_error("Failed to store learning table of profile %u", profile_id);
 }
 
-celcius get_actual_setpoint(heating_mode_descriptor* heating_mode) {
-    return heating_mode->stages[heating_mode->actual_stage].temperature;
+static void finish_learning(heating_mode_descriptor* heating_mode) {
+    if (!heating_mode->learning || !heater_learning_update(heating_mode->learning,
+      heater_calculator_learning_parameters()))
+        return;
+
+    if (!scheduler_enqueue(SchedulerQueueHeaterLearning, &heating_mode->profile_id))
+        log_error("Failed to queue learning table of profile %u for storing", heating_mode->profile_id);
 }
 
 static void turn_off_heater(void* args) {
@@ -135,21 +175,34 @@ static void turn_off_heater(void* args) {
 }
 
 static error_status_t execute_heating_mode(heating_mode_descriptor* heating_mode, miliseconds actual_period_length) {
-    if (ERROR_ANY != spi_read(SpiDeviceThermocoupleAfe, &ctx.last_readout, sizeof(ctx.last_readout))) {
+    thermocouple_sample_t sample;
+    miliseconds age;
+
+    // The window is skipped with the heater off and the profile waits, only a
+    // sensor gone for good ends the request, through its completion as usual
+    if (!thermocouple_sampler_latest(&sample, &age) || age > THERMOCOUPLE_MAX_SAMPLE_AGE_MS) {
         set_toggler_level(false);
+        if (++heating_mode->stale_windows < HEATER_MAX_STALE_WINDOWS)
+            return ERROR_ANY;
+        log_error("No fresh temperature for %u control windows, stopping", heating_mode->stale_windows);
+        stop_ongoing_request(heating_mode);
         return ERROR_COMMUNICATION_ERROR;
     }
+    heating_mode->stale_windows = 0;
     set_actual_stage(heating_mode);
     if (heating_mode->actual_stage == invalid_stage_index) {
+        finish_learning(heating_mode);
         stop_ongoing_request(heating_mode);
         return ERROR_EXECUTION_STOPPED;
     }
-    float percent = get_heating_power_percent((float) ctx.last_readout, get_actual_setpoint(heating_mode));
-    log_debug("time: %u, temperature read: %u, power set to: %f%%, stage: %u",
-      heating_mode->duration, ctx.last_readout, percent, heating_mode->actual_stage);
+    float percent = get_heating_power_percent(temperature_to_float(sample.temperature), &heating_mode->profile,
+        heating_mode->duration, (float) periodic_get_period(heat_controller_tick) / 1000.f);
+    log_debug("time: %u, temperature read: %.2f (%u ms old), power set to: %f%%, stage: %u",
+      heating_mode->duration, temperature_to_float(sample.temperature), age, percent, heating_mode->actual_stage);
+    publish_status(heating_mode, percent);
     set_toggler_level(true);
     heating_mode->duration += miliseconds_to_seconds(actual_period_length);
-    miliseconds turnoff_timeout = percent * actual_period_length;
+    miliseconds turnoff_timeout = percent / 100.f * actual_period_length;
     if (turnoff_timeout)
         oneshot_arm(oneshot_heater_controller, turnoff_timeout, turn_off_heater, NULL);
 
@@ -170,6 +223,16 @@ static void execute_heating_mode_periodic(void* heating_mode) {
         timer_unregister_callback(heat_controller_tick, execute_heating_mode_periodic);
 }
 
+static error_status_t start_heating_mode(heating_mode_descriptor* heating_mode) {
+    miliseconds time      = periodic_get_expire(heat_controller_tick);
+    error_status_t result = ERROR_ANY;
+
+    if (ERROR_ANY != (result = execute_heating_mode(heating_mode, time)))
+        return result;
+
+    return timer_register_callback(heat_controller_tick, execute_heating_mode_periodic, heating_mode);
+}
+
 error_status_t heat_controller_start_multistage_heating_mode(multistage_heating_type type,
   heat_completion_marker                                                             completion_routine) {
     if (type >= MULTISTAGE_HEATING_LAST)
@@ -182,44 +245,23 @@ error_status_t heat_controller_start_multistage_heating_mode(multistage_heating_
     if (ctx.state != HEATING_STATE_IDLE)
         return ERROR_INVALID_STATE;
 
-    static temperature_stage jedec[] = {
-        {
-            .time ={
-                .from = 0,
-                .to   = 100,
-            },
-            .temperature = 100
-        },{
-            .time ={
-                .from = 100,
-                .to   = 140,
-            },
-            .temperature = 250
-        },{
-            .time ={
-                .from = 140,
-                .to   = 230
-            },
-            .temperature = 30
-        }
-    };
-
-    static heating_mode_descriptor multistage_heating_modes[MULTISTAGE_HEATING_LAST] = {
-        { .stages = jedec, .stage_count = COUNT_OF(jedec) }
+    static heating_mode_descriptor multistage_heating_mode;
+    const heating_profile_id profile_map[MULTISTAGE_HEATING_LAST] = {
+        [MULTISTAGE_HEATING_JEDEC] = HEATING_PROFILE_JEDEC
     };
 
-
-    heating_mode_descriptor* selected_heating_mode = &multistage_heating_modes[type];
-    selected_heating_mode->duration = 0;
+    heating_mode_descriptor* selected_heating_mode = &multistage_heating_mode;
+    selected_heating_mode->profile_id   = profile_map[type];
+    selected_heating_mode->profile      = *heating_profile_get(profile_map[type]);
+    selected_heating_mode->actual_stage = 0;
+    selected_heating_mode->duration     = 0;
+    selected_heating_mode->stale_windows = 0;
     selected_heating_mode->completed_routine = completion_routine;
+    selected_heating_mode->learning     = begin_learning(profile_map[type], &selected_heating_mode->profile);
     ctx.state = HEATING_STATE_MULTI_STAGE;
+    heater_calculator_start(selected_heating_mode->profile_id, selected_heating_mode->learning);
 
-    miliseconds time      = periodic_get_expire(heat_controller_tick);
-    error_status_t result = ERROR_ANY;
-    if (ERROR_ANY != (result = execute_heating_mode(selected_heating_mode, time)))
-        return result;
-
-    return timer_register_callback(heat_controller_tick, execute_heating_mode_periodic, selected_heating_mode);
+    return start_heating_mode(selected_heating_mode);
 }
 
 error_status_t heat_controller_start_constant_heating(celcius temperature, unsigned duration,
@@ -231,27 +273,20 @@ error_status_t heat_controller_start_constant_heating(celcius temperature, unsig
     if (ctx.state != HEATING_STATE_IDLE)
         return ERROR_INVALID_STATE;
 
-    static temperature_stage constant = {
-        .time        = {
-            .from = 0,
-            .to   = 0,
-        },
-        .temperature = 0
-    };
-    static heating_mode_descriptor constant_heating_mode = { .stages = &constant, .stage_count = 1 };
+    static temperature_stage constant;
+    static heating_mode_descriptor constant_heating_mode = { .profile_id = HEATING_PROFILE_CONSTANT };
 
-    constant.time.to     = duration;
-    constant.temperature = temperature;
-    constant_heating_mode.duration = 0;
+    constant_heating_mode.profile           = heating_profile_constant(&constant, temperature, duration);
+    constant_heating_mode.actual_stage      = 0;
+    constant_heating_mode.duration          = 0;
+    constant_heating_mode.stale_windows     = 0;
     constant_heating_mode.completed_routine = completion_routine;
 
     ctx.state = HEATING_STATE_CONSTANT;
-    miliseconds time      = periodic_get_expire(heat_controller_tick);
-    error_status_t result = ERROR_ANY;
-    if (ERROR_ANY != (result = execute_heating_mode(&constant_heating_mode, time)))
-        return result;
+    // Setpoint and length change between runs, nothing to learn from
+    heater_calculator_start(HEATING_PROFILE_CONSTANT, NULL);
 
-    return timer_register_callback(heat_controller_tick, execute_heating_mode_periodic, &constant_heating_mode);
+    return start_heating_mode(&constant_heating_mode);
 }
 
 void heat_controller_cancel_action(void) {
@@ -265,5 +300,8 @@ error_status_t heat_controller_init(void) {
     if (ERROR_ANY != (result = setup_toggler_pin()))
         return result;
 
-    return spi_read(SpiDeviceThermocoupleAfe, &ctx.last_readout, sizeof(ctx.last_readout));
+    if (!scheduler_subscribe(SchedulerQueueHeaterLearning, store_learning))
+        return ERROR_COLLECTION_FULL;
+
+    return thermocouple_sampler_start();
 }
@@ -21,7 +21,10 @@
 #ifndef _MAIN_HEAT_CONTROLLER_
 #define _MAIN_HEAT_CONTROLLER_
 
+#include <stdbool.h>
 #include "utilities/error.h"
+#include "utilities/types.h"
+#include "temperature.h"
 
 typedef unsigned celcius;
 
@@ -38,6 +41,15 @@ typedef enum {
     MULTISTAGE_HEATING_LAST
 } multistage_heating_type;
 
+// Progress of the running heating, as of the last control window
+typedef struct {
+    celcius  setpoint;
+    unsigned power;     // percent of the control window the heater is on
+    unsigned stage;
+    seconds  elapsed;
+    seconds  remaining;
+} heat_controller_status_t;
+
 // TODO should have some status passed to input
 typedef void (*heat_completion_marker)(void);
 error_status_t heat_controller_start_multistage_heating_mode(multistage_heating_type type,
@@ -45,7 +57,9 @@ error_status_t heat_controller_start_multistage_heating_mode(multistage_heating_
 error_status_t heat_controller_start_constant_heating(celcius temperature, unsigned duration,
   heat_completion_marker completion_routine);
 error_status_t heat_controller_init(void);
-unsigned heat_controller_get_temperature(void);
+temperature_t heat_controller_get_temperature(void);
+// False while no heating runs, safe to call from any task
+bool heat_controller_get_status(heat_controller_status_t* status);
 void heat_controller_cancel_action(void);
 
 #endif // ifndef _MAIN_HEAT_CONTROLLER_
@@ -61,9 +61,9 @@ static bool is_request_priority_higher_than_proccesed(components_priority incomi
 }
 
 static read_buff_descriptor_t on_ble_read(simplified_uuid_t uuid) {
-    static uint16_t last_readout = 0;
+    static int16_t last_readout = 0;
 
-    last_readout = heat_controller_get_temperature();
+    last_readout = temperature_to_centi(heat_controller_get_temperature());
 
     read_buff_descriptor_t last_readout_descriptor = {
         .buff = &last_readout,
@@ -111,14 +111,14 @@ static multistage_heating_type map_request_to_multistage_type(heating_request_ty
 }
 
 static void unblock_menu_operations(void) {
-    menu_event_type event = MENU_EVENT_PREEMPT_TAKE;
+    menu_event_t event = {.type = MENU_EVENT_PREEMPT_TAKE};
 
     scheduler_enqueue(SchedulerQueueMenu, &event);
     ctx.processed_request = COMPONENT_IDLE_PRIORITY;
 }
 
 static void block_menu_operations(void) {
-    menu_event_type event = MENU_EVENT_PREEMPT_REQUEST;
+    menu_event_t event = {.type = MENU_EVENT_PREEMPT_REQUEST};
 
     scheduler_enqueue(SchedulerQueueMenu, &event);
 }
@@ -199,7 +199,7 @@ static void on_ble_request(simplified_uuid_t uuid, uint8_t* buff, size_t size) {
 } /* on_ble_request */
 
 static void inform_about_job_done(void) {
-    menu_event_type event = MENU_EVENT_REQUEST_DONE;
+    menu_event_t event = {.type = MENU_EVENT_REQUEST_DONE};
 
     scheduler_enqueue(SchedulerQueueMenu, &event);
     ctx.processed_request = COMPONENT_IDLE_PRIORITY;
@@ -209,6 +209,16 @@ static void on_menu_request(void* _request) {
     error_status_t result   = ERROR_ANY;
     heater_request* request = _request;
 
+    // The menu may only cancel what it started, a BLE request keeps running
+    if (request->type == HEATING_REQUEST_CANCEL) {
+        if (ctx.processed_request != COMPONENT_MENU_PRIORITY)
+            return;
+        ctx.request_type = request->type;
+        heat_controller_cancel_action();
+        ble_notify(HEATER_MODE_WRITE_UUID);
+        return;
+    }
+
     if (!is_request_priority_higher_than_proccesed(COMPONENT_MENU_PRIORITY))
         return;
 
@@ -231,10 +241,6 @@ static void on_menu_request(void* _request) {
                 map_request_to_multistage_type(request->type), inform_about_job_done);
             break;
 
-        case HEATING_REQUEST_CANCEL:
-            heat_controller_cancel_action();
-            break;
-
         default:
             break;
     }
@@ -18,12 +18,12 @@
  * specific language governing permissions and limitations
  * under the License.
  */
-#include "FreeRTOS.h"
-#include "task.h"
 #include "heater_calculator.h"
-#include "pid.h"
+#include "heater_definitions.h"
 
-static pid_state_t previous_state = { 0 };
+#include <math.h>
+
+static heater_calculator_t calculator;
 
 static float constrain_output(float output) {
     const float min_power_percent = 5.f;
@@ -32,18 +32,164 @@ static float constrain_output(float output) {
     return output < min_power_percent ? 0.0f : output > max_power_percent ? max_power_percent : output;
 }
 
-float get_heating_power_percent(float actual_temperature, float setpoint) {
-    const pid_params_t parameters = {
-        .kp = 1.0f,
-        .kd = 0,
-        .ki = 0.2f,
+pid_params_t heater_calculator_gains(heating_profile_id profile) {
+    static const pid_params_t gains[HEATING_PROFILE_LAST] = {
+#define PID_GAINS(profile, p, i, d) [profile] = { .kp = p, .ki = i, .kd = d },
+#include "pid_gains.scf"
+#undef PID_GAINS
+    };
+
+    return gains[profile < HEATING_PROFILE_LAST ? profile : HEATING_PROFILE_CONSTANT];
+}
+
+static fopdt_model_t heater_model(void) {
+    return (fopdt_model_t) {
+        .gain          = HEATER_MODEL_GAIN,
+        .time_constant = HEATER_MODEL_TIME_CONSTANT,
+        .dead_time     = HEATER_MODEL_DEAD_TIME,
+        .ambient       = HEATER_MODEL_AMBIENT,
+    };
+}
+
+mpc_params_t heater_calculator_mpc_parameters(void) {
+    return (mpc_params_t) {
+        .model        = heater_model(),
+        .horizon      = HEATER_MPC_HORIZON,
+        .move_penalty = HEATER_MPC_MOVE_PENALTY,
+    };
+}
+
+heater_feedforward_t heater_calculator_feedforward_parameters(void) {
+    return (heater_feedforward_t) {
+        .is_enabled = HEATER_FEEDFORWARD_ENABLED,
+        .model      = heater_model(),
+        .lookahead  = HEATER_FEEDFORWARD_LOOKAHEAD,
     };
+}
 
-    previous_state.actual = actual_temperature;
-    previous_state.target = setpoint;
-    float actual_time = ((float) (xTaskGetTickCount()) / (float) portTICK_PERIOD_MS) / 1000.f;
-    previous_state.time_delta = actual_time - previous_state.time_delta;
+heater_learning_params_t heater_calculator_learning_parameters(void) {
+    return (heater_learning_params_t) { .gain = HEATER_LEARNING_GAIN, .lead = HEATER_LEARNING_LEAD };
+}
+
+void heater_calculator_reset(heater_calculator_t* calculator, pid_params_t parameters) {
+    *calculator = (heater_calculator_t) { .mode = HEATER_CONTROL_PID, .parameters = parameters };
+}
+
+void heater_calculator_reset_mpc(heater_calculator_t* calculator, mpc_params_t parameters) {
+    *calculator = (heater_calculator_t) { .mode = HEATER_CONTROL_MPC, .mpc_parameters = parameters };
+}
+
+static celcius setpoint_at(const heating_profile* profile, seconds time) {
+    celcius setpoint = 0;
+
+    if (!heating_profile_setpoint_at(profile, time, &setpoint) && profile->stage_count > 0)
+        setpoint = profile->stages[profile->stage_count - 1].temperature;
+
+    return setpoint;
+}
+
+void heater_calculator_set_feedforward(heater_calculator_t* calculator, heater_feedforward_t feedforward) {
+    calculator->feedforward = feedforward;
+}
+
+void heater_calculator_set_learning(heater_calculator_t* calculator, heater_learning_t* learning) {
+    calculator->learning = learning;
+}
+
+// Inverse of the first order model over the lookahead: the constant power
+// taking it from the setpoint now to the setpoint lookahead seconds ahead,
+// u = (r(t + H) - r(t) * exp(-H / tau)) / (K * (1 - exp(-H / tau))) above
+// ambient. A step up is prepared over the whole lookahead, so the heater runs
+// saturated for as long as the rise takes. A step down only drops to the
+// holding power once it is reached, an early cooldown would cut the stage
+// before it short.
+float heater_calculator_feedforward(const heater_feedforward_t* feedforward, const heating_profile* profile,
+  seconds time) {
+    const fopdt_model_t* model = &feedforward->model;
+
+    if (!feedforward->is_enabled || model->gain <= 0.f || model->time_constant <= 0.f || feedforward->lookahead <= 0.f)
+        return 0.f;
+
+    const float now   = (float) setpoint_at(profile, time) - model->ambient;
+    const float ahead = (float) setpoint_at(profile, time + (seconds) (feedforward->lookahead + 0.5f))
+      - model->ambient;
+    const float decay = expf(-feedforward->lookahead / model->time_constant);
+    const float reach = (ahead - now * decay) / (1.f - decay);
+
+    return (reach > now ? reach : now) / model->gain;
+}
+
+static float iterate_pid(heater_calculator_t* calculator, float actual_temperature, const heating_profile* profile,
+  seconds time, float period, float correction) {
+    // Nothing to differentiate against before the first window, seeded with its
+    // own error kd doesn't kick on the whole initial error
+    if (calculator->state.time_delta <= 0.f)
+        calculator->state.previous_error = (float) setpoint_at(profile, time) - actual_temperature;
+    calculator->state.actual     = actual_temperature;
+    calculator->state.target     = (float) setpoint_at(profile, time);
+    calculator->state.time_delta = period;
+
+    pid_state_t previous = calculator->state;
+    float feedforward    = heater_calculator_feedforward(&calculator->feedforward, profile, time)
+      + correction;
+
+    calculator->state = pid_iterate(calculator->parameters, calculator->state);
+    float output = calculator->state.output + feedforward;
+    // With feedforward the integral only has to cover model error, so it is
+    // held while the heater saturates instead of winding up during ramps.
+    if (calculator->feedforward.is_enabled && (output > 100.f || output < 0.f))
+        calculator->state.integral = previous.integral;
+    return constrain_output(output);
+}
+
+static float iterate_mpc(heater_calculator_t* calculator, float actual_temperature, const heating_profile* profile,
+  seconds time, float period, float correction) {
+    const unsigned count = calculator->mpc_parameters.horizon + MPC_MAX_DELAY_STEPS;
+    float references[MPC_MAX_REFERENCES];
+    float highest = (float) setpoint_at(profile, time);
+
+    // Rises are predicted, falls only followed once reached, as with the PID
+    // feedforward, so a long horizon doesn't start the cooldown early
+    for (unsigned j = 0; j < count && j < MPC_MAX_REFERENCES; j++) {
+        const float setpoint = (float) setpoint_at(profile, time + (seconds) ((float) (j + 1) * period));
+        highest       = setpoint > highest ? setpoint : highest;
+        references[j] = highest;
+    }
+
+    float output = constrain_output(mpc_iterate(&calculator->mpc_parameters, &calculator->mpc_state,
+        actual_temperature, references, period) + correction);
+    calculator->mpc_state.previous_output = output;
+    return output;
+}
+
+float heater_calculator_iterate(heater_calculator_t* calculator, float actual_temperature,
+  const heating_profile* profile, seconds time, float period) {
+    float correction = 0.f;
+
+    if (calculator->learning) {
+        correction = heater_learning_correction(calculator->learning, time);
+        heater_learning_record(calculator->learning, time, (float) setpoint_at(profile, time) - actual_temperature);
+    }
+
+    switch (calculator->mode) {
+        case HEATER_CONTROL_MPC:
+            return iterate_mpc(calculator, actual_temperature, profile, time, period, correction);
+
+        case HEATER_CONTROL_PID:
+        default:
+            return iterate_pid(calculator, actual_temperature, profile, time, period, correction);
+    }
+}
+
+void heater_calculator_start(heating_profile_id profile, heater_learning_t* learning) {
+    HEATER_CONTROL_MODE == HEATER_CONTROL_MPC ?
+    heater_calculator_reset_mpc(&calculator, heater_calculator_mpc_parameters()) :
+    heater_calculator_reset(&calculator, heater_calculator_gains(profile));
+    heater_calculator_set_feedforward(&calculator, heater_calculator_feedforward_parameters());
+    heater_calculator_set_learning(&calculator, learning);
+}
 
-    previous_state = pid_iterate(parameters, previous_state);
-    return constrain_output(previous_state.output);
+float get_heating_power_percent(float actual_temperature, const heating_profile* profile, seconds time,
+  float period) {
+    return heater_calculator_iterate(&calculator, actual_temperature, profile, time, period);
 }
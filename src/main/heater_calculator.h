@@ -22,6 +22,61 @@
 #ifndef _MAIN_HEAT_CALCULATOR_
 #define _MAIN_HEAT_CALCULATOR_
 
-float get_heating_power_percent(float actual_temperature, float setpoint);
+#include "pid.h"
+#include "heater_mpc.h"
+#include "heater_learning.h"
+#include "heating_profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HEATER_CONTROL_PID,
+    HEATER_CONTROL_MPC,
+    HEATER_CONTROL_LAST
+} heater_control_mode;
+
+// Open loop power inverting the plate model along the profile: the power
+// reaching the setpoint lookahead seconds ahead, at least the holding power
+typedef struct {
+    bool          is_enabled;
+    fopdt_model_t model;
+    float         lookahead; // s, about the time a full power rise between stages takes
+} heater_feedforward_t;
+
+typedef struct {
+    heater_control_mode  mode;
+    pid_params_t         parameters;
+    pid_state_t          state;
+    heater_feedforward_t feedforward;
+    mpc_params_t         mpc_parameters;
+    mpc_state_t          mpc_state;
+    heater_learning_t*   learning; // optional, corrects the output from previous runs of the profile
+} heater_calculator_t;
+
+pid_params_t heater_calculator_gains(heating_profile_id profile);
+mpc_params_t heater_calculator_mpc_parameters(void);
+heater_feedforward_t heater_calculator_feedforward_parameters(void);
+void heater_calculator_reset(heater_calculator_t* calculator, pid_params_t parameters);
+void heater_calculator_reset_mpc(heater_calculator_t* calculator, mpc_params_t parameters);
+// Adds feedforward to the PID output, the MPC already predicts along the profile
+void heater_calculator_set_feedforward(heater_calculator_t* calculator, heater_feedforward_t feedforward);
+float heater_calculator_feedforward(const heater_feedforward_t* feedforward, const heating_profile* profile,
+  seconds time);
+heater_learning_params_t heater_calculator_learning_parameters(void);
+// Applies and records into learning for the run, NULL disables learning
+void heater_calculator_set_learning(heater_calculator_t* calculator, heater_learning_t* learning);
+float heater_calculator_iterate(heater_calculator_t* calculator, float actual_temperature,
+  const heating_profile* profile, seconds time, float period);
+
+// Controller instance used by the heat controller, mode set by HEATER_CONTROL_MODE
+void heater_calculator_start(heating_profile_id profile, heater_learning_t* learning);
+float get_heating_power_percent(float actual_temperature, const heating_profile* profile, seconds time,
+  float period);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
 
 #endif // _MAIN_HEAT_CALCULATOR_
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "heater_learning.h"
+
+#include <string.h>
+
+#define HEATER_LEARNING_VERSION 1U
+#define HEATER_LEARNING_LIMIT   100.f
+
+static seconds bin_width_for(seconds profile_duration) {
+    seconds width = (profile_duration + HEATER_LEARNING_BINS - 1) / HEATER_LEARNING_BINS;
+    return width ? width : 1;
+}
+
+static unsigned bin_of(const heater_learning_t* learning, seconds time) {
+    unsigned bin = time / learning->table.bin_width;
+    return bin < HEATER_LEARNING_BINS ? bin : HEATER_LEARNING_BINS - 1;
+}
+
+void heater_learning_begin(heater_learning_t* learning, seconds profile_duration) {
+    const seconds width = bin_width_for(profile_duration);
+
+    if (learning->table.version != HEATER_LEARNING_VERSION || learning->table.bin_width != width) {
+        memset(&learning->table, 0, sizeof(learning->table));
+        learning->table.version   = HEATER_LEARNING_VERSION;
+        learning->table.bin_width = width;
+    }
+    memset(learning->error_sum, 0, sizeof(learning->error_sum));
+    memset(learning->error_count, 0, sizeof(learning->error_count));
+}
+
+float heater_learning_correction(const heater_learning_t* learning, seconds time) {
+    return learning->table.correction[bin_of(learning, time)];
+}
+
+void heater_learning_record(heater_learning_t* learning, seconds time, float error) {
+    unsigned bin = bin_of(learning, time);
+
+    learning->error_sum[bin] += error;
+    learning->error_count[bin]++;
+}
+
+static float clamp_correction(float correction) {
+    return correction < -HEATER_LEARNING_LIMIT ? -HEATER_LEARNING_LIMIT :
+           correction > HEATER_LEARNING_LIMIT ? HEATER_LEARNING_LIMIT : correction;
+}
+
+// u_next(k) = Q(u(k) + L * e(k + lead)), with Q a [1 2 1] / 4 smoothing filter
+// that keeps the learned table from amplifying sensor noise run over run.
+bool heater_learning_update(heater_learning_t* learning, heater_learning_params_t parameters) {
+    const unsigned lead = (parameters.lead + learning->table.bin_width / 2) / learning->table.bin_width;
+    float learned[HEATER_LEARNING_BINS];
+    bool is_recorded = false;
+
+    for (unsigned bin = 0; bin < HEATER_LEARNING_BINS; bin++) {
+        unsigned source = bin + lead < HEATER_LEARNING_BINS ? bin + lead : HEATER_LEARNING_BINS - 1;
+        float mean_error = learning->error_count[source] ?
+          learning->error_sum[source] / (float) learning->error_count[source] : 0.f;
+
+        is_recorded |= learning->error_count[bin] > 0;
+        learned[bin] = learning->table.correction[bin] + parameters.gain * mean_error;
+    }
+    if (!is_recorded)
+        return false;
+
+    for (unsigned bin = 0; bin < HEATER_LEARNING_BINS; bin++) {
+        float previous = learned[bin > 0 ? bin - 1 : bin];
+        float next     = learned[bin + 1 < HEATER_LEARNING_BINS ? bin + 1 : bin];
+        learning->table.correction[bin] = clamp_correction(0.25f * previous + 0.5f * learned[bin] + 0.25f * next);
+    }
+    learning->table.runs++;
+    memset(learning->error_sum, 0, sizeof(learning->error_sum));
+    memset(learning->error_count, 0, sizeof(learning->error_count));
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_HEATER_LEARNING_
+#define _MAIN_HEATER_LEARNING_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEATER_LEARNING_BINS 64U
+
+// Iterative learning control: the part that survives between runs of the same
+// profile, kept small enough to be stored as a single blob.
+typedef struct {
+    uint16_t version;
+    uint16_t runs;
+    seconds  bin_width;
+    float    correction[HEATER_LEARNING_BINS]; // percent of heater power added in each time bin
+} heater_learning_table_t;
+
+typedef struct {
+    heater_learning_table_t table;
+    float                   error_sum[HEATER_LEARNING_BINS];
+    uint16_t                error_count[HEATER_LEARNING_BINS];
+} heater_learning_t;
+
+typedef struct {
+    float   gain; // percent of power per K of mean bin error
+    seconds lead; // s, shifts the error back in time to compensate the plant delay
+} heater_learning_params_t;
+
+// Keeps a loaded table when it was learned for the same profile length,
+// starts from zero correction otherwise.
+void heater_learning_begin(heater_learning_t* learning, seconds profile_duration);
+float heater_learning_correction(const heater_learning_t* learning, seconds time);
+void heater_learning_record(heater_learning_t* learning, seconds time, float error);
+// To be called after a completed run only, cancelled runs don't teach anything.
+bool heater_learning_update(heater_learning_t* learning, heater_learning_params_t parameters);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_HEATER_LEARNING_
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_INFO
+#include "utilities/logger.h"
+
+#include "heater_learning_storage.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "nvs.h"
+
+static const char* storage_namespace = "heater_ilc";
+
+static void profile_key(heating_profile_id profile, char* key, size_t size) {
+    snprintf(key, size, "profile%u", (unsigned) profile);
+}
+
+error_status_t heater_learning_load(heating_profile_id profile, heater_learning_t* learning) {
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    size_t size = sizeof(learning->table);
+    nvs_handle_t handle;
+
+    memset(&learning->table, 0, sizeof(learning->table));
+    if (ESP_OK != nvs_open(storage_namespace, NVS_READONLY, &handle))
+        return ERROR_UNKNOWN_RESOURCE;
+
+    profile_key(profile, key, sizeof(key));
+    esp_err_t result = nvs_get_blob(handle, key, &learning->table, &size);
+    nvs_close(handle);
+
+    if (ESP_OK != result || size != sizeof(learning->table)) {
+        memset(&learning->table, 0, sizeof(learning->table));
+        return ERROR_UNKNOWN_RESOURCE;
+    }
+    log_info("Loaded learning table of profile %u after %u runs", (unsigned) profile, learning->table.runs);
+    return ERROR_ANY;
+}
+
+error_status_t heater_learning_store(heating_profile_id profile, const heater_learning_t* learning) {
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_handle_t handle;
+
+    if (ESP_OK != nvs_open(storage_namespace, NVS_READWRITE, &handle))
+        return ERROR_LIBRARY_ERROR;
+
+    profile_key(profile, key, sizeof(key));
+    esp_err_t result = nvs_set_blob(handle, key, &learning->table, sizeof(learning->table));
+    result = ESP_OK == result ? nvs_commit(handle) : result;
+    nvs_close(handle);
+
+    return ESP_OK == result ? ERROR_ANY : ERROR_LIBRARY_ERROR;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_HEATER_LEARNING_STORAGE_
+#define _MAIN_HEATER_LEARNING_STORAGE_
+
+#include "utilities/error.h"
+#include "heating_profile.h"
+#include "heater_learning.h"
+
+// Learned correction tables kept in NVS, one blob per profile.
+error_status_t heater_learning_load(heating_profile_id profile, heater_learning_t* learning);
+error_status_t heater_learning_store(heating_profile_id profile, const heater_learning_t* learning);
+
+#endif // _MAIN_HEATER_LEARNING_STORAGE_
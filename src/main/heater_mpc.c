@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "heater_mpc.h"
+
+#include <math.h>
+
+static void advance_model(const fopdt_model_t* model, mpc_state_t* state, float decay) {
+    for (unsigned i = MPC_MAX_DELAY_STEPS; i > 0; i--)
+        state->model_output[i] = state->model_output[i - 1];
+
+    state->model_output[0] = decay * state->model_output[1] + (1.f - decay) * model->gain * state->previous_output;
+}
+
+// Single move over the whole horizon keeps the optimisation closed form: the
+// cost is quadratic in one variable, so the budget is a fixed O(horizon) loop
+// without any iterative solver.
+float mpc_iterate(const mpc_params_t* parameters, mpc_state_t* state, float measured, const float* references,
+  float period) {
+    const fopdt_model_t* model = &parameters->model;
+    const float decay          = expf(-period / model->time_constant);
+    const unsigned horizon     = parameters->horizon < MPC_MAX_HORIZON ? parameters->horizon : MPC_MAX_HORIZON;
+    long delay = lroundf(model->dead_time / period);
+    float rise = measured - model->ambient;
+
+    delay = delay < 0 ? 0 : delay > (long) MPC_MAX_DELAY_STEPS ? (long) MPC_MAX_DELAY_STEPS : delay;
+    if (!state->is_initialized) {
+        for (unsigned i = 0; i <= MPC_MAX_DELAY_STEPS; i++)
+            state->model_output[i] = rise;
+        state->previous_output = 0.f;
+        state->is_initialized  = true;
+    }
+    advance_model(model, state, decay);
+
+    // Output disturbance seen through the dead time, added to every prediction
+    // so gain mismatch doesn't leave a steady state offset. Power applied now
+    // shows up on the sensor only after the dead time, hence references are
+    // compared with the undelayed model shifted by the delay.
+    float bias        = rise - state->model_output[delay];
+    float numerator   = 0.f;
+    float denominator = 0.f;
+    float decay_power = 1.f;
+
+    for (unsigned j = 0; j < horizon; j++) {
+        decay_power *= decay;
+        float free_response = decay_power * state->model_output[0] + bias;
+        float step_response = (1.f - decay_power) * model->gain;
+        numerator   += step_response * (references[j + (unsigned) delay] - model->ambient - free_response);
+        denominator += step_response * step_response;
+    }
+
+    // The move penalty is relative to the tracking term, the sum of squared
+    // step responses, so it means the same whatever horizon and period
+    numerator   += parameters->move_penalty * denominator * state->previous_output;
+    denominator += parameters->move_penalty * denominator;
+
+    float output = denominator > 0.f ? numerator / denominator : 0.f;
+    state->previous_output = output < 0.f ? 0.f : output > 100.f ? 100.f : output;
+    return state->previous_output;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_HEATER_MPC_
+#define _MAIN_HEATER_MPC_
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPC_MAX_HORIZON     24U
+#define MPC_MAX_DELAY_STEPS 8U
+#define MPC_MAX_REFERENCES  (MPC_MAX_HORIZON + MPC_MAX_DELAY_STEPS)
+
+// First order plus dead time approximation of plate, thermocouple and amplifier
+typedef struct {
+    float gain;          // K of steady state rise per percent of heater power
+    float time_constant; // s
+    float dead_time;     // s
+    float ambient;       // degC
+} fopdt_model_t;
+
+typedef struct {
+    fopdt_model_t model;
+    unsigned      horizon;      // control windows predicted ahead, up to MPC_MAX_HORIZON
+    float         move_penalty; // weight of power changes relative to the squared tracking error
+} mpc_params_t;
+
+typedef struct {
+    float model_output[MPC_MAX_DELAY_STEPS + 1]; // undelayed model rise over ambient, newest first
+    float previous_output;                       // power applied during the last window, caller may
+                                                 // overwrite it when the output gets further constrained
+    bool  is_initialized;
+} mpc_state_t;
+
+// references[j] is the setpoint (j + 1) control periods ahead, count must
+// cover parameters->horizon plus the dead time in periods, MPC_MAX_REFERENCES
+// is always enough. Returns heater power in percent, 0..100.
+float mpc_iterate(const mpc_params_t* parameters, mpc_state_t* state, float measured, const float* references,
+  float period);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_HEATER_MPC_
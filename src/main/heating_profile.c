@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "heating_profile.h"
+
+#include <stddef.h>
+#include "utilities/addons.h"
+
+static const temperature_stage jedec[] = {
+    {
+        .time ={
+            .from = 0,
+            .to   = 100,
+        },
+        .temperature = 100
+    },{
+        .time ={
+            .from = 100,
+            .to   = 140,
+        },
+        .temperature = 250
+    },{
+        .time ={
+            .from = 140,
+            .to   = 230
+        },
+        .temperature = 30
+    }
+};
+
+static const heating_profile predefined_profiles[HEATING_PROFILE_LAST] = {
+    [HEATING_PROFILE_JEDEC] = { .stages = jedec, .stage_count = COUNT_OF(jedec) }
+};
+
+const heating_profile* heating_profile_get(heating_profile_id id) {
+    if (id >= HEATING_PROFILE_LAST || predefined_profiles[id].stages == NULL)
+        return NULL;
+
+    return &predefined_profiles[id];
+}
+
+heating_profile heating_profile_constant(temperature_stage* storage, celcius temperature, seconds duration) {
+    storage->time.from   = 0;
+    storage->time.to     = duration;
+    storage->temperature = temperature;
+
+    return (heating_profile) { .stages = storage, .stage_count = 1 };
+}
+
+static bool is_time_in_range(temperature_stage stage, seconds time) {
+    if (stage.time.from <= time && stage.time.to > time)
+        return true;
+
+    return false;
+}
+
+bool heating_profile_stage_at(const heating_profile* profile, seconds time, unsigned* stage) {
+    for (unsigned i = *stage; i < profile->stage_count; i++) {
+        if (is_time_in_range(profile->stages[i], time)) {
+            *stage = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool heating_profile_setpoint_at(const heating_profile* profile, seconds time, celcius* setpoint) {
+    unsigned stage = 0;
+
+    if (!heating_profile_stage_at(profile, time, &stage))
+        return false;
+
+    *setpoint = profile->stages[stage].temperature;
+    return true;
+}
+
+seconds heating_profile_duration(const heating_profile* profile) {
+    seconds duration = 0;
+
+    for (unsigned i = 0; i < profile->stage_count; i++)
+        duration = profile->stages[i].time.to > duration ? profile->stages[i].time.to : duration;
+
+    return duration;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_HEATING_PROFILE_
+#define _MAIN_HEATING_PROFILE_
+
+#include <stdbool.h>
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HEATING_PROFILE_CONSTANT,
+    HEATING_PROFILE_JEDEC,
+    HEATING_PROFILE_LAST
+} heating_profile_id;
+
+typedef struct {
+    struct {
+        seconds from;
+        seconds to;
+    }       time;
+    celcius temperature;
+} temperature_stage;
+
+typedef struct {
+    const temperature_stage* stages;
+    unsigned                 stage_count;
+} heating_profile;
+
+// Predefined multistage profiles, constant heating is built at runtime.
+const heating_profile* heating_profile_get(heating_profile_id id);
+heating_profile heating_profile_constant(temperature_stage* storage, celcius temperature, seconds duration);
+
+bool heating_profile_stage_at(const heating_profile* profile, seconds time, unsigned* stage);
+bool heating_profile_setpoint_at(const heating_profile* profile, seconds time, celcius* setpoint);
+seconds heating_profile_duration(const heating_profile* profile);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_HEATING_PROFILE_
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "input_storm.h"
+
+// Input handling runs either on edge interrupts or on polls, never on both, so
+// the busier of the two bounds its share of the CPU.
+_Static_assert(1000000U / INPUT_STORM_EDGE_COST_US * INPUT_HANDLER_COST_US / 1000U <= INPUT_MAX_LOAD_PERMILLE,
+               "edge interrupts can exceed INPUT_MAX_LOAD_PERMILLE");
+_Static_assert(1000000U / INPUT_POLL_PERIOD_US * INPUT_HANDLER_COST_US / 1000U <= INPUT_MAX_LOAD_PERMILLE,
+               "polling exceeds INPUT_MAX_LOAD_PERMILLE");
+_Static_assert(INPUT_POLL_PERIOD_US < INPUT_BUTTON_DEBOUNCE_MS * 1000U, "polling would miss push button bounce");
+
+void input_storm_init(input_storm_t* storm, uint8_t levels) {
+    memset(storm, 0, sizeof(*storm));
+    storm->credit = INPUT_STORM_WINDOW_US;
+    storm->levels = levels;
+    storm->raw    = levels;
+}
+
+void input_storm_begin_polling(input_storm_t* storm, microseconds now, uint8_t levels, bool is_storm) {
+    is_storm ? storm->stats.storms++ : storm->stats.debounces++;
+    storm->is_polling    = true;
+    storm->polling_since = now;
+    storm->raw           = levels;
+    storm->quiet_polls   = 0;
+}
+
+bool input_storm_poll(input_storm_t* storm, microseconds now, uint8_t raw, uint8_t* levels) {
+    storm->stats.polls++;
+    storm->quiet_polls = raw == storm->raw ? storm->quiet_polls + 1 : 0;
+    storm->raw         = raw;
+
+    // All raw, the quadrature decoder rejects rotation bounce and the gesture
+    // recognizer debounces the push button
+    storm->levels = raw;
+    *levels       = raw;
+
+    if (storm->quiet_polls < INPUT_SETTLE_POLLS)
+        return true;
+
+    const microseconds polled = now - storm->polling_since;
+    storm->stats.polling_time += polled;
+    storm->stats.longest_poll  = polled > storm->stats.longest_poll ? polled : storm->stats.longest_poll;
+    storm->is_polling          = false;
+    // The budget refills from the moment interrupts are back
+    storm->credit              = INPUT_STORM_WINDOW_US;
+    storm->last_edge           = now;
+    return false;
+}
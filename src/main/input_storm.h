@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_INPUT_STORM_
+#define _MAIN_INPUT_STORM_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "input_definitions.h"
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INPUT_STORM_EDGE_COST_US (INPUT_STORM_WINDOW_US / INPUT_STORM_EDGES)
+
+typedef struct input_storm_stats {
+    unsigned     edges;          // edge interrupts taken
+    unsigned     storms;         // interrupts masked for running out of budget
+    unsigned     debounces;      // interrupts masked for push button edges
+    unsigned     polls;
+    microseconds polling_time;   // total, including the settling polls
+    microseconds longest_poll;   // longest stretch of polling
+    microseconds slowest_edge;   // longest edge interrupt, against INPUT_HANDLER_COST_US
+} input_storm_stats_t;
+
+// Edge interrupts and polling never run at the same time: the edge side masks
+// itself before polling starts and the poll side unmasks only once it stopped.
+typedef struct {
+    // edge interrupt side
+    microseconds        credit;
+    microseconds        last_edge;
+    // poll side
+    bool                is_polling;
+    microseconds        polling_since;
+    uint8_t             raw;          // levels of the previous poll
+    uint8_t             levels;       // levels handed on
+    unsigned            quiet_polls;
+    input_storm_stats_t stats;
+} input_storm_t;
+
+void input_storm_init(input_storm_t* storm, uint8_t levels);
+
+// Edge interrupt, always inlined into the IRAM handler. False once the budget
+// is spent, the caller masks the pins and asks for polling then.
+__attribute__((always_inline))
+static inline bool input_storm_admit(input_storm_t* storm, microseconds now) {
+    const microseconds elapsed = now - storm->last_edge;
+
+    storm->credit    = elapsed >= INPUT_STORM_WINDOW_US - storm->credit ? INPUT_STORM_WINDOW_US
+                                                                        : storm->credit + elapsed;
+    storm->last_edge = now;
+    storm->stats.edges++;
+    if (storm->credit < INPUT_STORM_EDGE_COST_US)
+        return false;
+    storm->credit -= INPUT_STORM_EDGE_COST_US;
+    return true;
+}
+
+__attribute__((always_inline))
+static inline void input_storm_account_edge(input_storm_t* storm, microseconds took) {
+    storm->stats.slowest_edge = took > storm->stats.slowest_edge ? took : storm->stats.slowest_edge;
+}
+
+// Storms and push button edges both hand over to polling, levels as of the handover
+void input_storm_begin_polling(input_storm_t* storm, microseconds now, uint8_t levels, bool is_storm);
+// One poll of the raw pin levels, handed on as they are. Returns false when the
+// lines settled and the interrupts can be unmasked.
+bool input_storm_poll(input_storm_t* storm, microseconds now, uint8_t raw, uint8_t* levels);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_INPUT_STORM_
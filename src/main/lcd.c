@@ -22,15 +22,21 @@
 #include "lcd.h"
 #include <rom/ets_sys.h>
 #include <driver/gpio.h>
-#include <stdarg.h>
+#include <driver/i2c.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
 #include <string.h>
 #include "FreeRTOS.h"
+#include "task.h"
 #include "timers.h"
 
 #include "lcd1602/lcd1602.h"
+#include "lcd_framebuffer.h"
+#include "lcd_glyphs.h"
 #include "utilities/timer.h"
 #include "utilities/addons.h"
 #include "utilities/scheduler.h"
+#include "lcd_definitions.h"
 
 #define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_INFO
 #include "utilities/logger.h"
@@ -41,6 +47,21 @@
 #define LCD_D7_LINE 2U
 #define LCD_ENABLE_LINE 4UL
 #define LCD_RS_LINE 1UL
+#define LCD_PCF8574_PORT I2C_NUM_0
+#define LCD_BUS_MASK (BIT(LCD_D4_LINE) | BIT(LCD_D5_LINE) | BIT(LCD_D6_LINE) | BIT(LCD_D7_LINE) | BIT(LCD_RS_LINE))
+
+// Below the scheduler task, waiting out the controller never delays a queue
+#define LCD_TASK_PRIORITY   tskIDLE_PRIORITY
+#define LCD_TASK_STACK_SIZE 2048U
+
+// Screens are copied into shadow by the scheduler task, the LCD task diffs it
+// against displayed, which only it touches along with glyphs, once the bus is idle.
+static struct {
+    TaskHandle_t      task;
+    lcd_framebuffer_t shadow;
+    lcd_framebuffer_t displayed;
+    lcd_glyph_cache_t glyphs;
+} ctx;
 
 static void lcd_delay(microseconds microsec) {
     miliseconds milisec = microseconds_to_miliseconds(microsec);
@@ -51,7 +72,25 @@ static void lcd_delay(microseconds microsec) {
     vTaskDelay(pdMS_TO_TICKS(milisec));
 }
 
-static void lcd_gpio_init(void) {
+bool lcd_pin_set(pin_t gpio_num, bool level) {
+    return ESP_OK == gpio_set_level(gpio_num, (uint32_t)level);
+}
+
+// Every bus line is below GPIO 32, so a nibble and RS take one write to the set
+// register and one to the clear register instead of five gpio_set_level() calls.
+static bool lcd_bus_write(uint8_t nibble, bool rs) {
+    uint32_t high = (nibble & 0x1 ? BIT(LCD_D4_LINE) : 0) |
+                    (nibble & 0x2 ? BIT(LCD_D5_LINE) : 0) |
+                    (nibble & 0x4 ? BIT(LCD_D6_LINE) : 0) |
+                    (nibble & 0x8 ? BIT(LCD_D7_LINE) : 0) |
+                    (rs ? BIT(LCD_RS_LINE) : 0);
+
+    REG_WRITE(GPIO_OUT_W1TS_REG, high);
+    REG_WRITE(GPIO_OUT_W1TC_REG, LCD_BUS_MASK & ~high);
+    return true;
+}
+
+static lcd1602_interface lcd_gpio_init(void) {
     uint64_t pin_mask = ((1ULL << LCD_D4_LINE)  |
                          (1ULL << LCD_D5_LINE)  |
                          (1ULL << LCD_D6_LINE)  |
@@ -67,149 +106,126 @@ static void lcd_gpio_init(void) {
         .pin_bit_mask = pin_mask
     };
     gpio_config(&io_conf);
+    return (lcd1602_interface) {
+        .wait = lcd_delay,
+        .pins = {
+            .d4 = LCD_D4_LINE,
+            .d5 = LCD_D5_LINE,
+            .d6 = LCD_D6_LINE,
+            .d7 = LCD_D7_LINE,
+            .rs = LCD_RS_LINE,
+            .enable = LCD_ENABLE_LINE
+        },
+        .pin_set = lcd_pin_set,
+        .bus_write = lcd_bus_write
+    };
 }
 
-bool lcd_pin_set(pin_t gpio_num, bool level) {
-    return ESP_OK == gpio_set_level(gpio_num, (uint32_t)level);
+// lcd1602.c packs runs of steps into one write, a transaction per screen
+// update instead of one per pin change.
+static bool lcd_port_write(const uint8_t* states, unsigned count) {
+    return ESP_OK == i2c_master_write_to_device(LCD_PCF8574_PORT, LCD_PCF8574_ADDRESS, states, count,
+                                                pdMS_TO_TICKS(LCD_PCF8574_TIMEOUT));
 }
 
-error_status_t lcd_send_request_custom(unsigned line, unsigned position, custom_symbol symbol) {
-    lcd_request request = {
-        .commanand = lcd_command_print_symbol,
-        .position = position,
-        .line = line,
-        .symbol = symbol
+static lcd1602_interface lcd_pcf8574_init(void) {
+    i2c_config_t config = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = LCD_PCF8574_SDA,
+        .scl_io_num = LCD_PCF8574_SCL,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = LCD_PCF8574_CLOCK_HZ,
     };
-
-    if (!scheduler_enqueue(SchedulerQueueLcd, &request))
-        return ERROR_COLLECTION_FULL;
-
-    return ERROR_ANY;
-}
-
-error_status_t lcd_send_request_string(unsigned line, unsigned position, const char* str, ...) {
-    lcd_request request = {
-        .commanand = lcd_command_print_string,
-        .position = position,
-        .line = line,
+    ESP_ERROR_CHECK(i2c_param_config(LCD_PCF8574_PORT, &config));
+    ESP_ERROR_CHECK(i2c_driver_install(LCD_PCF8574_PORT, I2C_MODE_MASTER, 0, 0, 0));
+    return (lcd1602_interface) {
+        .pins = {
+            .d4 = LCD_PCF8574_D4,
+            .d5 = LCD_PCF8574_D5,
+            .d6 = LCD_PCF8574_D6,
+            .d7 = LCD_PCF8574_D7,
+            .rs = LCD_PCF8574_RS,
+            .enable = LCD_PCF8574_ENABLE
+        },
+        .port = {
+            .write = lcd_port_write,
+            .hold = 1 << LCD_PCF8574_BACKLIGHT,
+            // Eight bits and the acknowledge
+            .byte_time = 9 * 1000000U / LCD_PCF8574_CLOCK_HZ
+        }
     };
-
-    va_list args;
-    va_start(args, str);
-    int result = vsnprintf(request.text, LCD_MAX_LINE_LEN, str, args);
-    va_end(args);
-    
-    if (result >= LCD_MAX_LINE_LEN || result < 0)
-        return ERROR_RESOURCE_UNAVAILABLE;
-
-    if (!scheduler_enqueue(SchedulerQueueLcd, &request))
-        return ERROR_COLLECTION_FULL;
-
-    return ERROR_ANY;
 }
 
-error_status_t lcd_send_clean(void) {
+error_status_t lcd_submit_screen(const lcd_screen* screen) {
     lcd_request request = {
-        .commanand = lcd_command_clean
+        .screen = *screen
     };
 
     if (!scheduler_enqueue(SchedulerQueueLcd, &request))
         return ERROR_COLLECTION_FULL;
 
     return ERROR_ANY;
-
 }
 
-static void print_screen(lcd_request* request) {
-    switch(request->commanand) {
-        case lcd_command_clean:
-            lcd16x2_clear();
-            break;
-
-        case lcd_command_print_symbol:
-            lcd16x2_setCursor(request->line, request->position);
-            lcd16x2_writeCustom(request->symbol);
-            break;
+static bool lcd_set_cursor(uint8_t row, uint8_t column) {
+    return lcd16x2_setCursor(row, column);
+}
 
-        case lcd_command_print_string:
-            lcd16x2_setCursor(request->line, request->position);
-            lcd16x2_printf("%s", request->text);
-            break;
+static bool flush_framebuffer(void) {
+    static const lcd_framebuffer_output_t output = {
+        .set_cursor = lcd_set_cursor,
+        .put        = lcd16x2_putChar,
+        .clear      = lcd16x2_clear,
+        .clear_cost = LCD_CLEAR_COST,
+    };
+    lcd_framebuffer_t shadow;
+
+    vTaskSuspendAll();
+    shadow = ctx.shadow;
+    xTaskResumeAll();
+    // Uploads leave the address counter in CGRAM, fine as every flushed row
+    // starts with a cursor move. The queue is empty by now, a failed upload is
+    // only retried once the queued steps ran.
+    if (!lcd_glyph_resolve(&ctx.glyphs, &shadow, &ctx.displayed, lcd16x2_createChar))
+        return true;
+    return 0 != lcd_framebuffer_flush(&ctx.displayed, &shadow, &output);
+}
 
-        default:
-            break;
+// Runs the queued steps, sleeping on pauses longer than a tick and busy waiting
+// on the shorter ones, which only idle time pays for at this priority.
+static void lcd_task(void* args) {
+    while (true) {
+        uint32_t execution_time = lcd16x2_runStep();
+        if (LCD1602_IDLE != execution_time) {
+            lcd_delay(execution_time);
+            continue;
+        }
+        if (!flush_framebuffer())
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
+// Screens replace the shadow whole, the LCD task snapshots it with the
+// scheduler suspended, so it never sees half of one.
 static void on_lcd_request(void* data) {
-    lcd_request* lcd_req = data;
-    print_screen(lcd_req);
+    lcd_request* request = data;
+
+    ctx.shadow = request->screen;
+    xTaskNotifyGive(ctx.task);
 }
 
 error_status_t ldc_init(void) {
-    lcd_gpio_init();
-    lcd1602_interface iface = {
-        .wait = lcd_delay,
-        .pins = {
-            .d4 = LCD_D4_LINE,
-            .d5 = LCD_D5_LINE,
-            .d6 = LCD_D6_LINE,
-            .d7 = LCD_D7_LINE,
-            .rs = LCD_RS_LINE,
-            .enable = LCD_ENABLE_LINE
-        },
-        .pin_set = lcd_pin_set 
-    };
-    lcd16x2_init_4bits(iface);
-    uint8_t heart[] = {
-        0b00000,
-        0b01010,
-        0b11111,
-        0b11111,
-        0b01110,
-        0b00100,
-        0b00000,
-        0b00000
-    };
-    uint8_t plate_program[] = {
-        0b00000,
-        0b01110,
-        0b01010,
-        0b01110,
-        0b01000,
-        0b01000,
-        0b00000,
-        0b11111
-    };
-    uint8_t arrow_up[] = {
-        0b00000,
-        0b00100,
-        0b01110,
-        0b11111,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00000
-    };
-
-    uint8_t arrow_down[] = {
-      0b00000,
-      0b00100,
-      0b00100,
-      0b00100,
-      0b11111,
-      0b01110,
-      0b00100,
-      0b00000
-    };
-
-    if (false == (lcd16x2_createChar(kCustomSymbolHeart, heart)
-        && lcd16x2_createChar(kCustomSymbolPlateProgram, plate_program)
-        && lcd16x2_createChar(kCustomSymbolArrowUp, arrow_up)
-        && lcd16x2_createChar(kCustomSymbolArrowDown, arrow_down)))
-        return ERROR_UNKNOWN_RESOURCE;
-
+    lcd16x2_init_4bits(LCD_TRANSPORT == LCD_TRANSPORT_PCF8574 ? lcd_pcf8574_init() : lcd_gpio_init());
     lcd16x2_cursorShow(false);
+    lcd_framebuffer_clear(&ctx.shadow);
+    lcd_framebuffer_clear(&ctx.displayed);
+    lcd_glyph_cache_init(&ctx.glyphs);
+
+    static StaticTask_t task_buffer;
+    static StackType_t task_stack[LCD_TASK_STACK_SIZE];
+    ctx.task = xTaskCreateStatic(lcd_task, "lcd", LCD_TASK_STACK_SIZE, NULL, LCD_TASK_PRIORITY,
+                                 task_stack, &task_buffer);
 
     if (!scheduler_subscribe(SchedulerQueueLcd, on_lcd_request))
         return ERROR_COLLECTION_FULL;
@@ -27,43 +27,30 @@ extern "C" {
 #endif
 
 #include "utilities/error.h"
+#include "lcd_framebuffer.h"
+#include "lcd_glyphs.h"
 
-#define LCD_MAX_LINE_LEN 16U
-#define LCD_MAX_LINE_NUMBER 2U
+#define LCD_MAX_LINE_LEN LCD_FRAMEBUFFER_COLUMNS
+#define LCD_MAX_LINE_NUMBER LCD_FRAMEBUFFER_ROWS
 
+// Cell codes of the icons, loaded into CGRAM when a screen shows them
 typedef enum {
-    kCustomSymbolHeart,
-    kCustomSymbolPlateProgram,
-    kCustomSymbolArrowUp,    
-    kCustomSymbolArrowDown,    
-    kCustomSymbolLast
+    kCustomSymbolHeart        = LCD_GLYPH_HEART,
+    kCustomSymbolPlateProgram = LCD_GLYPH_PLATE_PROGRAM,
+    kCustomSymbolArrowUp      = LCD_GLYPH_ARROW_UP,
+    kCustomSymbolArrowDown    = LCD_GLYPH_ARROW_DOWN,
 } custom_symbol;
 
+// Complete display content, composed with the lcd_framebuffer_* functions
+typedef lcd_framebuffer_t lcd_screen;
+
+// One queue item per screen, it replaces the displayed one as a whole
 typedef struct {
-    enum {
-        lcd_command_print_symbol,
-        lcd_command_print_string,
-        lcd_command_clean
-    } commanand;
-    unsigned line;
-    unsigned position;
-    union {
-        char text[LCD_MAX_LINE_LEN];
-        custom_symbol symbol;
-    };
+    lcd_screen screen;
 } lcd_request;
 
 error_status_t ldc_init(void);
-error_status_t lcd_send_clean(void);
-
-error_status_t lcd_send_request_custom(unsigned line, unsigned position, custom_symbol symbol);
-error_status_t lcd_send_request_string(unsigned line, unsigned position, const char* str, ...);
-#define lcd_send_request(line, position, arg, ...) \
-    _Generic((arg), \
-        custom_symbol: lcd_send_request_custom, \
-        const char*: lcd_send_request_string, \
-        char*: lcd_send_request_string \
-    )(line, position, arg, ##__VA_ARGS__)
+error_status_t lcd_submit_screen(const lcd_screen* screen);
 
 #ifdef __cplusplus
 }
@@ -22,15 +22,12 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 
 #include "lcd1602.h"
 
 static lcd1602_interface interface;
 
-//Milisecond function
-#define LCD_MS_DELAY(X) interface.wait((X) * 1000)
-
-/* List of COMMANDS */
 #define LCD_CLEARDISPLAY      0x01
 #define LCD_RETURNHOME        0x02
 #define LCD_ENTRYMODESET      0x04
@@ -53,87 +50,242 @@ static lcd1602_interface interface;
 #define LCD_MOVERIGHT        0x04
 #define LCD_MOVELEFT         0x00
 
-/* LCD Library Variables */
+#define LCD_POWER_ON_US        50000U
+#define LCD_ENABLE_PULSE_US    1U
+
+typedef enum {
+    lcd_step_command,
+    lcd_step_data,
+    lcd_step_nibble, // high nibble only, 8 bit interface commands of the init sequence
+    lcd_step_pause
+} lcd_step_kind;
+
+typedef struct {
+    uint8_t  kind;
+    uint8_t  value;
+    uint16_t execution_time;
+} lcd_step;
+
+_Static_assert((LCD1602_QUEUE_LENGTH & (LCD1602_QUEUE_LENGTH - 1)) == 0, "Queue length has to be a power of two");
+
+// Single producer, single consumer: head is only written by the queueing task,
+// tail by the task running the steps.
+static struct {
+    lcd_step    steps[LCD1602_QUEUE_LENGTH];
+    atomic_uint head;
+    atomic_uint tail;
+} queue;
+
 static uint8_t DisplayControl = 0x0F;
-static uint8_t FunctionSet = 0x00;
+// Last state written through the port, all high as the PCF8574 powers up
+static uint8_t port_state = 0xFF;
+
+unsigned lcd16x2_queueSpace(void) {
+    unsigned head = atomic_load_explicit(&queue.head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue.tail, memory_order_acquire);
+    return LCD1602_QUEUE_LENGTH - (head - tail);
+}
+
+static void lcd16x2_push(lcd_step_kind kind, uint8_t value, uint16_t execution_time) {
+    unsigned head = atomic_load_explicit(&queue.head, memory_order_relaxed);
+    queue.steps[head & (LCD1602_QUEUE_LENGTH - 1)] = (lcd_step) {
+        .kind = kind,
+        .value = value,
+        .execution_time = execution_time
+    };
+    atomic_store_explicit(&queue.head, head + 1, memory_order_release);
+}
+
+static uint16_t lcd16x2_executionTime(uint8_t cmd) {
+    return cmd == LCD_CLEARDISPLAY || cmd == LCD_RETURNHOME ? LCD1602_LONG_EXECUTION_US : LCD1602_EXECUTION_US;
+}
+
+static void lcd16x2_writeCommand(uint8_t cmd) {
+    lcd16x2_push(lcd_step_command, cmd, lcd16x2_executionTime(cmd));
+}
+
+static void lcd16x2_writeData(uint8_t data) {
+    lcd16x2_push(lcd_step_data, data, LCD1602_EXECUTION_US);
+}
+
+static bool lcd16x2_queueCommand(uint8_t cmd) {
+    if (lcd16x2_queueSpace() < 1)
+        return false;
+    lcd16x2_writeCommand(cmd);
+    return true;
+}
 
 static void lcd16x2_enablePulse(void) {
     interface.pin_set(interface.pins.enable, true);
-    interface.wait(20); 
+    interface.wait(LCD_ENABLE_PULSE_US);
     interface.pin_set(interface.pins.enable, false);
-    interface.wait(50);
+    interface.wait(LCD_ENABLE_PULSE_US);
 }
 
-static void lcd16x2_rs(bool state) {
-    interface.pin_set(interface.pins.rs, state);
+// Pin by pin RS is set once per transfer, the bus hook writes it with every nibble
+static void lcd16x2_select(bool rs) {
+    if (!interface.bus_write)
+        interface.pin_set(interface.pins.rs, rs);
 }
 
-static void lcd16x2_write(uint8_t wbyte) {
-    uint8_t LSB_nibble = wbyte&0xF, MSB_nibble = (wbyte>>4)&0xF;
-    //MSB data
-    interface.pin_set(interface.pins.d4, (bool)(MSB_nibble&0x1));
-    interface.pin_set(interface.pins.d5, (bool)(MSB_nibble&0x2));
-    interface.pin_set(interface.pins.d6, (bool)(MSB_nibble&0x4));
-    interface.pin_set(interface.pins.d7, (bool)(MSB_nibble&0x8));
-    lcd16x2_enablePulse();
-    //LSB data
-    interface.pin_set(interface.pins.d4, (bool)(LSB_nibble&0x1));
-    interface.pin_set(interface.pins.d5, (bool)(LSB_nibble&0x2));
-    interface.pin_set(interface.pins.d6, (bool)(LSB_nibble&0x4));
-    interface.pin_set(interface.pins.d7, (bool)(LSB_nibble&0x8));
+static void lcd16x2_write4(uint8_t nib, bool rs) {
+    if (interface.bus_write) {
+        interface.bus_write(nib, rs);
+    } else {
+        interface.pin_set(interface.pins.d4, (bool)(nib&0x1));
+        interface.pin_set(interface.pins.d5, (bool)(nib&0x2));
+        interface.pin_set(interface.pins.d6, (bool)(nib&0x4));
+        interface.pin_set(interface.pins.d7, (bool)(nib&0x8));
+    }
     lcd16x2_enablePulse();
 }
 
-static void lcd16x2_writeCommand(uint8_t cmd) {
-    lcd16x2_rs(false);
-    lcd16x2_write(cmd);
+static bool lcd16x2_peek(lcd_step* step) {
+    unsigned tail = atomic_load_explicit(&queue.tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&queue.head, memory_order_acquire))
+        return false;
+    *step = queue.steps[tail & (LCD1602_QUEUE_LENGTH - 1)];
+    return true;
 }
 
-static void lcd16x2_writeData(uint8_t data) {
-    lcd16x2_rs(true);
-    lcd16x2_write(data);
+static void lcd16x2_drop(void) {
+    unsigned tail = atomic_load_explicit(&queue.tail, memory_order_relaxed);
+    atomic_store_explicit(&queue.tail, tail + 1, memory_order_release);
+}
+
+// RS has to settle before enable rises, so a change of it takes a state of its
+// own, the data lines only have to be valid when enable falls.
+static unsigned lcd16x2_portNibble(uint8_t* states, unsigned count, uint8_t nib, bool rs) {
+    const pinset* pins = &interface.pins;
+    uint8_t state = interface.port.hold | (uint8_t)(rs << pins->rs) |
+                    (uint8_t)(((nib >> 0) & 1) << pins->d4) | (uint8_t)(((nib >> 1) & 1) << pins->d5) |
+                    (uint8_t)(((nib >> 2) & 1) << pins->d6) | (uint8_t)(((nib >> 3) & 1) << pins->d7);
+
+    if ((state ^ port_state) & (1 << pins->rs))
+        states[count++] = state;
+    states[count++] = state | (uint8_t)(1 << pins->enable);
+    states[count++] = state;
+    port_state = state;
+    return count;
 }
 
-void lcd16x2_writeCustom(uint8_t location) {
-     location &= 0x7; // we only have 8 locations 0-7
-     lcd16x2_writeData(location);
+// Room a step needs at most, a change of RS included
+static unsigned lcd16x2_portStates(const lcd_step* step) {
+    return step->kind == lcd_step_pause ? 0 : step->kind == lcd_step_nibble ? 3 : 5;
 }
 
-static void lcd16x2_write4(uint8_t nib) {
-    nib &= 0xF;
-    lcd16x2_rs(false);
-    //LSB data
-    interface.pin_set(interface.pins.d4, (bool)(nib&0x1));
-    interface.pin_set(interface.pins.d5, (bool)(nib&0x2));
-    interface.pin_set(interface.pins.d6, (bool)(nib&0x4));
-    interface.pin_set(interface.pins.d7, (bool)(nib&0x8));
-    lcd16x2_enablePulse();
+// Repeats of the idle state holding off the next enable pulse, the state that
+// raises it takes one byte time by itself.
+static unsigned lcd16x2_portPadding(uint32_t execution_time) {
+    unsigned byte_time = interface.port.byte_time;
+    return execution_time > byte_time ? (execution_time + byte_time - 1) / byte_time - 1 : 0;
+}
+
+static uint32_t lcd16x2_runPortSteps(void) {
+    uint8_t states[LCD1602_PORT_BATCH];
+    unsigned count = 0;
+    uint32_t execution_time = LCD1602_IDLE;
+    lcd_step step;
+
+    while (lcd16x2_peek(&step)) {
+        if (count && (step.kind == lcd_step_pause || execution_time > LCD1602_EXECUTION_US))
+            break;
+        unsigned padding = count ? lcd16x2_portPadding(execution_time) : 0;
+        if (count + padding + lcd16x2_portStates(&step) > LCD1602_PORT_BATCH)
+            break;
+        lcd16x2_drop();
+
+        for (; padding > 0; padding--, count++)
+            states[count] = states[count - 1];
+        bool rs = step.kind == lcd_step_data;
+        switch (step.kind) {
+            case lcd_step_command:
+            case lcd_step_data:
+                count = lcd16x2_portNibble(states, count, step.value >> 4, rs);
+                count = lcd16x2_portNibble(states, count, step.value & 0xF, rs);
+                break;
+
+            case lcd_step_nibble:
+                count = lcd16x2_portNibble(states, count, step.value & 0xF, false);
+                break;
+
+            default:
+                break;
+        }
+        execution_time = step.execution_time;
+        if (step.kind == lcd_step_pause)
+            break;
+    }
+    if (count > 0)
+        interface.port.write(states, count);
+    return execution_time;
+}
+
+uint32_t lcd16x2_runStep(void) {
+    lcd_step step;
+
+    if (interface.port.write)
+        return lcd16x2_runPortSteps();
+    if (!lcd16x2_peek(&step))
+        return LCD1602_IDLE;
+    lcd16x2_drop();
+
+    bool rs = step.kind == lcd_step_data;
+    switch (step.kind) {
+        case lcd_step_command:
+        case lcd_step_data:
+            lcd16x2_select(rs);
+            lcd16x2_write4(step.value >> 4, rs);
+            lcd16x2_write4(step.value & 0xF, rs);
+            break;
+
+        case lcd_step_nibble:
+            lcd16x2_select(false);
+            lcd16x2_write4(step.value & 0xF, false);
+            break;
+
+        default:
+            break;
+    }
+    return step.execution_time;
+}
+
+bool lcd16x2_writeCustom(uint8_t location) {
+    if (lcd16x2_queueSpace() < 1)
+        return false;
+    location &= 0x7; // we only have 8 locations 0-7
+    lcd16x2_writeData(location);
+    return true;
+}
+
+bool lcd16x2_putChar(uint8_t code) {
+    if (lcd16x2_queueSpace() < 1)
+        return false;
+    lcd16x2_writeData(code);
+    return true;
 }
 
 void lcd16x2_init_4bits(lcd1602_interface iface) {
     interface = iface;
-    LCD_MS_DELAY(50);
-    //Set GPIO Ports and Pins data
-    FunctionSet = 0x28; //FUNCTIONSET & DISPLAYCONTROL??
-    lcd16x2_write4(0x3);
-    LCD_MS_DELAY(5);
-    lcd16x2_write4(0x3);
-    LCD_MS_DELAY(1);
-    lcd16x2_write4(0x3);
-    LCD_MS_DELAY(1);
-    lcd16x2_write4(0x2);  //4 bit mode
-    LCD_MS_DELAY(1);
+    port_state = 0xFF;
+    atomic_store(&queue.head, 0);
+    atomic_store(&queue.tail, 0);
+    lcd16x2_push(lcd_step_pause, 0, LCD_POWER_ON_US);
+    //Function set to 8 bits three times, then to 4 bits
+    lcd16x2_push(lcd_step_nibble, 0x3, 4100);
+    lcd16x2_push(lcd_step_nibble, 0x3, 100);
+    lcd16x2_push(lcd_step_nibble, 0x3, LCD1602_EXECUTION_US);
+    lcd16x2_push(lcd_step_nibble, 0x2, LCD1602_EXECUTION_US);
     //4. Function set; Enable 2 lines, Data length to 4 bits
     lcd16x2_writeCommand(LCD_FUNCTIONSET | LCD_2LINES);
     //3. Display control (Display ON, Cursor ON, blink cursor)
     lcd16x2_writeCommand(LCD_DISPLAYCONTROL | LCD_DISPLAY_B | LCD_DISPLAY_C | LCD_DISPLAY_D);
     //4. Clear LCD and return home
     lcd16x2_writeCommand(LCD_CLEARDISPLAY);
-    LCD_MS_DELAY(3);
 }
 
-bool lcd16x2_createChar(uint8_t location, uint8_t charmap[]) {
-    if (location > 7)
+bool lcd16x2_createChar(uint8_t location, const uint8_t charmap[]) {
+    if (location > 7 || lcd16x2_queueSpace() < 9)
         return false;
     location &= 0x7; // we only have 8 locations 0-7
     lcd16x2_writeCommand(LCD_SETCGRAMADDR | (location << 3));
@@ -143,78 +295,73 @@ bool lcd16x2_createChar(uint8_t location, uint8_t charmap[]) {
     return true;
 }
 
-void lcd16x2_setCursor(uint8_t row, uint8_t col) {
-  uint8_t maskData;
-  maskData = col & 0x0F;
-  if(row == 0) {
-    maskData |= (0x80);
-    lcd16x2_writeCommand(maskData);
-  } else {
-    maskData |= (0xc0);
-    lcd16x2_writeCommand(maskData);
-  }
+bool lcd16x2_setCursor(uint8_t row, uint8_t col) {
+    return lcd16x2_queueCommand((row == 0 ? LCD_SETDDRAMADDR : 0xc0) | (col & 0x0F));
 }
 
-void lcd16x2_1stLine(void) {
-    lcd16x2_setCursor(0,0);
+bool lcd16x2_1stLine(void) {
+    return lcd16x2_setCursor(0,0);
 }
 
-void lcd16x2_2ndLine(void) {
-    lcd16x2_setCursor(1,0);
+bool lcd16x2_2ndLine(void) {
+    return lcd16x2_setCursor(1,0);
 }
 
-void lcd16x2_cursorShow(bool state) {
+bool lcd16x2_cursorShow(bool state) {
     if(state) {
         DisplayControl |= (LCD_DISPLAY_B | LCD_DISPLAY_C);
     }
     else {
         DisplayControl &= ~(LCD_DISPLAY_B | LCD_DISPLAY_C);
     }
-    lcd16x2_writeCommand(DisplayControl);
+    return lcd16x2_queueCommand(DisplayControl);
 }
 
-void lcd16x2_clear(void) {
-    lcd16x2_writeCommand(LCD_CLEARDISPLAY);
-    LCD_MS_DELAY(5);
+bool lcd16x2_clear(void) {
+    return lcd16x2_queueCommand(LCD_CLEARDISPLAY);
 }
 
-void lcd16x2_display(bool state) {
+bool lcd16x2_display(bool state) {
     if(state) {
         DisplayControl |= (LCD_DISPLAY_D);
     }
     else {
         DisplayControl &= ~(LCD_DISPLAY_D);
     }
-    lcd16x2_writeCommand(DisplayControl);
+    return lcd16x2_queueCommand(DisplayControl);
 }
 
-void lcd16x2_shiftRight(uint8_t offset) {
+static bool lcd16x2_shift(uint8_t offset, uint8_t direction) {
+    if (lcd16x2_queueSpace() < offset)
+        return false;
     for(uint8_t i = 0; i < offset; i++) {
-        lcd16x2_writeCommand(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
+        lcd16x2_writeCommand(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | direction);
     }
+    return true;
 }
 
-void lcd16x2_shiftLeft(uint8_t offset) {
-    for(uint8_t i = 0; i < offset; i++) {
-        lcd16x2_writeCommand(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
-    }
+bool lcd16x2_shiftRight(uint8_t offset) {
+    return lcd16x2_shift(offset, LCD_MOVERIGHT);
+}
+
+bool lcd16x2_shiftLeft(uint8_t offset) {
+    return lcd16x2_shift(offset, LCD_MOVELEFT);
 }
 
 bool lcd16x2_printf(const char* str, ...) {
-    char string_array[LCD1602_MAX_LINE_LEN];
+    char string_array[LCD1602_MAX_LINE_LEN + 1];
     int string_size = sizeof(string_array);
 
     va_list args;
     va_start(args, str);
     int result = vsnprintf(string_array, string_size, str, args);
     va_end(args);
-    
-    if (result >= string_size || result < 0)
+
+    if (result >= string_size || result < 0 || lcd16x2_queueSpace() < (unsigned) result)
         return false;
-    
-    for(uint8_t i = 0;  i < strlen(string_array); i++) {
+
+    for(uint8_t i = 0;  i < result; i++) {
         lcd16x2_writeData((uint8_t)string_array[i]);
     }
     return true;
 }
-
@@ -25,6 +25,10 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define LCD1602_MAX_LINE_LEN 16U
 
 typedef unsigned pin_t;
@@ -37,27 +41,69 @@ typedef struct {
     pin_t d7;
 } pinset;
 
+// Steps queued by the functions below, a step is one bus transfer or a pause
+#define LCD1602_QUEUE_LENGTH 128U
+// HD44780 execution times at 270 kHz, clear and home rewrite the whole DDRAM
+#define LCD1602_EXECUTION_US      37U
+#define LCD1602_LONG_EXECUTION_US 1520U
+// Returned by lcd16x2_runStep() when nothing is queued
+#define LCD1602_IDLE         UINT32_MAX
+
 typedef bool (*lcd1602_pin_set)(pin_t pin, bool state);
 typedef void (*lcd1602_wait)(unsigned microseconds);
+// Puts nibble on D4-D7 and rs on RS at once, enable stays with pin_set
+typedef bool (*lcd1602_bus_write)(uint8_t nibble, bool rs);
+// Writes states to an expander latching every line from one byte, in one transaction
+typedef bool (*lcd1602_port_write)(const uint8_t* states, unsigned count);
+
+// States packed into one port write at most, a whole screen at 100 kHz
+#define LCD1602_PORT_BATCH 160U
+
+// Expanders like the PCF8574 of I2C backpacks. Runs of short steps, enable
+// pulses included, go out as one write, each step waits out the one before it
+// on the wire. pins then holds the port bit of every line.
+typedef struct {
+    lcd1602_port_write write;    // optional, when set pin_set, bus_write and wait are unused
+    uint8_t            hold;     // bits set in every state, the backlight
+    uint16_t           byte_time; // microseconds one state takes on the wire
+} lcd1602_port;
 
 typedef struct {
     pinset pins;
     lcd1602_pin_set pin_set;
-    lcd1602_wait wait;
+    lcd1602_wait wait; // only used for the enable pulse, a microsecond at most
+    lcd1602_bus_write bus_write; // optional, NULL writes D4-D7 and RS pin by pin
+    lcd1602_port port;
 } lcd1602_interface;
 
+// Nothing below touches the bus, the functions queue the steps of the command
+// and return at once, false when the queue has no room for all of them. One
+// task queues, another one executes with lcd16x2_runStep().
 void lcd16x2_init_4bits(lcd1602_interface iface);
-void lcd16x2_setCursor(uint8_t row, uint8_t col);
-void lcd16x2_1stLine(void);
-void lcd16x2_2ndLine(void);
-void lcd16x2_cursorShow(bool state);
-void lcd16x2_clear(void);
-void lcd16x2_display(bool state);
-void lcd16x2_shiftRight(uint8_t offset);
-void lcd16x2_shiftLeft(uint8_t offset);
+bool lcd16x2_setCursor(uint8_t row, uint8_t col);
+bool lcd16x2_1stLine(void);
+bool lcd16x2_2ndLine(void);
+bool lcd16x2_cursorShow(bool state);
+bool lcd16x2_clear(void);
+bool lcd16x2_display(bool state);
+bool lcd16x2_shiftRight(uint8_t offset);
+bool lcd16x2_shiftLeft(uint8_t offset);
 bool lcd16x2_printf(const char* str, ...);
-bool lcd16x2_createChar(uint8_t location, uint8_t charmap[]);
-void lcd16x2_writeCustom(uint8_t location);
+bool lcd16x2_createChar(uint8_t location, const uint8_t charmap[]);
+bool lcd16x2_writeCustom(uint8_t location);
+// Character code at the address counter, which then moves to the next cell
+bool lcd16x2_putChar(uint8_t code);
+unsigned lcd16x2_queueSpace(void);
+
+// Puts the next queued step on the bus, returns the microseconds the controller
+// needs to execute it before the next step may start, LCD1602_IDLE if none.
+// Through a port it puts every step up to the next long one and returns the
+// execution time of the last.
+uint32_t lcd16x2_runStep(void);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* LCD16X2_H_ */
 
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "lcd_framebuffer.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void lcd_framebuffer_clear(lcd_framebuffer_t* framebuffer) {
+    memset(framebuffer->cells, LCD_FRAMEBUFFER_BLANK, sizeof(framebuffer->cells));
+}
+
+unsigned lcd_framebuffer_write(lcd_framebuffer_t* framebuffer, unsigned row, unsigned column, const uint8_t* cells,
+                               unsigned count) {
+    if (row >= LCD_FRAMEBUFFER_ROWS || column >= LCD_FRAMEBUFFER_COLUMNS)
+        return 0;
+
+    count = count < LCD_FRAMEBUFFER_COLUMNS - column ? count : LCD_FRAMEBUFFER_COLUMNS - column;
+    memcpy(&framebuffer->cells[row][column], cells, count);
+    return count;
+}
+
+unsigned lcd_framebuffer_print(lcd_framebuffer_t* framebuffer, unsigned row, unsigned column, const char* format, ...) {
+    char text[LCD_FRAMEBUFFER_COLUMNS + 1];
+
+    va_list args;
+    va_start(args, format);
+    int result = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (result < 0)
+        return 0;
+    return lcd_framebuffer_write(framebuffer, row, column, (const uint8_t*) text, strlen(text));
+}
+
+// Counts the transfers only when output is NULL. The address counter runs past
+// the last column into the hidden part of DDRAM, so a new row always takes a
+// cursor move.
+static unsigned update_cells(lcd_framebuffer_t* displayed, const lcd_framebuffer_t* shadow,
+                             const lcd_framebuffer_output_t* output) {
+    unsigned transfers = 0;
+
+    for (unsigned row = 0; row < LCD_FRAMEBUFFER_ROWS; row++) {
+        unsigned cursor = LCD_FRAMEBUFFER_COLUMNS;
+        for (unsigned column = 0; column < LCD_FRAMEBUFFER_COLUMNS; column++) {
+            const uint8_t cell = shadow->cells[row][column];
+            if (cell == displayed->cells[row][column])
+                continue;
+
+            if (cursor != column) {
+                if (output && !output->set_cursor(row, column))
+                    return transfers;
+                transfers++;
+            }
+            if (output && !output->put(cell))
+                return transfers;
+            output ? ({displayed->cells[row][column] = cell;}) : ({});
+            transfers++;
+            cursor = column + 1;
+        }
+    }
+    return transfers;
+}
+
+unsigned lcd_framebuffer_flush(lcd_framebuffer_t* displayed, const lcd_framebuffer_t* shadow,
+                               const lcd_framebuffer_output_t* output) {
+    lcd_framebuffer_t blank;
+
+    lcd_framebuffer_clear(&blank);
+    const unsigned redraw = output->clear_cost + update_cells(&blank, shadow, NULL);
+    if (output->clear && redraw < update_cells(displayed, shadow, NULL)) {
+        if (!output->clear())
+            return 0;
+        lcd_framebuffer_clear(displayed);
+        return 1 + update_cells(displayed, shadow, output);
+    }
+    return update_cells(displayed, shadow, output);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_LCD_FRAMEBUFFER_
+#define _MAIN_LCD_FRAMEBUFFER_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LCD_FRAMEBUFFER_ROWS    2U
+#define LCD_FRAMEBUFFER_COLUMNS 16U
+#define LCD_FRAMEBUFFER_BLANK   ' '
+
+// Character codes as they go to DDRAM, 0..7 select the CGRAM glyphs
+typedef struct {
+    uint8_t cells[LCD_FRAMEBUFFER_ROWS][LCD_FRAMEBUFFER_COLUMNS];
+} lcd_framebuffer_t;
+
+// Controller operations a flush is made of, each one bus transfer
+typedef struct {
+    bool     (*set_cursor)(uint8_t row, uint8_t column);
+    bool     (*put)(uint8_t cell);
+    bool     (*clear)(void);
+    unsigned clear_cost; // what a clear is weighed as in single transfers, 1 counts operations
+} lcd_framebuffer_output_t;
+
+void lcd_framebuffer_clear(lcd_framebuffer_t* framebuffer);
+// Clipped at the end of the row, returns the number of cells written
+unsigned lcd_framebuffer_write(lcd_framebuffer_t* framebuffer, unsigned row, unsigned column, const uint8_t* cells,
+                               unsigned count);
+// Formatted text, clipped at the end of the row, returns the number of cells written
+unsigned lcd_framebuffer_print(lcd_framebuffer_t* framebuffer, unsigned row, unsigned column, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+// Emits the cheapest operations turning the displayed content into shadow and
+// updates displayed to match what was accepted. Cursor moves are only issued
+// where the address counter isn't already on the next changed cell, a clear is
+// issued instead when redrawing everything costs less. Returns the transfers.
+unsigned lcd_framebuffer_flush(lcd_framebuffer_t* displayed, const lcd_framebuffer_t* shadow,
+                               const lcd_framebuffer_output_t* output);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_LCD_FRAMEBUFFER_
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "lcd_glyphs.h"
+
+#include <string.h>
+
+#define BAR_ROW(columns)  ((uint8_t) (0x1F & ~(0x1F >> (columns))))
+#define BAR(columns)      { [0 ... LCD_GLYPH_ROWS - 1] = BAR_ROW(columns) }
+#define LEVEL(rows)       { [LCD_GLYPH_ROWS - (rows) ... LCD_GLYPH_ROWS - 1] = 0x1F }
+
+static const uint8_t bitmaps[LCD_GLYPH_LAST - LCD_GLYPH_FIRST][LCD_GLYPH_ROWS] = {
+    [LCD_GLYPH_HEART - LCD_GLYPH_FIRST]         = { 0b00000, 0b01010, 0b11111, 0b11111,
+                                                    0b01110, 0b00100, 0b00000, 0b00000 },
+    [LCD_GLYPH_PLATE_PROGRAM - LCD_GLYPH_FIRST] = { 0b00000, 0b01110, 0b01010, 0b01110,
+                                                    0b01000, 0b01000, 0b00000, 0b11111 },
+    [LCD_GLYPH_ARROW_UP - LCD_GLYPH_FIRST]      = { 0b00000, 0b00100, 0b01110, 0b11111,
+                                                    0b00100, 0b00100, 0b00100, 0b00000 },
+    [LCD_GLYPH_ARROW_DOWN - LCD_GLYPH_FIRST]    = { 0b00000, 0b00100, 0b00100, 0b00100,
+                                                    0b11111, 0b01110, 0b00100, 0b00000 },
+    [LCD_GLYPH_BAR_1 - LCD_GLYPH_FIRST]         = BAR(1),
+    [LCD_GLYPH_BAR_2 - LCD_GLYPH_FIRST]         = BAR(2),
+    [LCD_GLYPH_BAR_3 - LCD_GLYPH_FIRST]         = BAR(3),
+    [LCD_GLYPH_BAR_4 - LCD_GLYPH_FIRST]         = BAR(4),
+    [LCD_GLYPH_LEVEL_1 - LCD_GLYPH_FIRST]       = LEVEL(1),
+    [LCD_GLYPH_LEVEL_2 - LCD_GLYPH_FIRST]       = LEVEL(2),
+    [LCD_GLYPH_LEVEL_3 - LCD_GLYPH_FIRST]       = LEVEL(3),
+    [LCD_GLYPH_LEVEL_4 - LCD_GLYPH_FIRST]       = LEVEL(4),
+    [LCD_GLYPH_LEVEL_5 - LCD_GLYPH_FIRST]       = LEVEL(5),
+    [LCD_GLYPH_LEVEL_6 - LCD_GLYPH_FIRST]       = LEVEL(6),
+    [LCD_GLYPH_LEVEL_7 - LCD_GLYPH_FIRST]       = LEVEL(7),
+};
+
+_Static_assert(LCD_GLYPH_LAST <= 0xA0, "Glyph codes have to stay in the blank part of the character ROM");
+
+static bool is_glyph(uint8_t cell) {
+    return cell >= LCD_GLYPH_FIRST && cell < LCD_GLYPH_LAST;
+}
+
+void lcd_glyph_cache_init(lcd_glyph_cache_t* cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+const uint8_t* lcd_glyph_bitmap(lcd_glyph glyph) {
+    return is_glyph(glyph) ? bitmaps[glyph - LCD_GLYPH_FIRST] : NULL;
+}
+
+// Codes 8-15 show CGRAM as well
+static uint8_t displayed_slots(const lcd_framebuffer_t* displayed) {
+    uint8_t slots = 0;
+
+    for (unsigned row = 0; row < LCD_FRAMEBUFFER_ROWS; row++) {
+        for (unsigned column = 0; column < LCD_FRAMEBUFFER_COLUMNS; column++) {
+            uint8_t cell = displayed->cells[row][column];
+            slots |= cell < 2 * LCD_GLYPH_SLOTS ? 1 << (cell % LCD_GLYPH_SLOTS) : 0;
+        }
+    }
+    return slots;
+}
+
+static int find_slot(const lcd_glyph_cache_t* cache, uint8_t glyph) {
+    for (unsigned slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        if (cache->glyphs[slot] == glyph)
+            return (int) slot;
+    }
+    return -1;
+}
+
+// Free slots first, then the ones off the display, the least recently used of
+// them. Slots this screen needs are never taken.
+static int victim(const lcd_glyph_cache_t* cache, uint8_t on_display) {
+    int chosen = -1;
+    unsigned chosen_rank = 0;
+
+    for (unsigned slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        if (cache->glyphs[slot] != LCD_GLYPH_FREE && cache->used[slot] == cache->screens)
+            continue;
+        unsigned rank = cache->glyphs[slot] == LCD_GLYPH_FREE ? 0 : on_display & (1 << slot) ? 2 : 1;
+        if (chosen < 0 || rank < chosen_rank || (rank == chosen_rank && cache->used[slot] < cache->used[chosen])) {
+            chosen = (int) slot;
+            chosen_rank = rank;
+        }
+    }
+    return chosen;
+}
+
+bool lcd_glyph_resolve(lcd_glyph_cache_t* cache, lcd_framebuffer_t* screen, const lcd_framebuffer_t* displayed,
+                       lcd_glyph_upload upload) {
+    uint8_t* cells = &screen->cells[0][0];
+    const unsigned count = LCD_FRAMEBUFFER_ROWS * LCD_FRAMEBUFFER_COLUMNS;
+    const uint8_t on_display = displayed_slots(displayed);
+    bool uploaded = true;
+
+    cache->screens++;
+    // Glyphs already loaded first, so none of them gets evicted by a missing one
+    for (unsigned i = 0; i < count; i++) {
+        int slot = is_glyph(cells[i]) ? find_slot(cache, cells[i]) : -1;
+        slot >= 0 ? ({ cache->used[slot] = cache->screens; }) : ({});
+    }
+    for (unsigned i = 0; i < count; i++) {
+        if (!is_glyph(cells[i]))
+            continue;
+
+        int slot = find_slot(cache, cells[i]);
+        if (slot < 0 && uploaded && (slot = victim(cache, on_display)) >= 0) {
+            cache->glyphs[slot] = LCD_GLYPH_FREE;
+            if ((uploaded = upload((uint8_t) slot, bitmaps[cells[i] - LCD_GLYPH_FIRST])))
+                cache->glyphs[slot] = cells[i];
+            else
+                slot = -1;
+        }
+        slot >= 0 ? ({ cache->used[slot] = cache->screens; cells[i] = (uint8_t) slot; })
+                  : ({ cells[i] = LCD_FRAMEBUFFER_BLANK; });
+    }
+    return uploaded;
+}
+
+void lcd_glyph_bar(uint8_t* cells, unsigned width, unsigned permille) {
+    unsigned steps = (permille < 1000 ? permille : 1000) * width * LCD_GLYPH_BAR_STEPS / 1000;
+
+    for (unsigned cell = 0; cell < width; cell++) {
+        unsigned lit = steps > cell * LCD_GLYPH_BAR_STEPS ? steps - cell * LCD_GLYPH_BAR_STEPS : 0;
+        cells[cell] = lit >= LCD_GLYPH_BAR_STEPS ? LCD_GLYPH_FULL
+                    : lit > 0                    ? (uint8_t) (LCD_GLYPH_BAR_1 + lit - 1)
+                                                 : LCD_FRAMEBUFFER_BLANK;
+    }
+}
+
+uint8_t lcd_glyph_level(unsigned level) {
+    return level >= LCD_GLYPH_LEVEL_STEPS ? LCD_GLYPH_FULL
+         : level > 0                      ? (uint8_t) (LCD_GLYPH_LEVEL_1 + level - 1)
+                                          : LCD_FRAMEBUFFER_BLANK;
+}
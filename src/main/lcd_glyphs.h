@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_LCD_GLYPHS_
+#define _MAIN_LCD_GLYPHS_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd_framebuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LCD_GLYPH_SLOTS  8U
+#define LCD_GLYPH_ROWS   8U
+// The A00 character ROM leaves 0x80-0x9F blank, screens use these codes for
+// glyphs and lcd_glyph_resolve() swaps them for the CGRAM slot holding them.
+#define LCD_GLYPH_FIRST  0x80U
+#define LCD_GLYPH_FREE   0x00U // slot holding no glyph
+#define LCD_GLYPH_FULL   0xFFU // all pixels lit, in the character ROM
+
+typedef enum {
+    LCD_GLYPH_HEART = LCD_GLYPH_FIRST,
+    LCD_GLYPH_PLATE_PROGRAM,
+    LCD_GLYPH_ARROW_UP,
+    LCD_GLYPH_ARROW_DOWN,
+    LCD_GLYPH_BAR_1,   // 1 to 4 of the 5 pixel columns lit from the left
+    LCD_GLYPH_BAR_2,
+    LCD_GLYPH_BAR_3,
+    LCD_GLYPH_BAR_4,
+    LCD_GLYPH_LEVEL_1, // 1 to 7 of the 8 pixel rows lit from the bottom
+    LCD_GLYPH_LEVEL_2,
+    LCD_GLYPH_LEVEL_3,
+    LCD_GLYPH_LEVEL_4,
+    LCD_GLYPH_LEVEL_5,
+    LCD_GLYPH_LEVEL_6,
+    LCD_GLYPH_LEVEL_7,
+    LCD_GLYPH_LAST
+} lcd_glyph;
+
+#define LCD_GLYPH_BAR_STEPS   5U
+#define LCD_GLYPH_LEVEL_STEPS 8U
+
+typedef bool (*lcd_glyph_upload)(uint8_t slot, const uint8_t bitmap[LCD_GLYPH_ROWS]);
+
+// CGRAM contents, the slots are handed out least recently used first
+typedef struct {
+    uint8_t  glyphs[LCD_GLYPH_SLOTS]; // glyph loaded in every slot, LCD_GLYPH_FREE if none
+    uint32_t used[LCD_GLYPH_SLOTS];   // screen the slot was last needed by
+    uint32_t screens;
+} lcd_glyph_cache_t;
+
+void lcd_glyph_cache_init(lcd_glyph_cache_t* cache);
+const uint8_t* lcd_glyph_bitmap(lcd_glyph glyph);
+// Replaces the glyph codes of screen by the slots holding them and uploads the
+// glyphs not loaded yet. Slots shown on displayed are evicted last, cells of
+// them that now show another glyph differ from screen, the flush rewrites them.
+// Glyphs beyond the eight a screen can hold are blanked. Returns false when an
+// upload didn't go through, the cache keeps the ones that did.
+bool lcd_glyph_resolve(lcd_glyph_cache_t* cache, lcd_framebuffer_t* screen, const lcd_framebuffer_t* displayed,
+                       lcd_glyph_upload upload);
+
+// Horizontal bar of width cells filled to permille, five steps per cell
+void lcd_glyph_bar(uint8_t* cells, unsigned width, unsigned permille);
+// Sparkline cell showing level of LCD_GLYPH_LEVEL_STEPS
+uint8_t lcd_glyph_level(unsigned level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MAIN_LCD_GLYPHS_
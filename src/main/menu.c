@@ -17,116 +17,298 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
 #include "encoder.h"
+#include "heat_controller.h"
 #include "lcd.h"
 #include "menu.h"
+#include "status_screen.h"
+#include "thermocouple_sampler.h"
+#include "menu_definitions.h"
+#include "utilities/addons.h"
 #include "utilities/scheduler.h"
 #include "utilities/timer.h"
 
 #define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_DEBUG
 #include "utilities/logger.h"
 
+// Kinds of menu.scf entries, system screens bring their own state handler
 typedef enum {
-     MENU_STATE_INIT,
-     MENU_STATE_PREEMPTED,
-     MENU_STATE_HEATING_CONSTANT,
-     MENU_STATE_HEATING_CONSTANT_TEMPERATURE_SET,
-     MENU_STATE_HEATING_CONSTANT_TIME_SET,
-     MENU_STATE_HEATING_JEDEC,
-     MENU_STATE_WAIT,
-     MENU_STATE_DONE,
+    MENU_KIND_SYSTEM,
+    MENU_KIND_ITEM,    // turned through among its siblings, a push enters its first child
+    MENU_KIND_VALUE,   // edited by turns, a push moves on to the next sibling
+    MENU_KIND_ACTION,  // posts the parent's request when entered and shows it running
+    MENU_KIND_LAST
+} menu_kind;
+
+typedef enum {
+    #define MENU_SYSTEM(name, state_handler, drawing) MENU_STATE_##name,
+    #define MENU_ITEM(name, parent, first_line, second_line) MENU_STATE_##name,
+    #define MENU_VALUE(name, parent, label, field, min, max, acceleration) MENU_STATE_##name,
+    #define MENU_ACTION(name, parent, request_type) MENU_STATE_##name,
+    #include "menu.scf"
+    #undef MENU_SYSTEM
+    #undef MENU_ITEM
+    #undef MENU_VALUE
+    #undef MENU_ACTION
+    MENU_STATE_LAST
 } menu_state;
 
+// Kind of every state as a constant, for the build time checks below
+enum {
+    #define MENU_SYSTEM(name, state_handler, drawing) MENU_KIND_OF_##name = MENU_KIND_SYSTEM,
+    #define MENU_ITEM(name, parent, first_line, second_line) MENU_KIND_OF_##name = MENU_KIND_ITEM,
+    #define MENU_VALUE(name, parent, label, field, min, max, acceleration) MENU_KIND_OF_##name = MENU_KIND_VALUE,
+    #define MENU_ACTION(name, parent, request_type) MENU_KIND_OF_##name = MENU_KIND_ACTION,
+    #include "menu.scf"
+    #undef MENU_SYSTEM
+    #undef MENU_ITEM
+    #undef MENU_VALUE
+    #undef MENU_ACTION
+};
+
+typedef enum {
+    MENU_MOVE_STAY,
+    MENU_MOVE_PREVIOUS,  // previous sibling
+    MENU_MOVE_NEXT,      // next sibling
+    MENU_MOVE_INTO,      // first child
+    MENU_MOVE_OUT,       // parent item, top level items stay
+    MENU_MOVE_BACK,      // previous sibling, out from the first one
+    MENU_MOVE_HOME,
+    MENU_MOVE_PREEMPT,
+    MENU_MOVE_ADJUST,
+    MENU_MOVE_ABORT,     // cancel the running request
+    MENU_MOVE_FINISH,
+} menu_move;
+
+// Navigation of everything but the system screens, events not listed stay
+static const menu_move transitions[MENU_KIND_LAST][MENU_EVENT_ENCODER_LAST] = {
+    [MENU_KIND_ITEM] = {
+        [MENU_EVENT_ENCODER_UP]      = MENU_MOVE_PREVIOUS,
+        [MENU_EVENT_ENCODER_DOWN]    = MENU_MOVE_NEXT,
+        [MENU_EVENT_ENCODER_PUSH]    = MENU_MOVE_INTO,
+        [MENU_EVENT_ENCODER_BACK]    = MENU_MOVE_OUT,
+        [MENU_EVENT_ENCODER_CANCEL]  = MENU_MOVE_HOME,
+        [MENU_EVENT_PREEMPT_REQUEST] = MENU_MOVE_PREEMPT,
+    },
+    [MENU_KIND_VALUE] = {
+        [MENU_EVENT_ENCODER_UP]      = MENU_MOVE_ADJUST,
+        [MENU_EVENT_ENCODER_DOWN]    = MENU_MOVE_ADJUST,
+        [MENU_EVENT_ENCODER_PUSH]    = MENU_MOVE_NEXT,
+        [MENU_EVENT_ENCODER_BACK]    = MENU_MOVE_BACK,
+        [MENU_EVENT_ENCODER_CANCEL]  = MENU_MOVE_HOME,
+        [MENU_EVENT_PREEMPT_REQUEST] = MENU_MOVE_PREEMPT,
+    },
+    [MENU_KIND_ACTION] = {
+        [MENU_EVENT_ENCODER_CANCEL]  = MENU_MOVE_ABORT,
+        [MENU_EVENT_REQUEST_DONE]    = MENU_MOVE_FINISH,
+    },
+};
+
 static menu_state current_state = MENU_STATE_INIT;
-static unsigned const_temperature = 0;
-static seconds const_time = 0;
+static unsigned values[MENU_STATE_LAST];
+static struct {
+    lcd_screen shown;
+    bool       is_shown;
+} display;
+static struct {
+    TickType_t refreshed;
+    bool       is_refreshed;
+} status;
+static struct {
+    TickType_t drawn;
+    bool       is_drawn;
+    bool       is_pending; // a deferred redraw is armed
+} value_redraw;
+
+typedef struct {
+    unsigned velocity; // detents per second from which the step applies
+    unsigned step;
+} menu_acceleration_point;
 
 typedef menu_state
-(*invalidator_state_handler)(menu_event_type);
+(*invalidator_state_handler)(menu_event_t);
+typedef void (*menu_drawing_callback)(void);
+
+typedef struct {
+    menu_kind                      kind;
+    menu_state                     owner;    // parent, MENU_STATE_LAST for system screens
+    invalidator_state_handler      handler;  // system screens only
+    menu_drawing_callback          render;
+    const char*                    caption;  // item title or value label
+    const char*                    detail;
+    unsigned                       minimum;
+    unsigned                       maximum;
+    const menu_acceleration_point* curve;
+    unsigned                       curve_points;
+    heating_request_type           request;
+} menu_node;
+
+// Generated from menu.scf further down, it needs the handlers and renderers above it
+static const menu_node nodes[MENU_STATE_LAST];
+
+// Every screen goes through here, one identical to what is shown is dropped
+static void submit_screen(const lcd_screen* screen) {
+    if (display.is_shown && 0 == memcmp(screen, &display.shown, sizeof(*screen)))
+        return;
+
+    display.is_shown = ERROR_ANY == lcd_submit_screen(screen);
+    display.shown    = *screen;
+}
 
-static void show_const_time_setup(void) {
-    const char time_str[] = "time:";
+static void show_screen(const char* first_line, const char* second_line) {
+    lcd_screen screen;
 
-    lcd_send_clean();
-    lcd_send_request(0, 0, "Set");
-    lcd_send_request(1, 0, time_str); 
-    lcd_send_request(1, sizeof(time_str), "%u", const_time); 
+    lcd_framebuffer_clear(&screen);
+    lcd_framebuffer_print(&screen, 0, 0, "%s", first_line);
+    lcd_framebuffer_print(&screen, 1, 0, "%s", second_line);
+    submit_screen(&screen);
 }
 
-static void show_const_temperature_setup(void) {
-    const char temperature_str[] = "temperature:";
+static void on_value_redraw(void* args) {
+    (void) args;
+    menu_event_t event = {.type = MENU_EVENT_REDRAW};
+    scheduler_enqueue(SchedulerQueueMenu, &event);
+}
 
-    lcd_send_clean();
-    lcd_send_request(0, 0, "Set");
-    lcd_send_request(1, 0, temperature_str); 
-    lcd_send_request(1, sizeof(temperature_str), "%u", const_temperature); 
+// Encoder turns redraw at most once per cap, the last value skipped is drawn
+// by a deferred redraw once the cap expires
+static bool is_value_redraw_due(void) {
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t cap = pdMS_TO_TICKS(MENU_VALUE_MIN_PERIOD_MS);
+
+    if (!value_redraw.is_drawn || now - value_redraw.drawn >= cap) {
+        value_redraw.drawn      = now;
+        value_redraw.is_drawn   = true;
+        value_redraw.is_pending = false;
+        return true;
+    }
+    if (!value_redraw.is_pending) {
+        const miliseconds left = (cap - (now - value_redraw.drawn)) * portTICK_PERIOD_MS;
+        value_redraw.is_pending = ERROR_ANY == oneshot_arm(oneshot_menu_redraw, left, on_value_redraw, NULL);
+    }
+    return false;
 }
 
-static void show_heating_constant_display(void) {
-    lcd_send_clean();
-    lcd_send_request(0, 0, "Constant");
-    lcd_send_request(1, 0, "temperature");
+// Value entry screens are always drawn in full when entered
+static void reset_value_redraw(void) {
+    value_redraw.is_drawn   = false;
+    value_redraw.is_pending = false;
 }
 
-static void show_jedec_display(void) {
-    lcd_send_clean();
-    lcd_send_request(0,0, "JEDEC");
+static unsigned accelerated_step(const menu_acceleration_point* curve, unsigned points, unsigned velocity) {
+    unsigned step = 1;
+    for (unsigned i = 0; i < points && velocity >= curve[i].velocity; i++)
+        step = curve[i].step;
+    return step;
 }
 
-static void show_running_state(void) {
-    lcd_send_clean();
-    lcd_send_request(0, 0, "Running...");
+// Steps above one snap the value to their grid, so a fast spin lands on round numbers
+static unsigned adjust_value(const menu_node* node, unsigned value, menu_event_t event) {
+    const unsigned step = accelerated_step(node->curve, node->curve_points, event.velocity);
+
+    if (event.type == MENU_EVENT_ENCODER_UP)
+        value = (value / step + 1) * step;
+    else if (value % step)
+        value -= value % step;
+    else
+        value = value < step ? 0 : value - step;
+    return value < node->minimum ? node->minimum : value > node->maximum ? node->maximum : value;
 }
 
-static void show_done_state(void) {
-    lcd_send_clean();
-    lcd_send_request(0, 0, "Done");
+static void show_idle(void) {
+    show_screen("   ThermoPlate", "");
 }
 
-static void show_preempt_display(void) {
-    lcd_send_clean();
-    lcd_send_request(0, 0, "BLE control");
+static void show_preempted(void) {
+    show_screen("BLE control", "");
 }
 
-static void send_predefined_heating_request(void) {
-    heater_request request = {
-        .type = HEATING_REQUEST_JEDEC,
-    };
-    scheduler_enqueue(SchedulerQueueHeatControlerInterface, &request);
+static void show_done(void) {
+    show_screen("Done", "");
 }
 
-static void send_constant_heating_request(celcius temperature, seconds time) {
-    heater_request request = {
-        .type = HEATING_REQUEST_CONSTANT,
-        .constant = {
-            .duration = time,
-            .const_temperature = temperature
-        }
-    };
-    scheduler_enqueue(SchedulerQueueHeatControlerInterface, &request);
+static void show_item(void) {
+    show_screen(nodes[current_state].caption, nodes[current_state].detail);
+}
+
+static void show_value(void) {
+    lcd_screen screen;
+
+    if (!is_value_redraw_due())
+        return;
+
+    lcd_framebuffer_clear(&screen);
+    lcd_framebuffer_print(&screen, 0, 0, "Set");
+    lcd_framebuffer_print(&screen, 1, 0, "%s %u", nodes[current_state].caption, values[current_state]);
+    submit_screen(&screen);
+}
+
+static void show_running_state(void) {
+    const TickType_t now = xTaskGetTickCount();
+    if (status.is_refreshed && now - status.refreshed < pdMS_TO_TICKS(MENU_STATUS_MIN_PERIOD_MS))
+        return;
+
+    thermocouple_sample_t sample;
+    miliseconds age;
+    heat_controller_status_t heating;
+    status_screen_t view = {0};
+    lcd_screen screen;
+
+    if (thermocouple_sampler_latest(&sample, &age) && age <= THERMOCOUPLE_MAX_SAMPLE_AGE_MS) {
+        view.has_temperature = true;
+        view.temperature     = sample.temperature;
+    }
+    if (heat_controller_get_status(&heating)) {
+        view.is_heating = true;
+        view.setpoint   = heating.setpoint;
+        view.power      = heating.power;
+        view.stage      = heating.stage;
+        view.remaining  = heating.remaining;
+    }
+    status_screen_render(&view, &screen);
+    status.refreshed    = now;
+    status.is_refreshed = true;
+    submit_screen(&screen);
+}
+
+// Timer task context, the redraw itself happens in the scheduler task
+static void on_status_tick(void* args) {
+    (void) args;
+    menu_event_t event = {.type = MENU_EVENT_STATUS_TICK};
+    scheduler_enqueue(SchedulerQueueMenu, &event);
+}
+
+static void start_status_updates(void) {
+    status.is_refreshed = false;
+    (void) timer_unregister_callback(periodic_timer_one_sec, on_status_tick);
+    (void) timer_register_callback(periodic_timer_one_sec, on_status_tick, NULL);
+}
+
+static void stop_status_updates(void) {
+    (void) timer_unregister_callback(periodic_timer_one_sec, on_status_tick);
 }
 
+static menu_state menu_home(void);
+
 static menu_state
-handle_idle_state(menu_event_type event) {
-    switch (event) {
+handle_idle_state(menu_event_t event) {
+    switch (event.type) {
         case MENU_EVENT_PREEMPT_REQUEST:
-            return MENU_STATE_PREEMPTED; 
+            return MENU_STATE_PREEMPTED;
 
         default:
-            return MENU_STATE_HEATING_CONSTANT;
+            return menu_home();
     }
-    return MENU_STATE_INIT;
+    return current_state;
 }
 
-
 static menu_state
-handle_preempted_state(menu_event_type event) {
-    switch (event) {
+handle_preempted_state(menu_event_t event) {
+    switch (event.type) {
         case MENU_EVENT_PREEMPT_TAKE:
-            return MENU_STATE_HEATING_CONSTANT;
-
-        case MENU_EVENT_PREEMPT_REQUEST:
-            return MENU_STATE_PREEMPTED; 
+            return menu_home();
 
         default:
             break;
@@ -134,73 +316,162 @@ handle_preempted_state(menu_event_type event) {
     return MENU_STATE_PREEMPTED;
 }
 
+// System screens have to name a handler and a renderer of the right type, a
+// tree entry a parent listed before it that is able to hold it
+#define MENU_IS_ITEM(state) ((menu_kind) MENU_KIND_OF_##state == MENU_KIND_ITEM)
+#define MENU_ASSERT_PARENT(name, parent, is_allowed)                                                                 \
+    _Static_assert(MENU_STATE_##parent < MENU_STATE_##name, #name " is listed before its parent " #parent);          \
+    _Static_assert(is_allowed, #name " can't be a child of " #parent);
+#define MENU_SYSTEM(name, state_handler, drawing)                                                                    \
+    _Static_assert(__same_type(&state_handler, (invalidator_state_handler) NULL), #name " needs a state handler");   \
+    _Static_assert(__same_type(&drawing, (menu_drawing_callback) NULL), #name " needs a drawing callback");
+#define MENU_ITEM(name, parent, first_line, second_line)                                                             \
+    MENU_ASSERT_PARENT(name, parent, MENU_STATE_##parent == MENU_STATE_INIT || MENU_IS_ITEM(parent))
+#define MENU_VALUE(name, parent, label, field, min, max, acceleration)                                               \
+    MENU_ASSERT_PARENT(name, parent, MENU_IS_ITEM(parent))                                                           \
+    _Static_assert((min) < (max), #name " has an empty range");
+#define MENU_ACTION(name, parent, request_type)                                                                      \
+    MENU_ASSERT_PARENT(name, parent, MENU_IS_ITEM(parent))
+#include "menu.scf"
+#undef MENU_SYSTEM
+#undef MENU_ITEM
+#undef MENU_VALUE
+#undef MENU_ACTION
+#undef MENU_ASSERT_PARENT
+#undef MENU_IS_ITEM
+_Static_assert(MENU_MOVE_STAY == 0, "events missing from the transitions have to stay");
+
+#define MENU_SYSTEM(name, state_handler, drawing)
+#define MENU_ITEM(name, parent, first_line, second_line)
+#define MENU_VALUE(name, parent, label, field, min, max, acceleration) \
+    static const menu_acceleration_point acceleration_##name[] = acceleration;
+#define MENU_ACTION(name, parent, request_type)
+#include "menu.scf"
+#undef MENU_SYSTEM
+#undef MENU_ITEM
+#undef MENU_VALUE
+#undef MENU_ACTION
+
+static const menu_node nodes[MENU_STATE_LAST] = {
+    #define MENU_SYSTEM(name, state_handler, drawing) \
+        [MENU_STATE_##name] = {.kind = MENU_KIND_SYSTEM, .owner = MENU_STATE_LAST, .handler = state_handler, \
+                               .render = drawing},
+    #define MENU_ITEM(name, parent, first_line, second_line) \
+        [MENU_STATE_##name] = {.kind = MENU_KIND_ITEM, .owner = MENU_STATE_##parent, .render = show_item, \
+                               .caption = first_line, .detail = second_line},
+    #define MENU_VALUE(name, parent, label, field, min, max, acceleration) \
+        [MENU_STATE_##name] = {.kind = MENU_KIND_VALUE, .owner = MENU_STATE_##parent, .render = show_value, \
+                               .caption = label, .minimum = min, .maximum = max, .curve = acceleration_##name, \
+                               .curve_points = COUNT_OF(acceleration_##name)},
+    #define MENU_ACTION(name, parent, request_type) \
+        [MENU_STATE_##name] = {.kind = MENU_KIND_ACTION, .owner = MENU_STATE_##parent, \
+                               .render = show_running_state, .request = request_type},
+    #include "menu.scf"
+    #undef MENU_SYSTEM
+    #undef MENU_ITEM
+    #undef MENU_VALUE
+    #undef MENU_ACTION
+};
 
-static menu_state handle_push_for_heating(void) {
-    switch (current_state) {
-        case MENU_STATE_HEATING_CONSTANT:
-            show_const_temperature_setup();
-            return MENU_STATE_HEATING_CONSTANT_TEMPERATURE_SET;
-
-        case MENU_STATE_HEATING_JEDEC:
-            send_predefined_heating_request();
-            return MENU_STATE_WAIT;
+// Values fill the request of an action among their siblings
+static void fill_request(menu_state action, heater_request* request) {
+    const menu_state owner = nodes[action].owner;
+
+    #define MENU_SYSTEM(name, state_handler, drawing)
+    #define MENU_ITEM(name, parent, first_line, second_line)
+    #define MENU_VALUE(name, parent, label, field, min, max, acceleration) \
+        if (MENU_STATE_##parent == owner)                                  \
+            request->field = values[MENU_STATE_##name];
+    #define MENU_ACTION(name, parent, request_type)
+    #include "menu.scf"
+    #undef MENU_SYSTEM
+    #undef MENU_ITEM
+    #undef MENU_VALUE
+    #undef MENU_ACTION
+}
 
-        default:
-            break;
-    }
-    return current_state;
+// Parents precede their children and siblings keep the menu.scf order
+static menu_state first_child(menu_state state) {
+    for (menu_state child = state + 1; child < MENU_STATE_LAST; child++)
+        if (nodes[child].owner == state)
+            return child;
+    return state;
 }
 
-static menu_state
-handle_heating_state(menu_event_type event) {
-    switch (event) {
-        case MENU_EVENT_ENCODER_UP:
-            return MENU_STATE_HEATING_CONSTANT;
+static menu_state next_sibling(menu_state state) {
+    for (menu_state sibling = state + 1; sibling < MENU_STATE_LAST; sibling++)
+        if (nodes[sibling].owner == nodes[state].owner)
+            return sibling;
+    return state;
+}
 
-        case MENU_EVENT_ENCODER_DOWN:
-                return MENU_STATE_HEATING_JEDEC;
+static menu_state previous_sibling(menu_state state) {
+    for (menu_state sibling = state; sibling-- > 0;)
+        if (nodes[sibling].owner == nodes[state].owner)
+            return sibling;
+    return state;
+}
 
-        case MENU_EVENT_ENCODER_PUSH:
-            return handle_push_for_heating();
+static menu_state menu_home(void) {
+    return first_child(MENU_STATE_INIT);
+}
 
-        case MENU_EVENT_PREEMPT_REQUEST:
-            return MENU_STATE_PREEMPTED; 
+static void post_request(menu_state action) {
+    heater_request request = {
+        .type = nodes[action].request,
+    };
+    fill_request(action, &request);
+    start_status_updates();
+    scheduler_enqueue(SchedulerQueueHeatControlerInterface, &request);
+}
 
-        default:
-            break;
-    }
-    return current_state;
+// Long press during heating, the interface answers with the usual request done
+static void post_cancel_request(void) {
+    heater_request request = {
+        .type = HEATING_REQUEST_CANCEL,
+    };
+    scheduler_enqueue(SchedulerQueueHeatControlerInterface, &request);
 }
 
-static menu_state handle_push_for_temperature_set(void) {
-    switch (current_state) {
-        case MENU_STATE_HEATING_CONSTANT_TEMPERATURE_SET:
-            show_const_time_setup();
-            return MENU_STATE_HEATING_CONSTANT_TIME_SET;
+static menu_state move(menu_move step, menu_event_t event) {
+    const menu_state owner = nodes[current_state].owner;
+    menu_state target;
 
-        default:
-            break;
-    } return current_state;
-}
+    switch (step) {
+        case MENU_MOVE_PREVIOUS:
+            return previous_sibling(current_state);
 
-static menu_state
-handle_temperature_set(menu_event_type event) {
-    switch (event) {
-        case MENU_EVENT_ENCODER_UP:
-            const_temperature++;
-            show_const_temperature_setup();
-            return current_state;
+        case MENU_MOVE_NEXT:
+            return next_sibling(current_state);
 
-        case MENU_EVENT_ENCODER_DOWN:
-            const_temperature == 0 ? ({}) : ({ const_temperature--;});
-            show_const_temperature_setup();
-            return current_state;
+        case MENU_MOVE_INTO:
+            return first_child(current_state);
 
-        case MENU_EVENT_ENCODER_PUSH:
-            return handle_push_for_temperature_set();
+        case MENU_MOVE_BACK:
+            if (current_state != (target = previous_sibling(current_state)))
+                return target;
+            return owner;
 
-        case MENU_EVENT_PREEMPT_REQUEST:
-            return MENU_STATE_PREEMPTED; 
+        case MENU_MOVE_OUT:
+            return nodes[owner].kind == MENU_KIND_ITEM ? owner : current_state;
+
+        case MENU_MOVE_HOME:
+            return menu_home();
+
+        case MENU_MOVE_PREEMPT:
+            return MENU_STATE_PREEMPTED;
+
+        case MENU_MOVE_ADJUST:
+            values[current_state] = adjust_value(&nodes[current_state], values[current_state], event);
+            break;
+
+        case MENU_MOVE_ABORT:
+            post_cancel_request();
+            break;
+
+        case MENU_MOVE_FINISH:
+            stop_status_updates();
+            return MENU_STATE_DONE;
 
         default:
             break;
@@ -208,76 +479,62 @@ handle_temperature_set(menu_event_type event) {
     return current_state;
 }
 
-static menu_state
-handle_time_set(menu_event_type event) {
-    switch (event) {
-        case MENU_EVENT_ENCODER_UP:
-            const_time++;
-            show_const_time_setup();
-            return current_state;
-
-        case MENU_EVENT_ENCODER_DOWN:
-            const_time == 0 ? ({}) : ({ const_time--;});
-            show_const_time_setup();
-            return current_state;
-
-        case MENU_EVENT_ENCODER_PUSH:
-            send_constant_heating_request(const_temperature, const_time);
-            return MENU_STATE_WAIT;
+static menu_state enter(menu_state state) {
+    switch (nodes[state].kind) {
+        case MENU_KIND_VALUE:
+            reset_value_redraw();
+            break;
 
-        case MENU_EVENT_PREEMPT_REQUEST:
-            return MENU_STATE_PREEMPTED; 
+        case MENU_KIND_ACTION:
+            post_request(state);
+            break;
 
         default:
             break;
     }
-    return current_state;
+    return state;
 }
 
-static menu_state
-handle_wait_state(menu_event_type event) {
-    if (event == MENU_EVENT_REQUEST_DONE)
-        return MENU_STATE_DONE;
-    return current_state;
-}
+static void
+menu_process(menu_event_t input) {
+    const menu_node* node = &nodes[current_state];
+    const menu_state next = node->kind == MENU_KIND_SYSTEM ? node->handler(input)
+                                                           : move(transitions[node->kind][input.type], input);
 
-static void idle_display_show(void) {
-    lcd_send_request(0,3, "ThermoPlate");
+    if (next != current_state)
+        current_state = enter(next);
+    nodes[current_state].render();
 }
 
-typedef void (*menu_drawing_callback)(void);
-const struct {
-    invalidator_state_handler state_handler;
-    menu_drawing_callback drawing;
-    } state_table[] = {
-     [MENU_STATE_INIT] = {handle_idle_state, idle_display_show},
-     [MENU_STATE_PREEMPTED] = {handle_preempted_state, show_preempt_display},
-     [MENU_STATE_HEATING_CONSTANT] = {handle_heating_state, show_heating_constant_display},
-     [MENU_STATE_HEATING_CONSTANT_TEMPERATURE_SET] = {handle_temperature_set, NULL},
-     [MENU_STATE_HEATING_CONSTANT_TIME_SET] = {handle_time_set, NULL},
-     [MENU_STATE_HEATING_JEDEC] = {handle_heating_state, show_jedec_display},
-     [MENU_STATE_WAIT] = {handle_wait_state, show_running_state},
-     [MENU_STATE_DONE] = {handle_idle_state, show_done_state},
-};
+// Timer driven events may still be queued once the state they were meant for is left
+static bool is_stale_event(menu_event_t event) {
+    switch (event.type) {
+        case MENU_EVENT_STATUS_TICK:
+            return nodes[current_state].kind != MENU_KIND_ACTION;
 
-static menu_state
-menu_process(menu_state input) {
-     current_state = state_table[current_state].state_handler(input);
+        case MENU_EVENT_REDRAW:
+            return !value_redraw.is_pending || nodes[current_state].kind != MENU_KIND_VALUE;
 
-     if (NULL != state_table[current_state].drawing)
-        state_table[current_state].drawing();
-
-     return current_state;
+        default:
+            break;
+    }
+    return event.type >= MENU_EVENT_ENCODER_LAST;
 }
 
 void handle_incoming_requests(void* args) {
-    menu_event_type* event = args;
+    menu_event_t* event = args;
+    if (is_stale_event(*event))
+        return;
     menu_process(*event);
 }
 
 void menu_init(void) {
-    idle_display_show();
-    current_state = MENU_STATE_INIT;
+    stop_status_updates();
+    reset_value_redraw();
+    for (menu_state state = 0; state < MENU_STATE_LAST; state++)
+        values[state] = nodes[state].minimum;
+    display.is_shown = false;
+    current_state    = MENU_STATE_INIT;
+    show_idle();
     scheduler_subscribe(SchedulerQueueMenu, handle_incoming_requests);
 }
-
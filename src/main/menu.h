@@ -25,12 +25,21 @@ typedef enum {
     MENU_EVENT_ENCODER_UP,
     MENU_EVENT_ENCODER_DOWN,
     MENU_EVENT_ENCODER_PUSH,
+    MENU_EVENT_ENCODER_BACK,   // double click
+    MENU_EVENT_ENCODER_CANCEL, // long press
     MENU_EVENT_PREEMPT_REQUEST,
     MENU_EVENT_PREEMPT_TAKE,
     MENU_EVENT_REQUEST_DONE,
+    MENU_EVENT_STATUS_TICK,
+    MENU_EVENT_REDRAW,
     MENU_EVENT_ENCODER_LAST
 } menu_event_type;
 
+typedef struct {
+    menu_event_type type;
+    unsigned        velocity; // detents per second of encoder turns, 0 for anything else
+} menu_event_t;
+
 void menu_init(void);
 
 #ifdef __cplusplus
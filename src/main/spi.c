@@ -22,24 +22,99 @@
 #include "spi.h"
 
 #include <limits.h>
+#include <stdatomic.h>
 #include <string.h>
 
 #include "driver/spi_common.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
+#include "nvs.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_INFO
+#include "utilities/logger.h"
+#include "utilities/timer.h"
+#include "thermocouple_definitions.h"
+#include "thermocouple_type_k.h"
 
-#define SPI_CLOCK_SOURCE 500000UL
 #define SPI_HOST SPI2_HOST
 #define SPI_MISO 7
 #define AFE_SPI_CS 5
 #define SPI_SCLK 10
+// A read the driver doesn't give back stays with its device handle, which is
+// added once more for the next read, the spare slot frees the abandoned one.
+#define SPI_ASYNC_READ_SLOTS 2U
+
+typedef struct {
+    spi_transaction_t   transaction;
+    spi_device_handle_t handle; // device the transaction was queued on, NULL while free
+    WORD_ALIGNED_ATTR uint8_t frame[THERMOCOUPLE_MAX_FRAME];
+} spi_async_slot_t;
+
+typedef struct {
+    spi_async_slot_t      slot[SPI_ASYNC_READ_SLOTS];
+    spi_async_slot_t*     active;
+    spi_read_completion_t completion;
+    void*                 context;
+    atomic_bool           is_pending;
+    atomic_bool           is_delivery_lost; // done, but the delivery couldn't be pended
+    TickType_t            queued;
+} spi_async_read_t;
 
 static spi_device_handle_t spi_handle[SpiDeviceLast];
+static spi_device_interface_config_t device_config[SpiDeviceLast];
+static spi_async_read_t async_read[SpiDeviceLast];
+static const thermocouple_driver_t* afe_driver;
+
+static void on_transaction_done(spi_transaction_t* transaction);
+
+static bool is_afe_driver_wired(const thermocouple_driver_t* driver) {
+    return THERMOCOUPLE_SPI_MOSI >= 0 || !thermocouple_driver_needs_mosi(driver);
+}
+
+// An amplifier taking commands would never see them with MOSI unconnected and
+// would read back garbage, such a stored id is refused for the built in one.
+static thermocouple_driver_id select_afe_driver(void) {
+    thermocouple_driver_id id = THERMOCOUPLE_DRIVER;
+    nvs_handle_t handle;
+    uint8_t stored = THERMOCOUPLE_DRIVER_LAST;
+
+    if (THERMOCOUPLE_DRIVER_FROM_NVS && ESP_OK == nvs_open("thermocouple", NVS_READONLY, &handle)) {
+        if (ESP_OK == nvs_get_u8(handle, "driver", &stored) && stored < THERMOCOUPLE_DRIVER_LAST) {
+            is_afe_driver_wired(thermocouple_driver_get(stored)) ? ({id = (thermocouple_driver_id) stored;}) :
+                ({log_error("%s needs MOSI, which isn't wired", thermocouple_driver_get(stored)->name);});
+        }
+        nvs_close(handle);
+    }
+    return id;
+}
+
+static error_status_t setup_afe(void) {
+    if (!afe_driver->setup_length)
+        return ERROR_ANY;
+
+    spi_transaction_t t = {
+        .length = afe_driver->setup_length * CHAR_BIT,
+        .flags = SPI_TRANS_USE_TXDATA,
+    };
+    memcpy(t.tx_data, afe_driver->setup, afe_driver->setup_length);
+    return ESP_OK == spi_device_transmit(spi_handle[SpiDeviceThermocoupleAfe], &t) ?
+        ERROR_ANY : ERROR_COMMUNICATION_ERROR;
+}
 
 error_status_t spi_init(void) {
+    afe_driver = thermocouple_driver_get(select_afe_driver());
+    log_info("Thermocouple amplifier: %s", afe_driver->name);
+    if (!is_afe_driver_wired(afe_driver)) {
+        log_error("%s needs MOSI, which isn't wired", afe_driver->name);
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+
     spi_bus_config_t buscfg = {
         .miso_io_num = SPI_MISO,
-        .mosi_io_num = -1,
+        .mosi_io_num = THERMOCOUPLE_SPI_MOSI,
         .sclk_io_num = SPI_SCLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
@@ -51,22 +126,26 @@ error_status_t spi_init(void) {
     struct {
         unsigned pin;
         uint32_t flags;
+        const thermocouple_driver_t* driver;
     } device_map[SpiDeviceLast] = {
-        {AFE_SPI_CS, SPI_DEVICE_HALFDUPLEX}
-    };
-    spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = SPI_CLOCK_SOURCE,
-        .mode = 0,
-        .queue_size = 4,
+        {AFE_SPI_CS, SPI_DEVICE_HALFDUPLEX, afe_driver}
     };
     for (spi_dev_t dev = SpiDeviceThermocoupleAfe; dev < SpiDeviceLast; dev++) {
-        devcfg.spics_io_num = device_map[dev].pin;
-        devcfg.flags = device_map[dev].flags;
-        if (ESP_OK != spi_bus_add_device(SPI_HOST, &devcfg, &spi_handle[dev])) {
+        device_config[dev] = (spi_device_interface_config_t) {
+            .spics_io_num     = device_map[dev].pin,
+            .flags            = device_map[dev].flags,
+            .clock_speed_hz   = device_map[dev].driver->clock_hz,
+            .mode             = device_map[dev].driver->mode,
+            .cs_ena_pretrans  = device_map[dev].driver->cs_setup_cycles,
+            .cs_ena_posttrans = device_map[dev].driver->cs_hold_cycles,
+            .queue_size       = 4,
+            .post_cb          = on_transaction_done,
+        };
+        if (ESP_OK != spi_bus_add_device(SPI_HOST, &device_config[dev], &spi_handle[dev])) {
             goto error;
         }
     }
-    return ERROR_ANY;
+    return setup_afe();
 
 error:
     for (spi_dev_t dev = SpiDeviceThermocoupleAfe; dev < SpiDeviceLast; dev++) {
@@ -75,32 +154,164 @@ error:
     return ERROR_RESOURCE_UNAVAILABLE;
 }
 
-typedef bool(*spi_readout_conventer_t)(uint8_t*, size_t, uint16_t*);
+const thermocouple_driver_t* spi_thermocouple_driver(void) {
+    return afe_driver;
+}
 
-bool afe_readout_to_temperature(uint8_t *read_buffer, size_t read_buffer_length, uint16_t* out) {
-    read_buffer_length != 2 ? ({return false;}) : ({});
-    uint16_t casted_temp = (read_buffer[0] << 8) | read_buffer[1];
-    ((casted_temp & 0x4) >> 2) == 1 ? ({return false;}) : ({});
+// Command, if any, goes out in the write phase, the frame comes back in the
+// read phase of the same half duplex transaction.
+static spi_transaction_t read_transaction(uint8_t* frame, void* user) {
+    spi_transaction_t t = {
+        .length = afe_driver->command_length * CHAR_BIT,
+        .rxlength = afe_driver->frame_length * CHAR_BIT,
+        .rx_buffer = frame,
+        .flags = afe_driver->command_length ? SPI_TRANS_USE_TXDATA : 0,
+        .user = user,
+    };
+    memcpy(t.tx_data, afe_driver->command, afe_driver->command_length);
+    return t;
+}
 
-    *out = (((casted_temp & 0x7FF8) >> 3) / 4);
-    return true;
+// Amplifiers reporting the EMF are linearized with the NIST tables instead of
+// trusting their own, mostly linear, approximation.
+static error_status_t convert_readout(const uint8_t* frame, thermocouple_reading_t* reading) {
+    if (!thermocouple_decode(afe_driver, frame, reading))
+        return ERROR_CONVERSION_ERROR;
+    reading->has_voltage ? ({reading->hot = type_k_compensate(reading->voltage, reading->cold_junction);}) : ({});
+    return ERROR_ANY;
 }
 
 error_status_t spi_read(spi_dev_t device, void* out_data, size_t size) {
-    const struct {
-        spi_readout_conventer_t conventer;
-        size_t message_size;
-    } conveter_map[SpiDeviceLast] = {
-        {afe_readout_to_temperature, sizeof(uint16_t)}
-    };
+    device >= SpiDeviceLast || size < sizeof(thermocouple_reading_t) ?
+    ({return ERROR_INVALID_INPUT_PARAMETER;}) : ({});
+    atomic_load(&async_read[device].is_pending) ? ({return ERROR_ACTION_ALREADY_REQUESTED;}) : ({});
 
-    spi_transaction_t t = {
-        .cmd = 0,
-        .rxlength = conveter_map[device].message_size * CHAR_BIT,
-        .flags = SPI_TRANS_USE_RXDATA,
-    };
-    spi_device_polling_transmit(spi_handle[device], &t) != ESP_OK ? ({return ERROR_COMMUNICATION_ERROR;}) : ({});
-    return conveter_map[device].conventer(t.rx_data, conveter_map[device].message_size, out_data) ?
-        ERROR_ANY : ERROR_CONVERSION_ERROR;
+    WORD_ALIGNED_ATTR uint8_t frame[THERMOCOUPLE_MAX_FRAME];
+    spi_transaction_t t = read_transaction(frame, NULL);
+    spi_device_transmit(spi_handle[device], &t) != ESP_OK ? ({return ERROR_COMMUNICATION_ERROR;}) : ({});
+    return convert_readout(frame, out_data);
 }
 
+// The driver refuses to remove a device with a transaction queued or in
+// flight, an abandoned slot is freed once the driver gave its frame back.
+static void reclaim_slot(spi_async_slot_t* slot) {
+    spi_transaction_t* done = NULL;
+
+    spi_device_get_trans_result(slot->handle, &done, 0);
+    if (ESP_OK == spi_bus_remove_device(slot->handle))
+        slot->handle = NULL;
+}
+
+// Runs in the timer task, the driver requires the finished transaction to be
+// collected with spi_device_get_trans_result() before the next one is queued.
+// Both the pended delivery and spi_collect_async() end up here, whichever
+// comes second finds nothing to collect and leaves the read alone.
+static void deliver_async_read(void* arg, uint32_t device) {
+    spi_async_read_t* read = &async_read[device];
+    spi_async_slot_t* slot = arg;
+    spi_transaction_t* done = NULL;
+    thermocouple_reading_t reading = { 0 };
+    error_status_t status = ERROR_COMMUNICATION_ERROR;
+
+    if (slot != read->active) {
+        slot->handle != NULL ? ({reclaim_slot(slot);}) : ({});
+        return;
+    }
+    // Still owned by the driver, the frame and transaction can't be reused yet
+    if (ESP_OK != spi_device_get_trans_result(slot->handle, &done, 0))
+        return;
+    if (done == &slot->transaction)
+        status = convert_readout(slot->frame, &reading);
+
+    spi_read_completion_t completion = read->completion;
+    void* context = read->context;
+    slot->handle = NULL;
+    read->active = NULL;
+    atomic_store(&read->is_delivery_lost, false);
+    atomic_store(&read->is_pending, false);
+    completion(device, status, &reading, context);
+}
+
+// Runs in the SPI interrupt. The bus isn't allocated with ESP_INTR_FLAG_IRAM,
+// so this and the flash resident timer_soft_irq() don't have to be in IRAM.
+// The timer command queue is shared with every tick and oneshot, a delivery it
+// had no room for is left to spi_collect_async().
+static void on_transaction_done(spi_transaction_t* transaction) {
+    spi_async_slot_t* slot = transaction->user;
+
+    if (slot == NULL)
+        return;
+
+    const uint32_t device = (uint32_t) ((slot - async_read[0].slot) / SPI_ASYNC_READ_SLOTS);
+    if (ERROR_ANY != timer_soft_irq(deliver_async_read, slot, device))
+        atomic_store(&async_read[device].is_delivery_lost, true);
+}
+
+// Nothing came back within the timeout, most likely an interrupt got lost. The
+// read is given up without its completion, the slot keeps the old handle until
+// the driver lets go of the transaction and the next read goes to a new one.
+static error_status_t abandon_async_read(spi_dev_t device) {
+    spi_async_read_t* read = &async_read[device];
+    spi_device_handle_t handle;
+
+    if (ESP_OK != spi_bus_add_device(SPI_HOST, &device_config[device], &handle)) {
+        log_error("SPI device %d wedged and can't be added again", device);
+        return ERROR_TIMEOUT;
+    }
+    log_error("SPI device %d read timed out, device added again", device);
+    spi_handle[device] = handle;
+    reclaim_slot(read->active);
+    read->active = NULL;
+    atomic_store(&read->is_delivery_lost, false);
+    atomic_store(&read->is_pending, false);
+    return ERROR_TIMEOUT;
+}
+
+error_status_t spi_collect_async(spi_dev_t device) {
+    device >= SpiDeviceLast ? ({return ERROR_INVALID_INPUT_PARAMETER;}) : ({});
+
+    spi_async_read_t* read = &async_read[device];
+    for (unsigned i = 0; i < SPI_ASYNC_READ_SLOTS; i++) {
+        spi_async_slot_t* slot = &read->slot[i];
+        slot != read->active && slot->handle != NULL ? ({reclaim_slot(slot);}) : ({});
+    }
+    if (!atomic_load(&read->is_pending))
+        return ERROR_ANY;
+
+    const bool is_overdue = xTaskGetTickCount() - read->queued >= pdMS_TO_TICKS(SPI_ASYNC_READ_TIMEOUT_MS);
+    if (atomic_load(&read->is_delivery_lost) || is_overdue)
+        deliver_async_read(read->active, device);
+    return atomic_load(&read->is_pending) && is_overdue ? abandon_async_read(device) : ERROR_ANY;
+}
+
+error_status_t spi_read_async(spi_dev_t device, spi_read_completion_t completion, void* context) {
+    device >= SpiDeviceLast || completion == NULL ? ({return ERROR_INVALID_INPUT_PARAMETER;}) : ({});
+
+    spi_async_read_t* read = &async_read[device];
+    bool is_idle = false;
+    !atomic_compare_exchange_strong(&read->is_pending, &is_idle, true) ?
+    ({return ERROR_ACTION_ALREADY_REQUESTED;}) : ({});
+
+    spi_async_slot_t* slot = NULL;
+    for (unsigned i = 0; i < SPI_ASYNC_READ_SLOTS && slot == NULL; i++) {
+        slot = read->slot[i].handle == NULL ? &read->slot[i] : NULL;
+    }
+    if (slot == NULL) {
+        atomic_store(&read->is_pending, false);
+        return ERROR_RESOURCE_UNAVAILABLE;
+    }
+
+    read->completion   = completion;
+    read->context      = context;
+    read->queued       = xTaskGetTickCount();
+    read->active       = slot;
+    slot->transaction  = read_transaction(slot->frame, slot);
+    slot->handle       = spi_handle[device];
+    if (ESP_OK != spi_device_queue_trans(slot->handle, &slot->transaction, 0)) {
+        slot->handle = NULL;
+        read->active = NULL;
+        atomic_store(&read->is_pending, false);
+        return ERROR_COMMUNICATION_ERROR;
+    }
+    return ERROR_ANY;
+}
@@ -23,14 +23,33 @@
 #define _MAIN_SPI_
 
 #include "utilities/error.h"
+#include "thermocouple_driver.h"
 #include <stddef.h>
 
+// An asynchronous read still in flight after this long is given up
+#define SPI_ASYNC_READ_TIMEOUT_MS 100U
+
 typedef enum {
     SpiDeviceThermocoupleAfe,
     SpiDeviceLast
 } spi_dev_t;
 
+// Called from the timer task once the transaction finished, data holds the
+// decoded readout (thermocouple_reading_t for the thermocouple) and is valid
+// only during the call.
+typedef void (*spi_read_completion_t)(spi_dev_t device, error_status_t status, const void* data, void* context);
+
 error_status_t spi_init(void);
+// Amplifier selected at build time or from NVS, valid after spi_init()
+const thermocouple_driver_t* spi_thermocouple_driver(void);
+// Blocks the calling task until the transaction is done, doesn't spin on the bus
 error_status_t spi_read(spi_dev_t device,  void* out_data, size_t size);
+// Queues the transaction and returns at once, one transaction per device can be
+// in flight while different devices are pipelined on the bus.
+error_status_t spi_read_async(spi_dev_t device, spi_read_completion_t completion, void* context);
+// Timer task only. Delivers a finished read whose completion the interrupt
+// couldn't pend. One the driver still holds after SPI_ASYNC_READ_TIMEOUT_MS is
+// given up without its completion, ERROR_TIMEOUT, and the next read can be queued.
+error_status_t spi_collect_async(spi_dev_t device);
 
 #endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "status_screen.h"
+
+#define STATUS_SCREEN_MAX_MINUTES 99U
+
+static void render_temperature(const status_screen_t* status, lcd_framebuffer_t* screen) {
+    if (!status->has_temperature) {
+        lcd_framebuffer_print(screen, 0, 0, "---.-C");
+        return;
+    }
+    // A plate below freezing is a wiring fault the sampler already reports
+    int tenths = status->temperature <= 0 ? 0 : (status->temperature * 10 + TEMPERATURE_ONE / 2) / TEMPERATURE_ONE;
+    lcd_framebuffer_print(screen, 0, 0, "%3d.%dC", tenths / 10, tenths % 10);
+}
+
+void status_screen_render(const status_screen_t* status, lcd_framebuffer_t* screen) {
+    lcd_framebuffer_clear(screen);
+    render_temperature(status, screen);
+    if (!status->is_heating) {
+        lcd_framebuffer_print(screen, 0, 7, "/---C");
+        lcd_framebuffer_print(screen, 1, 0, "P --%%  ETA --:--");
+        return;
+    }
+
+    unsigned minutes = status->remaining / 60;
+    lcd_framebuffer_print(screen, 0, 7, "/%3uC S%u", status->setpoint, status->stage + 1);
+    lcd_framebuffer_print(screen, 1, 0, "P%3u%%  ETA %02u:%02u", status->power > 100 ? 100 : status->power,
+                          minutes > STATUS_SCREEN_MAX_MINUTES ? STATUS_SCREEN_MAX_MINUTES : minutes,
+                          minutes > STATUS_SCREEN_MAX_MINUTES ? 59 : status->remaining % 60);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_STATUS_SCREEN_
+#define _MAIN_STATUS_SCREEN_
+
+#include <stdbool.h>
+#include "lcd_framebuffer.h"
+#include "temperature.h"
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool          has_temperature; // a sample young enough to show
+    temperature_t temperature;
+    bool          is_heating;      // false until the first control window and once done
+    celcius       setpoint;
+    unsigned      power;           // percent
+    unsigned      stage;           // counted from 0 as the heat controller does
+    seconds       remaining;
+} status_screen_t;
+
+// 183.5C /245C S2
+// P 45%  ETA 02:31
+// Fields without data are dashed, the layout never moves so the LCD diff only
+// rewrites the digits that changed.
+void status_screen_render(const status_screen_t* status, lcd_framebuffer_t* screen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MAIN_STATUS_SCREEN_
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_TEMPERATURE_
+#define _MAIN_TEMPERATURE_
+
+#include <stdint.h>
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Signed Q10.2 fixed point, the native 0.25 degC step of the thermocouple
+// amplifiers, spanning -8192..8191.75 degC.
+typedef int16_t temperature_t;
+
+#define TEMPERATURE_FRACTION_BITS 2
+#define TEMPERATURE_ONE           (1 << TEMPERATURE_FRACTION_BITS)
+#define TEMPERATURE_CENTI_MAX     INT16_MAX
+
+static inline temperature_t temperature_from_celcius(celcius value) {
+    return (temperature_t) (value << TEMPERATURE_FRACTION_BITS);
+}
+
+static inline float temperature_to_float(temperature_t value) {
+    return (float) value / (float) TEMPERATURE_ONE;
+}
+
+// Bluetooth SIG Temperature characteristic (0x2A6E) is sint16 in 0.01 degC,
+// saturated at +-327.67 degC.
+static inline int16_t temperature_to_centi(temperature_t value) {
+    int32_t centi = (int32_t) value * 100 / TEMPERATURE_ONE;
+    return (int16_t) (centi > TEMPERATURE_CENTI_MAX ? TEMPERATURE_CENTI_MAX :
+                      centi < -TEMPERATURE_CENTI_MAX ? -TEMPERATURE_CENTI_MAX : centi);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_TEMPERATURE_
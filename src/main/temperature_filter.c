@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "temperature_filter.h"
+
+#include <string.h>
+
+void temperature_filter_init(temperature_filter_t* filter, temperature_filter_params_t parameters) {
+    memset(filter, 0, sizeof(*filter));
+    parameters.median_window = parameters.median_window == 0 ? 1 :
+                               parameters.median_window > TEMPERATURE_FILTER_MAX_MEDIAN ?
+                               TEMPERATURE_FILTER_MAX_MEDIAN : parameters.median_window | 1U;
+    parameters.iir_shift     = parameters.iir_shift > 15 ? 15 : parameters.iir_shift;
+    filter->parameters       = parameters;
+}
+
+static temperature_t median_of(temperature_filter_t* filter, temperature_t sample) {
+    const unsigned window = filter->parameters.median_window;
+    temperature_t sorted[TEMPERATURE_FILTER_MAX_MEDIAN];
+
+    filter->window[filter->head] = sample;
+    filter->head  = (filter->head + 1) % window;
+    filter->count = filter->count < window ? filter->count + 1 : window;
+
+    // Insertion sort, at most seven elements
+    for (unsigned i = 0; i < filter->count; i++) {
+        temperature_t value = filter->window[i];
+        unsigned j = i;
+        for (; j > 0 && sorted[j - 1] > value; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = value;
+    }
+    return sorted[filter->count / 2];
+}
+
+static temperature_t iir_of(temperature_filter_t* filter, temperature_t sample) {
+    const int32_t input = (int32_t) sample * (1 << TEMPERATURE_FILTER_IIR_GUARD);
+    const int32_t half  = 1 << (TEMPERATURE_FILTER_IIR_GUARD - 1);
+
+    if (!filter->is_primed) {
+        filter->iir_state = input;
+        filter->is_primed = true;
+    }
+    filter->iir_state += (input - filter->iir_state) / (1 << filter->parameters.iir_shift);
+    return (temperature_t) ((filter->iir_state + (filter->iir_state < 0 ? -half : half))
+                            / (1 << TEMPERATURE_FILTER_IIR_GUARD));
+}
+
+temperature_t temperature_filter_apply(temperature_filter_t* filter, temperature_t sample) {
+    temperature_t median = filter->parameters.median_window > 1 ? median_of(filter, sample) : sample;
+
+    return filter->parameters.iir_shift ? iir_of(filter, median) : median;
+}
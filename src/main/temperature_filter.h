@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_TEMPERATURE_FILTER_
+#define _MAIN_TEMPERATURE_FILTER_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "temperature.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMPERATURE_FILTER_MAX_MEDIAN 7U
+// Extra fraction bits kept by the IIR state, so small steps aren't lost to rounding
+#define TEMPERATURE_FILTER_IIR_GUARD  8
+
+typedef struct {
+    unsigned median_window; // odd, 1 disables the median stage
+    unsigned iir_shift;     // smoothing factor 1 / 2^shift, 0 disables the IIR stage
+} temperature_filter_params_t;
+
+typedef struct {
+    temperature_filter_params_t parameters;
+    temperature_t               window[TEMPERATURE_FILTER_MAX_MEDIAN];
+    unsigned                    head;
+    unsigned                    count;
+    int32_t                     iir_state;
+    bool                        is_primed;
+} temperature_filter_t;
+
+void temperature_filter_init(temperature_filter_t* filter, temperature_filter_params_t parameters);
+// Median of the last median_window samples, rejecting single sample spikes,
+// followed by a first order IIR, integer only.
+temperature_t temperature_filter_apply(temperature_filter_t* filter, temperature_t sample);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_TEMPERATURE_FILTER_
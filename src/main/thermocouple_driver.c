@@ -0,0 +1,152 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "thermocouple_driver.h"
+
+#include <string.h>
+
+static int32_t sign_extend(uint32_t value, unsigned bits) {
+    const uint32_t sign = 1UL << (bits - 1);
+    value &= (1UL << bits) - 1;
+    return (int32_t) (value ^ sign) - (int32_t) sign;
+}
+
+// Rounds value in 1 / 2^fraction_bits degC down to the 0.25 degC of temperature_t
+static temperature_t to_temperature(int32_t value, unsigned fraction_bits) {
+    const int32_t divisor = 1L << (fraction_bits - TEMPERATURE_FRACTION_BITS);
+    return (temperature_t) (value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor));
+}
+
+// D15 dummy, D14..D3 temperature in 0.25 degC, D2 open thermocouple
+static void decode_max6675(const uint8_t* frame, thermocouple_reading_t* reading) {
+    const uint16_t word = (uint16_t) (frame[0] << 8 | frame[1]);
+
+    reading->hot    = (temperature_t) ((word & 0x7FF8) >> 3);
+    reading->faults = word & 0x0004 ? THERMOCOUPLE_FAULT_OPEN : 0;
+}
+
+// D31..D18 thermocouple in 0.25 degC, D16 fault, D15..D4 cold junction in
+// 0.0625 degC, D2..D0 short to VCC, short to GND, open. The part assumes a
+// constant 41.276 uV/degC, the EMF it measured is recovered from that.
+static void decode_max31855(const uint8_t* frame, thermocouple_reading_t* reading) {
+    const uint32_t word = (uint32_t) frame[0] << 24 | (uint32_t) frame[1] << 16 | (uint32_t) frame[2] << 8 | frame[3];
+    const int32_t hot   = sign_extend(word >> 18, 14);
+    const int32_t cold  = sign_extend(word >> 4, 12);
+
+    reading->hot               = (temperature_t) hot;
+    reading->cold_junction     = to_temperature(cold, 4);
+    reading->has_cold_junction = true;
+    reading->voltage           = (hot * 4 - cold) * 41276L / 16000L;
+    reading->has_voltage       = true;
+    reading->faults            = !(word & 0x10000) ? 0 :
+                                 (word & 0x1 ? THERMOCOUPLE_FAULT_OPEN : 0)
+                                 | (word & 0x2 ? THERMOCOUPLE_FAULT_SHORT_TO_GND : 0)
+                                 | (word & 0x4 ? THERMOCOUPLE_FAULT_SHORT_TO_VCC : 0);
+}
+
+// Registers 0x0A..0x0F: CJTH, CJTL with the cold junction in 2^-6 degC,
+// LTCBH, LTCBM, LTCBL with the thermocouple in 2^-7 degC, then SR
+static void decode_max31856(const uint8_t* frame, thermocouple_reading_t* reading) {
+    const uint32_t cold = (uint32_t) frame[0] << 8 | frame[1];
+    const uint32_t hot  = (uint32_t) frame[2] << 16 | (uint32_t) frame[3] << 8 | frame[4];
+    const uint8_t status = frame[5];
+
+    reading->hot               = to_temperature(sign_extend(hot >> 5, 19), 7);
+    reading->cold_junction     = to_temperature(sign_extend(cold >> 2, 14), 6);
+    reading->has_cold_junction = true;
+    reading->faults            = (status & 0x01 ? THERMOCOUPLE_FAULT_OPEN : 0)
+                                 | (status & 0x02 ? THERMOCOUPLE_FAULT_OVER_UNDER_VOLTAGE : 0)
+                                 | (status & 0x4C ? THERMOCOUPLE_FAULT_OUT_OF_RANGE : 0)
+                                 | (status & 0xB0 ? THERMOCOUPLE_FAULT_COLD_JUNCTION_RANGE : 0);
+}
+
+// Same frame in voltage mode: LTCB holds the EMF with 1 LSB = 1 / (8 * 1.6 * 2^17) V
+static void decode_max31856_voltage(const uint8_t* frame, thermocouple_reading_t* reading) {
+    const uint32_t code = (uint32_t) frame[2] << 16 | (uint32_t) frame[3] << 8 | frame[4];
+
+    decode_max31856(frame, reading);
+    reading->hot         = 0;
+    reading->voltage     = (int32_t) ((int64_t) sign_extend(code >> 5, 19) * 78125 / (1L << 17));
+    reading->has_voltage = true;
+}
+
+static const thermocouple_driver_t drivers[THERMOCOUPLE_DRIVER_LAST] = {
+    [THERMOCOUPLE_MAX6675] = {
+        .name            = "MAX6675",
+        .decode          = decode_max6675,
+        .frame_length    = 2,
+        .clock_hz        = 500000UL,
+        .mode            = 0,
+        .conversion_time = 220,
+    },
+    [THERMOCOUPLE_MAX31855] = {
+        .name            = "MAX31855",
+        .decode          = decode_max31855,
+        .frame_length    = 4,
+        .clock_hz        = 4000000UL,
+        .mode            = 0,
+        .cs_setup_cycles = 1,
+        .conversion_time = 100,
+    },
+    [THERMOCOUPLE_MAX31856] = {
+        .name            = "MAX31856",
+        .decode          = decode_max31856,
+        .frame_length    = 6,
+        .command_length  = 1,
+        .command         = { 0x0A },
+        // CR0: automatic conversion, open circuit detection enabled
+        .setup_length    = 2,
+        .setup           = { 0x80, 0x90 },
+        .clock_hz        = 4000000UL,
+        .mode            = 1,
+        .cs_setup_cycles = 1,
+        .cs_hold_cycles  = 1,
+        .conversion_time = 100,
+    },
+    [THERMOCOUPLE_MAX31856_VOLTAGE] = {
+        .name            = "MAX31856 voltage",
+        .decode          = decode_max31856_voltage,
+        .frame_length    = 6,
+        .command_length  = 1,
+        .command         = { 0x0A },
+        // CR0 as above, CR1: voltage mode with gain 8, +-78 mV full scale
+        .setup_length    = 3,
+        .setup           = { 0x80, 0x90, 0x08 },
+        .clock_hz        = 4000000UL,
+        .mode            = 1,
+        .cs_setup_cycles = 1,
+        .cs_hold_cycles  = 1,
+        .conversion_time = 100,
+    },
+};
+
+const thermocouple_driver_t* thermocouple_driver_get(thermocouple_driver_id id) {
+    return id < THERMOCOUPLE_DRIVER_LAST ? &drivers[id] : NULL;
+}
+
+bool thermocouple_driver_needs_mosi(const thermocouple_driver_t* driver) {
+    return driver->command_length || driver->setup_length;
+}
+
+bool thermocouple_decode(const thermocouple_driver_t* driver, const uint8_t* frame, thermocouple_reading_t* reading) {
+    memset(reading, 0, sizeof(*reading));
+    driver->decode(frame, reading);
+    return reading->faults == 0;
+}
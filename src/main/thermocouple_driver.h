@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_THERMOCOUPLE_DRIVER_
+#define _MAIN_THERMOCOUPLE_DRIVER_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "temperature.h"
+#include "utilities/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define THERMOCOUPLE_MAX_FRAME   8U
+#define THERMOCOUPLE_MAX_COMMAND 3U
+
+typedef enum {
+    THERMOCOUPLE_MAX6675,
+    THERMOCOUPLE_MAX31855,
+    THERMOCOUPLE_MAX31856,
+    THERMOCOUPLE_MAX31856_VOLTAGE, // raw EMF, linearized by thermocouple_type_k.c
+    THERMOCOUPLE_DRIVER_LAST
+} thermocouple_driver_id;
+
+typedef enum {
+    THERMOCOUPLE_FAULT_OPEN                = 1 << 0,
+    THERMOCOUPLE_FAULT_SHORT_TO_GND        = 1 << 1,
+    THERMOCOUPLE_FAULT_SHORT_TO_VCC        = 1 << 2,
+    THERMOCOUPLE_FAULT_OUT_OF_RANGE        = 1 << 3,
+    THERMOCOUPLE_FAULT_COLD_JUNCTION_RANGE = 1 << 4,
+    THERMOCOUPLE_FAULT_OVER_UNDER_VOLTAGE  = 1 << 5,
+} thermocouple_fault;
+
+typedef struct {
+    temperature_t hot;           // cold junction compensated, as linearized by the amplifier
+    temperature_t cold_junction; // amplifier die temperature, when reported
+    int32_t       voltage;       // thermocouple EMF in uV, when reported
+    bool          has_cold_junction;
+    bool          has_voltage;
+    uint8_t       faults;        // thermocouple_fault bits
+} thermocouple_reading_t;
+
+typedef void (*thermocouple_decoder_t)(const uint8_t* frame, thermocouple_reading_t* reading);
+
+typedef struct {
+    const char*            name;
+    thermocouple_decoder_t decode;
+    uint8_t                frame_length;   // bytes clocked in per readout
+    uint8_t                command_length; // bytes clocked out before the frame, 0 for read only parts
+    uint8_t                command[THERMOCOUPLE_MAX_COMMAND];
+    uint8_t                setup_length;   // register write issued once after the device is added
+    uint8_t                setup[THERMOCOUPLE_MAX_COMMAND];
+    uint32_t               clock_hz;
+    uint8_t                mode;           // SPI mode, CPOL << 1 | CPHA
+    uint8_t                cs_setup_cycles;
+    uint8_t                cs_hold_cycles;
+    miliseconds            conversion_time;
+} thermocouple_driver_t;
+
+// NULL for an unknown id
+const thermocouple_driver_t* thermocouple_driver_get(thermocouple_driver_id id);
+// True for amplifiers that are written to and so can't work without MOSI
+bool thermocouple_driver_needs_mosi(const thermocouple_driver_t* driver);
+// Decodes a frame of driver->frame_length bytes, false when the amplifier reports a fault
+bool thermocouple_decode(const thermocouple_driver_t* driver, const uint8_t* frame, thermocouple_reading_t* reading);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_THERMOCOUPLE_DRIVER_
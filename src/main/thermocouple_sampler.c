@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#define LOGGER_OUTPUT_LEVEL LOG_OUTPUT_INFO
+#include "utilities/logger.h"
+
+#include "thermocouple_sampler.h"
+
+#include <stdatomic.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "spi.h"
+#include "temperature_filter.h"
+#include "utilities/timer.h"
+
+// Samples are written by the timer task only and read from any task. The
+// writer fills the slot readers are not pointed at and then publishes its
+// sequence number, so a reader preempting an unfinished write still copies the
+// previous complete sample instead of spinning on it.
+static struct {
+    thermocouple_sample_t slots[2];
+    atomic_uint           published; // sequence of the newest complete sample, selects its slot
+    atomic_uint           failures;
+    temperature_filter_t  filter;
+} ctx;
+
+static miliseconds now(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static void publish(temperature_t raw) {
+    unsigned sequence = atomic_load_explicit(&ctx.published, memory_order_relaxed) + 1;
+
+    ctx.slots[sequence & 1U] = (thermocouple_sample_t) {
+        .temperature = temperature_filter_apply(&ctx.filter, raw),
+        .raw         = raw,
+        .timestamp   = now(),
+        .sequence    = sequence,
+    };
+    atomic_store_explicit(&ctx.published, sequence, memory_order_release);
+}
+
+static void on_readout(spi_dev_t device, error_status_t status, const void* data, void* args) {
+    if (ERROR_ANY != status) {
+        atomic_fetch_add_explicit(&ctx.failures, 1, memory_order_relaxed);
+        return;
+    }
+    publish(((const thermocouple_reading_t*) data)->hot);
+}
+
+// One transaction per conversion: reading sooner would abort the conversion in
+// progress and return the previous value again. A readout whose delivery got
+// lost is collected first, late but without wedging the sampler.
+static void on_sample_tick(void* args) {
+    if (ERROR_ANY != spi_collect_async(SpiDeviceThermocoupleAfe) ||
+        ERROR_ANY != spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL))
+        atomic_fetch_add_explicit(&ctx.failures, 1, memory_order_relaxed);
+}
+
+error_status_t thermocouple_sampler_start(void) {
+    if (periodic_get_period(thermocouple_sampler_tick) < spi_thermocouple_driver()->conversion_time) {
+        log_error("Thermocouple sampled faster than it converts");
+        return ERROR_INVALID_STATE;
+    }
+    temperature_filter_init(&ctx.filter, (temperature_filter_params_t) {
+        .median_window = THERMOCOUPLE_MEDIAN_WINDOW,
+        .iir_shift     = THERMOCOUPLE_IIR_SHIFT,
+    });
+    return timer_register_callback(thermocouple_sampler_tick, on_sample_tick, NULL);
+}
+
+// The slot a reader copies is only rewritten two publications later, a copy is
+// retried if the writer moved on meanwhile, which a reader of higher priority
+// than the timer task never observes.
+bool thermocouple_sampler_latest(thermocouple_sample_t* sample, miliseconds* age) {
+    unsigned sequence;
+
+    do {
+        sequence = atomic_load_explicit(&ctx.published, memory_order_acquire);
+        *sample  = ctx.slots[sequence & 1U];
+        atomic_thread_fence(memory_order_acquire);
+    } while (sequence != atomic_load_explicit(&ctx.published, memory_order_relaxed));
+
+    *age = now() - sample->timestamp;
+    return sequence != 0;
+}
+
+unsigned thermocouple_sampler_failures(void) {
+    return atomic_load_explicit(&ctx.failures, memory_order_relaxed);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_THERMOCOUPLE_SAMPLER_
+#define _MAIN_THERMOCOUPLE_SAMPLER_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utilities/error.h"
+#include "utilities/types.h"
+#include "temperature.h"
+
+// Amplifiers restart the conversion whenever CS is pulled, so
+// thermocouple_sampler_tick in timer.scf has to stay above the conversion time
+// of every driver in thermocouple_driver.c, 220 ms of the MAX6675 being the longest.
+
+// Samples older than this are not used for control
+#define THERMOCOUPLE_MAX_SAMPLE_AGE_MS  1000U
+// Oversampling filter, the sampler runs about 20 times per control window
+#define THERMOCOUPLE_MEDIAN_WINDOW      3U
+#define THERMOCOUPLE_IIR_SHIFT          2U
+
+typedef struct {
+    temperature_t temperature; // filtered
+    temperature_t raw;         // as converted by spi.c
+    miliseconds   timestamp;   // tick time the readout was delivered
+    uint32_t      sequence;    // increments with every valid sample, 0 before the first one
+} thermocouple_sample_t;
+
+error_status_t thermocouple_sampler_start(void);
+// Latest valid sample and its age in ms, false until the first sample arrives.
+// Lock free and without bus traffic, safe to call from any task.
+bool thermocouple_sampler_latest(thermocouple_sample_t* sample, miliseconds* age);
+unsigned thermocouple_sampler_failures(void);
+
+#endif // _MAIN_THERMOCOUPLE_SAMPLER_
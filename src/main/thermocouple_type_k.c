@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "thermocouple_type_k.h"
+
+#include <math.h>
+
+// NIST Monograph 175 reference functions, E in mV and t in degC. They are only
+// ever expanded inside the table initializers below, GCC folds them to
+// constants so no floating point code or coefficient reaches the firmware.
+#define INVERSE_NEGATIVE(E) ((E) * (2.5173462e+01 + (E) * (-1.1662878e+00 + (E) * (-1.0833638e+00                   \
+    + (E) * (-8.9773540e-01 + (E) * (-3.7342377e-01 + (E) * (-8.6632643e-02 + (E) * (-1.0450598e-02                 \
+    + (E) * -5.1920577e-04))))))))
+#define INVERSE_LOW(E) ((E) * (2.508355e+01 + (E) * (7.860106e-02 + (E) * (-2.503131e-01 + (E) * (8.315270e-02      \
+    + (E) * (-1.228034e-02 + (E) * (9.804036e-04 + (E) * (-4.413030e-05 + (E) * (1.057734e-06                       \
+    + (E) * -1.052755e-08)))))))))
+#define INVERSE_HIGH(E) (-1.318058e+02 + (E) * (4.830222e+01 + (E) * (-1.646031e+00 + (E) * (5.464731e-02           \
+    + (E) * (-9.650715e-04 + (E) * (8.802193e-06 + (E) * -3.110810e-08))))))
+#define INVERSE(E) ((E) < 0.0 ? INVERSE_NEGATIVE(E) : (E) < 20.644 ? INVERSE_LOW(E) : INVERSE_HIGH(E))
+
+#define FORWARD_NEGATIVE(t) ((t) * (3.94501280250e-02 + (t) * (2.36223735980e-05 + (t) * (-3.28589067840e-07        \
+    + (t) * (-4.99048287770e-09 + (t) * (-6.75090591730e-11 + (t) * (-5.74103274280e-13                             \
+    + (t) * (-3.10888728940e-15 + (t) * (-1.04516093650e-17 + (t) * (-1.98892668780e-20                             \
+    + (t) * -1.63226974860e-23))))))))))
+#define FORWARD_POSITIVE(t) (-1.76004136860e-02 + (t) * (3.89212049750e-02 + (t) * (1.85587700320e-05               \
+    + (t) * (-9.94575928740e-08 + (t) * (3.18409457190e-10 + (t) * (-5.60728448890e-13                              \
+    + (t) * (5.60750590590e-16 + (t) * (-3.20207200030e-19 + (t) * (9.71511471520e-23                               \
+    + (t) * -1.21047212750e-26))))))))                                                                              \
+    + 1.185976e-01 * exp(-1.183432e-04 * ((t) - 1.269686e+02) * ((t) - 1.269686e+02)))
+#define FORWARD(t) ((t) < 0.0 ? FORWARD_NEGATIVE(t) : FORWARD_POSITIVE(t))
+
+#define REPEAT_2(entry, i)   entry(i) entry((i) + 1)
+#define REPEAT_4(entry, i)   REPEAT_2(entry, i) REPEAT_2(entry, (i) + 2)
+#define REPEAT_8(entry, i)   REPEAT_4(entry, i) REPEAT_4(entry, (i) + 4)
+#define REPEAT_16(entry, i)  REPEAT_8(entry, i) REPEAT_8(entry, (i) + 8)
+#define REPEAT_32(entry, i)  REPEAT_16(entry, i) REPEAT_16(entry, (i) + 16)
+#define REPEAT_64(entry, i)  REPEAT_32(entry, i) REPEAT_32(entry, (i) + 32)
+#define REPEAT_128(entry, i) REPEAT_64(entry, i) REPEAT_64(entry, (i) + 64)
+#define REPEAT_256(entry, i) REPEAT_128(entry, i) REPEAT_128(entry, (i) + 128)
+
+#define TABLE_LENGTH 256
+
+// 256 uV per segment, entries in 2^-8 degC. The grid starts a bit below the
+// inverse function span so that 0 uV falls on an entry, interpolation then
+// stays within 0.25 degC of the reference down to -200 degC, where type K is
+// the least linear.
+#define VOLTAGE_STEP_BITS    8
+#define VOLTAGE_ORIGIN       (-24L * (1L << VOLTAGE_STEP_BITS))
+#define VOLTAGE_AT(i)        ((VOLTAGE_ORIGIN + ((long) (i) << VOLTAGE_STEP_BITS)) / 1000.0)
+#define ENTRY_FRACTION_BITS  8
+#define TEMPERATURE_ENTRY(i) (int32_t) floor((1 << ENTRY_FRACTION_BITS) * INVERSE(VOLTAGE_AT(i)) + 0.5),
+
+static const int32_t temperature_table[TABLE_LENGTH] = { REPEAT_256(TEMPERATURE_ENTRY, 0) };
+
+// 8 degC per segment from -256 degC, entries in uV
+#define TEMPERATURE_STEP_BITS (3 + TEMPERATURE_FRACTION_BITS)
+#define TEMPERATURE_ORIGIN    (-32L * (1L << TEMPERATURE_STEP_BITS))
+#define TEMPERATURE_AT(i)     ((double) (TEMPERATURE_ORIGIN + ((long) (i) << TEMPERATURE_STEP_BITS)) \
+                               / TEMPERATURE_ONE)
+#define VOLTAGE_ENTRY(i)      (int32_t) floor(1000.0 * FORWARD(TEMPERATURE_AT(i)) + 0.5),
+
+static const int32_t voltage_table[TABLE_LENGTH] = { REPEAT_256(VOLTAGE_ENTRY, 0) };
+
+_Static_assert(((TYPE_K_MAX_VOLTAGE - VOLTAGE_ORIGIN) >> VOLTAGE_STEP_BITS) + 1 < TABLE_LENGTH,
+               "Voltage table doesn't cover the type K span");
+_Static_assert(((TYPE_K_MAX_TEMPERATURE - TEMPERATURE_ORIGIN) >> TEMPERATURE_STEP_BITS) + 1 < TABLE_LENGTH,
+               "Temperature table doesn't cover the type K span");
+
+// Tables are strictly increasing, so the correction term is never negative
+static int32_t interpolate(const int32_t* table, uint32_t offset, unsigned step_bits) {
+    const uint32_t index    = offset >> step_bits;
+    const int32_t  fraction = (int32_t) (offset & ((1UL << step_bits) - 1));
+
+    return table[index] + (((table[index + 1] - table[index]) * fraction) >> step_bits);
+}
+
+temperature_t type_k_voltage_to_temperature(int32_t voltage) {
+    voltage = voltage < TYPE_K_MIN_VOLTAGE ? TYPE_K_MIN_VOLTAGE :
+              voltage > TYPE_K_MAX_VOLTAGE ? TYPE_K_MAX_VOLTAGE : voltage;
+
+    int32_t value = interpolate(temperature_table, (uint32_t) (voltage - VOLTAGE_ORIGIN), VOLTAGE_STEP_BITS);
+    const int32_t half = 1L << (ENTRY_FRACTION_BITS - TEMPERATURE_FRACTION_BITS - 1);
+    return (temperature_t) ((value + half) >> (ENTRY_FRACTION_BITS - TEMPERATURE_FRACTION_BITS));
+}
+
+int32_t type_k_temperature_to_voltage(temperature_t temperature) {
+    temperature = temperature < TYPE_K_MIN_TEMPERATURE ? TYPE_K_MIN_TEMPERATURE :
+                  temperature > TYPE_K_MAX_TEMPERATURE ? TYPE_K_MAX_TEMPERATURE : temperature;
+
+    return interpolate(voltage_table, (uint32_t) (temperature - TEMPERATURE_ORIGIN), TEMPERATURE_STEP_BITS);
+}
+
+temperature_t type_k_compensate(int32_t voltage, temperature_t cold_junction) {
+    return type_k_voltage_to_temperature(voltage + type_k_temperature_to_voltage(cold_junction));
+}
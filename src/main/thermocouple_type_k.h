@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MAIN_THERMOCOUPLE_TYPE_K_
+#define _MAIN_THERMOCOUPLE_TYPE_K_
+
+#include <stdint.h>
+#include "temperature.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Type K ITS-90 conversions backed by tables of the NIST reference functions,
+// built by the compiler into flash and interpolated in fixed point. Voltages
+// are thermocouple EMF in uV referenced to 0 degC, both directions saturate
+// at the span of the inverse function, -200..1372 degC.
+#define TYPE_K_MIN_VOLTAGE     (-5891L)
+#define TYPE_K_MAX_VOLTAGE     54886L
+#define TYPE_K_MIN_TEMPERATURE ((temperature_t) (-200 * TEMPERATURE_ONE))
+#define TYPE_K_MAX_TEMPERATURE ((temperature_t) (1372 * TEMPERATURE_ONE))
+
+temperature_t type_k_voltage_to_temperature(int32_t voltage);
+int32_t type_k_temperature_to_voltage(temperature_t temperature);
+// Hot junction temperature from the measured EMF and the cold junction temperature
+temperature_t type_k_compensate(int32_t voltage, temperature_t cold_junction);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _MAIN_THERMOCOUPLE_TYPE_K_
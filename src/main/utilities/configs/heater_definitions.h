@@ -0,0 +1,50 @@
+/*
+ * Copyright 2023 WJKPK
+ *  
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UTILITIES_CONFIGS_HEATER_DEFINITIONS_
+#define _UTILITIES_CONFIGS_HEATER_DEFINITIONS_
+
+// HEATER_CONTROL_PID or HEATER_CONTROL_MPC
+#ifndef HEATER_CONTROL_MODE
+#define HEATER_CONTROL_MODE HEATER_CONTROL_PID
+#endif
+
+// First order plus dead time plate model for the MPC and the PID feedforward,
+// identified from a 30 % duty step, see tools/controller_benchmark.cpp
+#define HEATER_MODEL_GAIN          7.8333f
+#define HEATER_MODEL_TIME_CONSTANT 211.0f
+#define HEATER_MODEL_DEAD_TIME     7.8f
+#define HEATER_MODEL_AMBIENT       22.0f
+#define HEATER_MPC_HORIZON         4U
+#define HEATER_MPC_MOVE_PENALTY    1.00f
+
+// Setpoint lookahead feedforward added to the PID output, lookahead in seconds,
+// about the full power rise from the JEDEC soak to its peak. pid_gains.scf is
+// swept with it on.
+#define HEATER_FEEDFORWARD_ENABLED   true
+#define HEATER_FEEDFORWARD_LOOKAHEAD 40.0f
+
+// Iterative learning of predefined profiles, gain in percent of power per K of
+// tracking error, lead in seconds
+#define HEATER_LEARNING_ENABLED true
+#define HEATER_LEARNING_GAIN    0.3f
+#define HEATER_LEARNING_LEAD    10U
+
+// Control windows in a row without a fresh thermocouple sample before a
+// request is stopped, the heater stays off through every one of them
+#define HEATER_MAX_STALE_WINDOWS 6U
+
+#endif  // _UTILITIES_CONFIGS_HEATER_DEFINITIONS_
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2023 WJKPK
+ *  
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UTILITIES_CONFIGS_INPUT_DEFINITIONS_
+#define _UTILITIES_CONFIGS_INPUT_DEFINITIONS_
+
+// Edge interrupts are budgeted like a token bucket: the budget refills over
+// the window and every edge spends window / edges of it. Once it runs dry the
+// pins are masked and polled until they settle.
+#define INPUT_STORM_EDGES     16U
+#define INPUT_STORM_WINDOW_US 10000U
+
+// Polling rate while masked, four samples per quadrature edge of a 60 detents/s spin
+#define INPUT_POLL_PERIOD_US 1000U
+// Polls without any level change before the interrupts are unmasked again
+#define INPUT_SETTLE_POLLS   20U
+
+// Push button gestures, in milliseconds. The debounce is the only one the
+// push button gets, polling hands its levels on raw. A click is only reported once the
+// double click window passed, 0 reports it right on release. Long presses and
+// hold repeats are timed from the press, 0 turns either off.
+#define INPUT_BUTTON_DEBOUNCE_MS     10U
+#define INPUT_BUTTON_DOUBLE_CLICK_MS 250U
+#define INPUT_BUTTON_LONG_PRESS_MS   800U
+// Nothing in the menu repeats yet, so a long press fires once
+#define INPUT_BUTTON_HOLD_REPEAT_MS  0U
+
+// Worst case cost of one edge interrupt or poll, measured handler times are
+// reported in the input statistics to check it against
+#define INPUT_HANDLER_COST_US   10U
+// Ceiling on the CPU share of input handling, checked at build time
+#define INPUT_MAX_LOAD_PERMILLE 20U
+
+#endif  // _UTILITIES_CONFIGS_INPUT_DEFINITIONS_
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2023 WJKPK
+ *  
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _UTILITIES_CONFIGS_LCD_DEFINITIONS_
+#define _UTILITIES_CONFIGS_LCD_DEFINITIONS_
+
+#define LCD_TRANSPORT_GPIO    0 // six parallel lines, D4-D7, RS and enable
+#define LCD_TRANSPORT_PCF8574 1 // I2C backpack
+
+// How the display is connected, one of the transports above
+#ifndef LCD_TRANSPORT
+#define LCD_TRANSPORT LCD_TRANSPORT_GPIO
+#endif
+
+// Backpack with A0-A2 open, 0x3F for the PCF8574A
+#define LCD_PCF8574_ADDRESS  0x27
+#define LCD_PCF8574_SDA      3
+#define LCD_PCF8574_SCL      2
+#define LCD_PCF8574_CLOCK_HZ 100000U
+#define LCD_PCF8574_TIMEOUT  10U // ms
+
+// Expander bits of the common backpack, P1 drives R/W and is held low
+#define LCD_PCF8574_RS        0U
+#define LCD_PCF8574_ENABLE    2U
+#define LCD_PCF8574_BACKLIGHT 3U
+#define LCD_PCF8574_D4        4U
+#define LCD_PCF8574_D5        5U
+#define LCD_PCF8574_D6        6U
+#define LCD_PCF8574_D7        7U
+
+// Transfers a clear counts as when a flush picks between clearing and diffing:
+// 1 keeps the bus operations lowest, LCD1602_LONG_EXECUTION_US /
+// LCD1602_EXECUTION_US the time the controller is busy
+#define LCD_CLEAR_COST 1U
+
+#endif  // _UTILITIES_CONFIGS_LCD_DEFINITIONS_
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2023 WJKPK
+ *  
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UTILITIES_CONFIGS_MENU_DEFINITIONS_
+#define _UTILITIES_CONFIGS_MENU_DEFINITIONS_
+
+// Value entry acceleration, { detents per second, step } in ascending velocity.
+// Slow turns keep single steps, fast spins snap to tens and fifties.
+#define MENU_TEMPERATURE_ACCELERATION { { 0, 1 }, { 12, 10 }, { 30, 50 } }
+#define MENU_TIME_ACCELERATION        { { 0, 1 }, { 12, 10 }, { 30, 50 } }
+
+// Redraw caps, skipped value redraws are deferred until the cap expires
+#define MENU_VALUE_MIN_PERIOD_MS  100U
+#define MENU_STATUS_MIN_PERIOD_MS 500U
+
+#endif  // _UTILITIES_CONFIGS_MENU_DEFINITIONS_
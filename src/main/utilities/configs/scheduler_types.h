@@ -20,5 +20,6 @@
 #include "lcd.h"
 #include "menu.h"
 #include "heat_controller_interface.h"
+#include "heating_profile.h"
 
 #endif  // _UTILITIES_CONFIGS_SCHEDULER_TYPES_
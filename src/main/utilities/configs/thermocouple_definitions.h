@@ -0,0 +1,34 @@
+/*
+ * Copyright 2023 WJKPK
+ *  
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _UTILITIES_CONFIGS_THERMOCOUPLE_DEFINITIONS_
+#define _UTILITIES_CONFIGS_THERMOCOUPLE_DEFINITIONS_
+
+// Amplifier fitted on the board, one of thermocouple_driver_id
+#ifndef THERMOCOUPLE_DRIVER
+#define THERMOCOUPLE_DRIVER THERMOCOUPLE_MAX6675
+#endif
+
+// When set, a valid "driver" u8 in the "thermocouple" NVS namespace overrides
+// THERMOCOUPLE_DRIVER, so one image serves every board variant
+#define THERMOCOUPLE_DRIVER_FROM_NVS true
+
+// MOSI is only needed by amplifiers taking commands (MAX31856 in either mode), -1 leaves it unconnected
+// and spi_init() then refuses those, from NVS or built in
+#define THERMOCOUPLE_SPI_MOSI -1
+
+#endif  // _UTILITIES_CONFIGS_THERMOCOUPLE_DEFINITIONS_
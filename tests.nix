@@ -40,7 +40,7 @@ in
     cmakeFlags = getFetchContentFlags
         (builtins.readFile ./CMakeLists.txt) ++ ["-DCMAKE_SKIP_BUILD_RPATH=ON"];
 
-    installPhase = "mkdir -p $out/bin; cp tests $out/bin/.";
+    installPhase = "mkdir -p $out/bin; cp tests pid_sweep monte_carlo controller_benchmark filter_benchmark type_k_benchmark lcd_benchmark $out/bin/.";
 
     env.RISCV_INCLUDE_PATH = "${compiler-path}";
 }
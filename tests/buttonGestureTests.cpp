@@ -0,0 +1,138 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "button_gesture.h"
+}
+
+// One level change of a trace, time in milliseconds
+struct edge {
+    miliseconds at;
+    bool        is_pressed;
+};
+
+struct gesture {
+    button_gesture_type type;
+    miliseconds         at;
+};
+
+// Contacts of a cheap tactile switch, chattering for a few milliseconds on
+// both the press and the release
+#define BOUNCY_PRESS(_at)   {(_at), true}, {(_at) + 1, false}, {(_at) + 2, true}, {(_at) + 4, false}, {(_at) + 5, true}
+#define BOUNCY_RELEASE(_at) {(_at), false}, {(_at) + 2, true}, {(_at) + 3, false}
+
+TEST_GROUP(ButtonGestureTests) {
+    button_gesture_t button;
+
+    void setup() {
+        // debounce, double click, long press and hold repeat
+        const button_gesture_timing_t timing = {10, 250, 800, 200};
+        button_gesture_init(&button, &timing);
+    }
+
+    // Feeds the trace and ticks every millisecond up to the given time, like
+    // the encoder task does on every input and deadline
+    std::vector<gesture> run(const std::vector<edge>& trace, miliseconds until) {
+        std::vector<gesture> gestures;
+        size_t next = 0;
+        for (miliseconds now = 0; now <= until; now++) {
+            for (; next < trace.size() && trace[next].at <= now; next++)
+                button_gesture_input(&button, trace[next].at * 1000, trace[next].is_pressed);
+
+            button_gesture_type type;
+            while (BUTTON_GESTURE_NONE != (type = button_gesture_tick(&button, now * 1000)))
+                gestures.push_back({type, now});
+        }
+        return gestures;
+    }
+};
+
+TEST(ButtonGestureTests, BouncyClickIsOneClickAfterTheDoubleClickWindow) {
+    std::vector<gesture> gestures = run({BOUNCY_PRESS(100), BOUNCY_RELEASE(250)}, 1000);
+
+    CHECK_EQUAL(1U, gestures.size());
+    CHECK_EQUAL(BUTTON_GESTURE_CLICK, gestures[0].type);
+    CHECK_EQUAL(253U + 250U, gestures[0].at);
+}
+
+TEST(ButtonGestureTests, ClickIsReportedOnReleaseWithoutDoubleClickWindow) {
+    button.timing.double_click = 0;
+
+    std::vector<gesture> gestures = run({BOUNCY_PRESS(100), BOUNCY_RELEASE(250)}, 1000);
+
+    CHECK_EQUAL(1U, gestures.size());
+    CHECK_EQUAL(BUTTON_GESTURE_CLICK, gestures[0].type);
+    CHECK_EQUAL(253U + 10U, gestures[0].at);
+}
+
+TEST(ButtonGestureTests, GlitchShorterThanDebounceIsIgnored) {
+    std::vector<gesture> gestures = run({{100, true}, {103, false}, {300, true}, {309, false}}, 2000);
+
+    CHECK_EQUAL(0U, gestures.size());
+    CHECK_FALSE(button.is_pressed);
+}
+
+TEST(ButtonGestureTests, SecondPressWithinTheWindowIsADoubleClick) {
+    std::vector<gesture> gestures = run({BOUNCY_PRESS(100), BOUNCY_RELEASE(200), BOUNCY_PRESS(350),
+                                         BOUNCY_RELEASE(450)}, 2000);
+
+    CHECK_EQUAL(1U, gestures.size());
+    CHECK_EQUAL(BUTTON_GESTURE_DOUBLE_CLICK, gestures[0].type);
+    CHECK_EQUAL(355U + 10U, gestures[0].at);
+}
+
+TEST(ButtonGestureTests, HoldingReportsLongPressThenRepeats) {
+    std::vector<gesture> gestures = run({BOUNCY_PRESS(100), BOUNCY_RELEASE(1350)}, 3000);
+
+    CHECK_EQUAL(3U, gestures.size());
+    CHECK_EQUAL(BUTTON_GESTURE_LONG_PRESS, gestures[0].type);
+    CHECK_EQUAL(105U + 800U, gestures[0].at);
+    CHECK_EQUAL(BUTTON_GESTURE_HOLD_REPEAT, gestures[1].type);
+    CHECK_EQUAL(1105U, gestures[1].at);
+    CHECK_EQUAL(BUTTON_GESTURE_HOLD_REPEAT, gestures[2].type);
+    CHECK_EQUAL(1305U, gestures[2].at);
+}
+
+TEST(ButtonGestureTests, ReleaseBouncingAcrossTheLongPressDeadlineIsAClick) {
+    // Let go just before the long press is due, the debounce runs out after it
+    std::vector<gesture> gestures = run({BOUNCY_PRESS(100), BOUNCY_RELEASE(900)}, 2000);
+
+    CHECK_EQUAL(1U, gestures.size());
+    CHECK_EQUAL(BUTTON_GESTURE_CLICK, gestures[0].type);
+}
+
+TEST(ButtonGestureTests, WaitPointsAtTheNextDeadline) {
+    microseconds wait;
+
+    CHECK_FALSE(button_gesture_wait(&button, 0, &wait));
+
+    button_gesture_input(&button, 100000, true);
+    CHECK(button_gesture_wait(&button, 104000, &wait));
+    CHECK_EQUAL(6000U, wait);
+
+    CHECK_EQUAL(BUTTON_GESTURE_NONE, button_gesture_tick(&button, 110000));
+    CHECK(button_gesture_wait(&button, 110000, &wait));
+    CHECK_EQUAL(800000U - 10000U, wait);
+
+    // Still held once the deadline passed
+    CHECK(button_gesture_wait(&button, 950000, &wait));
+    CHECK_EQUAL(0U, wait);
+    CHECK_EQUAL(BUTTON_GESTURE_LONG_PRESS, button_gesture_tick(&button, 950000));
+}
@@ -20,6 +20,8 @@
 #include <CppUTest/UtestMacros.h>
 #include <memory>
 
+#include "simulation.h"
+
 extern "C" {
 #include "FreeRTOS.h"
 #include "task.h"
@@ -54,4 +56,5 @@ void vApplicationGetTimerTaskMemory(StaticTask_t** ppxTimerTaskTCBBuffer,
 }
 
 void vApplicationIdleHook(void) {
+    simulation_idle_hook();
 }
@@ -32,7 +32,7 @@ typedef struct {
 } CustomStruct;
 
 #include "lcd.h"
-#include "encoder.h"
+#include "menu.h"
 #include "heat_controller_interface.h"
 
 #endif  // __SCHEDULER_CUSTOM_TYPES__
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "encoder_decoder.h"
+}
+
+#define A    ENCODER_LEVEL_A
+#define B    ENCODER_LEVEL_B
+#define IDLE ENCODER_LEVEL_IDLE
+
+// Edge streams as the ISR captures them, levels sampled after each edge.
+// Both contacts close and open through the detent in Gray code order.
+static const uint8_t clockwise_detent[] = {IDLE & ~B, IDLE & ~(A | B), IDLE & ~A, IDLE};
+static const uint8_t counterclockwise_detent[] = {IDLE & ~A, IDLE & ~(A | B), IDLE & ~B, IDLE};
+// Recorded from a worn encoder turning clockwise: every contact chatters
+// before it settles, one of them even after the next contact moved.
+static const uint8_t bouncy_clockwise_detent[] = {
+    IDLE & ~B, IDLE, IDLE & ~B, IDLE, IDLE & ~B,
+    IDLE & ~(A | B), IDLE & ~B, IDLE & ~(A | B),
+    IDLE & ~A, IDLE & ~(A | B), IDLE & ~A, IDLE & ~(A | B), IDLE & ~A,
+    IDLE, IDLE & ~A, IDLE,
+};
+
+TEST_GROUP(EncoderDecoderTests) {
+    encoder_decoder_t decoder;
+    microseconds      clock;
+
+    void setup() {
+        encoder_decoder_init(&decoder, IDLE);
+        clock = 0;
+    }
+
+    void feed(const uint8_t* levels, unsigned count, microseconds edge_interval) {
+        for (unsigned i = 0; i < count; i++) {
+            clock += edge_interval;
+            CHECK(encoder_decoder_capture(&decoder, clock, levels[i]));
+        }
+    }
+
+    std::vector<encoder_decoded_t> drain(void) {
+        std::vector<encoder_decoded_t> events;
+        encoder_decoded_t decoded;
+        while (encoder_decoder_next(&decoder, &decoded))
+            events.push_back(decoded);
+        return events;
+    }
+};
+
+TEST(EncoderDecoderTests, CleanDetentsAreCountedPerDirection) {
+    for (unsigned i = 0; i < 3; i++)
+        feed(clockwise_detent, sizeof(clockwise_detent), 1000);
+    feed(counterclockwise_detent, sizeof(counterclockwise_detent), 1000);
+
+    std::vector<encoder_decoded_t> events = drain();
+    CHECK_EQUAL(4U, events.size());
+    CHECK_EQUAL(ENCODER_EVENT_UP, events[0].type);
+    CHECK_EQUAL(ENCODER_EVENT_UP, events[2].type);
+    CHECK_EQUAL(ENCODER_EVENT_DOWN, events[3].type);
+    CHECK_EQUAL(2, encoder_decoder_position(&decoder));
+}
+
+TEST(EncoderDecoderTests, BounceDoesNotAddDetents) {
+    for (unsigned i = 0; i < 2; i++) {
+        feed(bouncy_clockwise_detent, sizeof(bouncy_clockwise_detent), 200);
+        std::vector<encoder_decoded_t> events = drain();
+        CHECK_EQUAL(1U, events.size());
+        CHECK_EQUAL(ENCODER_EVENT_UP, events[0].type);
+    }
+    CHECK_EQUAL(2, encoder_decoder_position(&decoder));
+}
+
+TEST(EncoderDecoderTests, HalfTurnBackIsNoDetent) {
+    const uint8_t there_and_back[] = {IDLE & ~B, IDLE & ~(A | B), IDLE & ~B, IDLE};
+
+    feed(there_and_back, sizeof(there_and_back), 1000);
+
+    CHECK_EQUAL(0U, drain().size());
+    CHECK_EQUAL(0, encoder_decoder_position(&decoder));
+}
+
+TEST(EncoderDecoderTests, PressesAndReleasesAreReportedBeforeTheRotationEdge) {
+    const uint8_t press_and_release[] = {IDLE & ~ENCODER_LEVEL_PUSH, IDLE & ~ENCODER_LEVEL_PUSH, IDLE};
+    const uint8_t press_with_edge[]  = {IDLE & ~(ENCODER_LEVEL_PUSH | B)};
+
+    feed(press_and_release, sizeof(press_and_release), 1000);
+    feed(press_with_edge, sizeof(press_with_edge), 1000);
+    feed(clockwise_detent + 1, sizeof(clockwise_detent) - 1, 1000);
+
+    std::vector<encoder_decoded_t> events = drain();
+    CHECK_EQUAL(5U, events.size());
+    CHECK_EQUAL(ENCODER_EVENT_PUSH, events[0].type);
+    CHECK_EQUAL(1000U, events[0].timestamp);
+    CHECK_EQUAL(ENCODER_EVENT_RELEASE, events[1].type);
+    CHECK_EQUAL(3000U, events[1].timestamp);
+    CHECK_EQUAL(ENCODER_EVENT_PUSH, events[2].type);
+    CHECK_EQUAL(ENCODER_EVENT_RELEASE, events[3].type);
+    CHECK_EQUAL(ENCODER_EVENT_UP, events[4].type);
+    CHECK_EQUAL(7000U, events[4].timestamp);
+}
+
+TEST(EncoderDecoderTests, VelocityUsesCaptureTimestamps) {
+    // Decoded late and all at once, still 50 detents per second as captured
+    for (unsigned i = 0; i < 3; i++)
+        feed(clockwise_detent, sizeof(clockwise_detent), 5000);
+
+    std::vector<encoder_decoded_t> events = drain();
+    CHECK_EQUAL(3U, events.size());
+    CHECK_EQUAL(0U, events[0].velocity);
+    CHECK_EQUAL(50U, events[1].velocity);
+    CHECK_EQUAL(50U, events[2].velocity);
+}
+
+TEST(EncoderDecoderTests, FullRingDropsAndCountsSamples) {
+    for (unsigned i = 0; i < ENCODER_RING_LENGTH; i++)
+        CHECK(encoder_decoder_capture(&decoder, i, IDLE));
+    CHECK_FALSE(encoder_decoder_capture(&decoder, ENCODER_RING_LENGTH, IDLE));
+    CHECK_EQUAL(1U, encoder_decoder_overflows(&decoder));
+
+    CHECK_EQUAL(0U, drain().size());
+    CHECK(encoder_decoder_capture(&decoder, ENCODER_RING_LENGTH + 1, IDLE));
+}
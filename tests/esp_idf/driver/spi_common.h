@@ -0,0 +1,43 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TESTS_ESP_IDF_DRIVER_SPI_COMMON_
+#define _TESTS_ESP_IDF_DRIVER_SPI_COMMON_
+
+#include "esp_err.h"
+
+typedef enum {
+    SPI1_HOST,
+    SPI2_HOST,
+} spi_host_device_t;
+
+typedef enum {
+    SPI_DMA_DISABLED,
+    SPI_DMA_CH_AUTO = 3,
+} spi_dma_chan_t;
+
+typedef struct {
+    int miso_io_num;
+    int mosi_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* bus_config, spi_dma_chan_t dma_chan);
+
+#endif // _TESTS_ESP_IDF_DRIVER_SPI_COMMON_
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TESTS_ESP_IDF_DRIVER_SPI_MASTER_
+#define _TESTS_ESP_IDF_DRIVER_SPI_MASTER_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "driver/spi_common.h"
+
+#define SPI_DEVICE_HALFDUPLEX (1 << 4)
+#define SPI_TRANS_USE_TXDATA  (1 << 3)
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t* trans);
+
+struct spi_transaction_t {
+    uint32_t flags;
+    size_t   length;
+    size_t   rxlength;
+    void*    user;
+    union {
+        const void* tx_buffer;
+        uint8_t     tx_data[4];
+    };
+    union {
+        void*   rx_buffer;
+        uint8_t rx_data[4];
+    };
+};
+
+typedef struct {
+    uint8_t          mode;
+    uint16_t         cs_ena_pretrans;
+    uint8_t          cs_ena_posttrans;
+    int              clock_speed_hz;
+    int              spics_io_num;
+    uint32_t         flags;
+    int              queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+typedef struct spi_device_t* spi_device_handle_t;
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config,
+                             spi_device_handle_t* handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc,
+                                      TickType_t ticks_to_wait);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc);
+
+#endif // _TESTS_ESP_IDF_DRIVER_SPI_MASTER_
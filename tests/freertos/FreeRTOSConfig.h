@@ -36,12 +36,20 @@
 * https://www.FreeRTOS.org/a00110.html
 *----------------------------------------------------------*/
 
+/* Virtual time simulation. When enabled the POSIX port's periodic tick is
+ * silenced once the scheduler starts and the tick count is advanced by the
+ * idle task instead, jumping straight to the next unblock time whenever every
+ * task is blocked. See tests/simulation.cpp. */
+#ifndef configSIMULATION_VIRTUAL_TIME
+    #define configSIMULATION_VIRTUAL_TIME          1
+#endif
+
 #define configSUPPORT_DYNAMIC_ALLOCATION           1
 #define configUSE_PREEMPTION                       1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION    0
 #define configUSE_IDLE_HOOK                        1
 #define configUSE_TICK_HOOK                        0
-#define configUSE_DAEMON_TASK_STARTUP_HOOK         0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK         configSIMULATION_VIRTUAL_TIME
 #define configTICK_RATE_HZ                         ( 1000 )                  /* In this non-real time simulated environment the tick frequency has to be at least a multiple of the Win32 tick frequency, and therefore very slow. */
 #define configMINIMAL_STACK_SIZE                   ( ( unsigned short ) PTHREAD_STACK_MIN ) /* The stack size being passed is equal to the minimum stack size needed by pthread_create(). */
 #define configTOTAL_HEAP_SIZE                      ( ( size_t ) ( 1024 * 1024 ) )
@@ -73,6 +81,19 @@
 
 #define configMAX_PRIORITIES                       ( 7 )
 
+#if ( configSIMULATION_VIRTUAL_TIME == 1 )
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+    void vSimulationSuppressTicksAndSleep( unsigned long ulExpectedIdleTime );
+    #ifdef __cplusplus
+    }
+    #endif
+    #define configUSE_TICKLESS_IDLE                    2
+    #define configEXPECTED_IDLE_TIME_BEFORE_SLEEP      2
+    #define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )    vSimulationSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+
 /* Run time stats gathering configuration options. */
 unsigned long ulGetRunTimeCounterValue( void ); /* Prototype of function that returns run time counter. */
 void vConfigureTimerForRunTimeStats( void );    /* Prototype of function that initialises the run time counter. */
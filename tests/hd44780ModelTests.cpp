@@ -0,0 +1,162 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "lcd1602/lcd1602.h"
+#include "lcd_framebuffer.h"
+#include "simulation/hd44780_model.h"
+}
+
+enum transport {
+    transport_pins,
+    transport_bus,
+    transport_port,
+};
+
+static const pinset gpio_pins = { 1, 4, 9, 6, 3, 2 };
+static const pinset port_pins = { 0, 2, 4, 5, 6, 7 };
+
+static bool set_cursor(uint8_t row, uint8_t column) {
+    return lcd16x2_setCursor(row, column);
+}
+
+TEST_GROUP(Hd44780ModelTests) {
+    hd44780_model model;
+
+    void setup() {
+        start(transport_pins);
+    }
+
+    void teardown() {
+    }
+
+    void start(transport kind) {
+        lcd1602_interface iface = {};
+        hd44780_model_config config = { kind == transport_port ? port_pins : gpio_pins, 100, 90000 };
+
+        iface.pins = config.pins;
+        iface.pin_set = hd44780_model_pin_set;
+        iface.wait = hd44780_model_wait;
+        iface.bus_write = kind == transport_bus ? hd44780_model_bus_write : nullptr;
+        if (kind == transport_port)
+            iface.port = { hd44780_model_port_write, 1 << 3, 90 };
+        hd44780_model_init(&model, &config);
+        hd44780_model_attach(&model);
+        lcd16x2_init_4bits(iface);
+        run();
+    }
+
+    // Waits out every step like the LCD task does
+    void run() {
+        for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); )
+            hd44780_model_wait(execution_time);
+    }
+
+    void show(const char* first, const char* second) {
+        const lcd_framebuffer_output_t output = { set_cursor, lcd16x2_putChar, lcd16x2_clear, 41 };
+        lcd_framebuffer_t displayed, shadow;
+
+        lcd_framebuffer_clear(&displayed);
+        lcd_framebuffer_clear(&shadow);
+        lcd_framebuffer_print(&shadow, 0, 0, "%s", first);
+        lcd_framebuffer_print(&shadow, 1, 0, "%s", second);
+        lcd_framebuffer_flush(&displayed, &shadow, &output);
+        run();
+    }
+
+    void check_row(unsigned row, const char* expected) {
+        char text[HD44780_VISIBLE_COLUMNS + 1];
+
+        hd44780_model_row(&model, row, text);
+        CHECK_EQUAL(0, strcmp(expected, text));
+    }
+};
+
+TEST(Hd44780ModelTests, InitSequenceIsInTime) {
+    CHECK_TRUE(model.four_bit);
+    CHECK_TRUE(model.two_lines);
+    CHECK_EQUAL(0x07, model.display_control);
+    CHECK_EQUAL(0, hd44780_model_violations(&model));
+    check_row(0, "                ");
+}
+
+TEST(Hd44780ModelTests, ScreenReachesDdramOverEveryTransport) {
+    for (transport kind : { transport_pins, transport_bus, transport_port }) {
+        start(kind);
+        hd44780_model_reset_counters(&model);
+        show("Reflow 183/245C", "Preheat  02:31");
+
+        check_row(0, "Reflow 183/245C ");
+        check_row(1, "Preheat  02:31  ");
+        CHECK_EQUAL(0, hd44780_model_violations(&model));
+        CHECK_TRUE(model.counters.instructions >= 29);
+    }
+}
+
+TEST(Hd44780ModelTests, BusWriteTakesFewerOperations) {
+    hd44780_model_reset_counters(&model);
+    show("Reflow 183/245C", "Preheat  02:31");
+    unsigned long pins = model.counters.operations;
+
+    start(transport_bus);
+    hd44780_model_reset_counters(&model);
+    show("Reflow 183/245C", "Preheat  02:31");
+
+    CHECK_TRUE(2 * model.counters.operations < pins);
+}
+
+TEST(Hd44780ModelTests, CustomCharacterReachesCgram) {
+    uint8_t arrow[] = { 0x00, 0x04, 0x0E, 0x1F, 0x04, 0x04, 0x04, 0x00 };
+
+    CHECK_TRUE(lcd16x2_createChar(2, arrow));
+    CHECK_TRUE(lcd16x2_setCursor(0, 0));
+    CHECK_TRUE(lcd16x2_writeCustom(2));
+    run();
+
+    CHECK_EQUAL(0, memcmp(arrow, &model.cgram[2 * 8], sizeof(arrow)));
+    CHECK_EQUAL(2, model.ddram[0]);
+    CHECK_EQUAL(0, hd44780_model_violations(&model));
+}
+
+TEST(Hd44780ModelTests, DisplayShiftMovesTheWindow) {
+    show("0123456789ABCDEF", "");
+    CHECK_TRUE(lcd16x2_shiftLeft(2));
+    run();
+
+    check_row(0, "23456789ABCDEF  ");
+}
+
+TEST(Hd44780ModelTests, SkippedExecutionTimeIsFlagged) {
+    CHECK_TRUE(lcd16x2_putChar('A'));
+    CHECK_TRUE(lcd16x2_putChar('B'));
+    while (LCD1602_IDLE != lcd16x2_runStep())
+        ;
+
+    CHECK_EQUAL(1, model.counters.violations[HD44780_VIOLATION_BUSY]);
+}
+
+TEST(Hd44780ModelTests, EnableWithRsIsFlagged) {
+    start(transport_port);
+    const uint8_t states[] = { 0x01 | 0x04 | 0x40, 0x01 | 0x40 };
+
+    hd44780_model_port_write(states, sizeof(states));
+
+    CHECK_EQUAL(1, model.counters.violations[HD44780_VIOLATION_ADDRESS_SETUP]);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "heater_calculator.h"
+#include "heating_profile.h"
+#include "simulation/plant_model.h"
+}
+
+static constexpr float control_period_s(5.f);
+static constexpr float liquidus(217.f);
+
+static float run_controller(void* context, float measured, const heating_profile* profile, seconds time,
+  float period) {
+    return heater_calculator_iterate(static_cast<heater_calculator_t*>(context), measured, profile, time, period);
+}
+
+TEST_GROUP(HeaterCalculatorTests) {
+    temperature_stage stage;
+    heating_profile profile;
+    heater_calculator_t calculator;
+
+    void setup() {
+        profile = heating_profile_constant(&stage, 200, 600);
+    }
+
+    void teardown() {
+    }
+
+    // On the nominal plant, the calculator as configured by the reset before
+    plant_run_result run(const heating_profile* run_profile) {
+        plant_parameters parameters;
+        plant_model plant;
+
+        plant_default_parameters(&parameters);
+        plant_init(&plant, &parameters, 1);
+        return plant_run_profile(&plant, run_profile, control_period_s, liquidus, run_controller, &calculator);
+    }
+};
+
+TEST(HeaterCalculatorTests, FirstWindowHasNoDerivativeKick) {
+    const pid_params_t derivative_only = { 0.f, 0.f, 20.f };
+
+    heater_calculator_reset(&calculator, derivative_only);
+    CHECK_EQUAL(0.f, heater_calculator_iterate(&calculator, 22.f, &profile, 0, control_period_s));
+    // A falling error still reaches the derivative from the second window on
+    CHECK_EQUAL(0.f, heater_calculator_iterate(&calculator, 23.f, &profile, 5, control_period_s));
+    CHECK(heater_calculator_iterate(&calculator, 20.f, &profile, 10, control_period_s) > 5.f);
+}
+
+TEST(HeaterCalculatorTests, FeedforwardPreparesRisesOverTheLookahead) {
+    // Soak at 100 degC until 100 s, peak at 250 degC until 140 s, then cooldown
+    const heating_profile* jedec     = heating_profile_get(HEATING_PROFILE_JEDEC);
+    heater_feedforward_t feedforward = heater_calculator_feedforward_parameters();
+    const float hold_soak            = (100.f - feedforward.model.ambient) / feedforward.model.gain;
+    const float hold_peak            = (250.f - feedforward.model.ambient) / feedforward.model.gain;
+    const seconds rise_from          = 100 - static_cast<seconds>(feedforward.lookahead);
+
+    feedforward.is_enabled = true;
+    DOUBLES_EQUAL(hold_soak, heater_calculator_feedforward(&feedforward, jedec, rise_from - 5), 1e-3f);
+    // Saturated from a lookahead ahead of the rise
+    CHECK(heater_calculator_feedforward(&feedforward, jedec, rise_from) > 100.f);
+    CHECK(heater_calculator_feedforward(&feedforward, jedec, 95) > 100.f);
+    // The peak stage is held through its end, not cooled down early
+    DOUBLES_EQUAL(hold_peak, heater_calculator_feedforward(&feedforward, jedec, 100), 1e-3f);
+    DOUBLES_EQUAL(hold_peak, heater_calculator_feedforward(&feedforward, jedec, 135), 1e-3f);
+    CHECK(heater_calculator_feedforward(&feedforward, jedec, 140) < hold_soak);
+}
+
+TEST(HeaterCalculatorTests, PidStepSettlesToTheSetpoint) {
+    heater_calculator_reset(&calculator, heater_calculator_gains(HEATING_PROFILE_CONSTANT));
+    heater_calculator_set_feedforward(&calculator, heater_calculator_feedforward_parameters());
+
+    plant_run_result result = run(&profile);
+    CHECK(result.overshoot < 10.f);
+    CHECK(std::fabs(result.final_error) < 2.f);
+}
+
+TEST(HeaterCalculatorTests, MpcStepSettlesToTheSetpoint) {
+    heater_calculator_reset_mpc(&calculator, heater_calculator_mpc_parameters());
+
+    plant_run_result result = run(&profile);
+    CHECK(result.overshoot < 10.f);
+    CHECK(std::fabs(result.final_error) < 2.f);
+}
+
+TEST(HeaterCalculatorTests, MpcReflowReachesThePeakWindow) {
+    heater_calculator_reset_mpc(&calculator, heater_calculator_mpc_parameters());
+
+    plant_run_result result = run(heating_profile_get(HEATING_PROFILE_JEDEC));
+    CHECK(result.peak >= 235.f && result.peak <= 260.f);
+    CHECK(result.time_above_liquidus >= 30.f && result.time_above_liquidus <= 150.f);
+}
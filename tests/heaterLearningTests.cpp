@@ -0,0 +1,108 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "heater_calculator.h"
+#include "heater_learning.h"
+#include "heating_profile.h"
+#include "simulation/plant_model.h"
+}
+
+static constexpr float control_period_s(5.f);
+static constexpr float liquidus(217.f);
+
+static float run_controller(void* context, float measured, const heating_profile* profile, seconds time,
+  float period) {
+    return heater_calculator_iterate(static_cast<heater_calculator_t*>(context), measured, profile, time, period);
+}
+
+TEST_GROUP(HeaterLearningTests) {
+    heater_learning_t learning;
+    const heating_profile* jedec;
+
+    void setup() {
+        learning = heater_learning_t();
+        jedec    = heating_profile_get(HEATING_PROFILE_JEDEC);
+    }
+
+    void teardown() {
+    }
+
+    // Same path the heat controller takes for every started multistage profile
+    float run_jedec(void) {
+        plant_parameters parameters;
+        plant_model plant;
+        heater_calculator_t calculator;
+
+        plant_default_parameters(&parameters);
+        plant_init(&plant, &parameters, 1);
+        heater_calculator_reset(&calculator, heater_calculator_gains(HEATING_PROFILE_JEDEC));
+        heater_calculator_set_feedforward(&calculator, heater_calculator_feedforward_parameters());
+        heater_learning_begin(&learning, heating_profile_duration(jedec));
+        heater_calculator_set_learning(&calculator, &learning);
+
+        plant_run_result result = plant_run_profile(&plant, jedec, control_period_s, liquidus, run_controller,
+            &calculator);
+        CHECK_TRUE(heater_learning_update(&learning, heater_calculator_learning_parameters()));
+        return result.ise;
+    }
+};
+
+TEST(HeaterLearningTests, FreshTableAddsNoCorrection) {
+    heater_learning_begin(&learning, heating_profile_duration(jedec));
+
+    for (seconds time = 0; time < heating_profile_duration(jedec); time++)
+        CHECK_EQUAL(0.f, heater_learning_correction(&learning, time));
+    CHECK_FALSE(heater_learning_update(&learning, heater_calculator_learning_parameters()));
+}
+
+TEST(HeaterLearningTests, PositiveErrorRaisesCorrectionOfItsBin) {
+    const heater_learning_params_t parameters = { 1.f, 0 };
+
+    heater_learning_begin(&learning, heating_profile_duration(jedec));
+    heater_learning_record(&learning, 100, 10.f);
+    heater_learning_record(&learning, 100, 20.f);
+    CHECK_TRUE(heater_learning_update(&learning, parameters));
+
+    DOUBLES_EQUAL(7.5f, heater_learning_correction(&learning, 100), 1e-4f);
+    DOUBLES_EQUAL(0.f, heater_learning_correction(&learning, 0), 1e-4f);
+    CHECK_EQUAL(1, learning.table.runs);
+}
+
+TEST(HeaterLearningTests, TableIsDroppedWhenProfileLengthChanges) {
+    heater_learning_begin(&learning, heating_profile_duration(jedec));
+    heater_learning_record(&learning, 10, 50.f);
+    CHECK_TRUE(heater_learning_update(&learning, heater_calculator_learning_parameters()));
+
+    heater_learning_begin(&learning, 2 * heating_profile_duration(jedec));
+    CHECK_EQUAL(0, learning.table.runs);
+    CHECK_EQUAL(0.f, heater_learning_correction(&learning, 10));
+}
+
+TEST(HeaterLearningTests, JedecIseDropsRunOverRun) {
+    const unsigned runs = 6;
+    float ise[runs];
+
+    for (unsigned run = 0; run < runs; run++)
+        ise[run] = run_jedec();
+
+    for (unsigned run = 1; run < runs; run++)
+        CHECK_TRUE(ise[run] < ise[run - 1]);
+    CHECK_TRUE(ise[runs - 1] < 0.8f * ise[0]);
+    CHECK_EQUAL(runs, learning.table.runs);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "heater_calculator.h"
+#include "heater_mpc.h"
+}
+
+static constexpr float control_period_s(5.f);
+static constexpr unsigned windows(240);
+
+TEST_GROUP(HeaterMpcTests) {
+    mpc_params_t parameters;
+    mpc_state_t state;
+    float references[MPC_MAX_REFERENCES];
+
+    void setup() {
+        parameters = heater_calculator_mpc_parameters();
+        state      = mpc_state_t();
+    }
+
+    void teardown() {
+    }
+
+    void hold_references(float setpoint) {
+        for (float& reference : references)
+            reference = setpoint;
+    }
+
+    // Discrete first order plus dead time plant with the given gain, returns the
+    // highest reading, the last one in final
+    float run(float plant_gain, float setpoint, float* final) {
+        const fopdt_model_t& model = parameters.model;
+        const float decay          = std::exp(-control_period_s / model.time_constant);
+        const unsigned delay       = static_cast<unsigned>(std::lround(model.dead_time / control_period_s));
+        float rises[MPC_MAX_DELAY_STEPS + 1] = {};
+        float highest = model.ambient;
+
+        hold_references(setpoint);
+        for (unsigned window = 0; window < windows; window++) {
+            const float measured = model.ambient + rises[delay];
+            const float output   = mpc_iterate(&parameters, &state, measured, references, control_period_s);
+            for (unsigned i = MPC_MAX_DELAY_STEPS; i > 0; i--)
+                rises[i] = rises[i - 1];
+            rises[0] = decay * rises[1] + (1.f - decay) * plant_gain * output;
+            highest  = std::max(highest, measured);
+            *final   = measured;
+        }
+        return highest;
+    }
+};
+
+TEST(HeaterMpcTests, StepSettlesOnItsOwnModel) {
+    float final = 0.f;
+
+    CHECK(run(parameters.model.gain, 200.f, &final) < 205.f);
+    DOUBLES_EQUAL(200.f, final, 1.f);
+}
+
+TEST(HeaterMpcTests, GainMismatchLeavesNoOffset) {
+    float final = 0.f;
+
+    CHECK(run(0.8f * parameters.model.gain, 200.f, &final) < 210.f);
+    DOUBLES_EQUAL(200.f, final, 1.f);
+    state = mpc_state_t();
+    CHECK(run(1.2f * parameters.model.gain, 200.f, &final) < 210.f);
+    DOUBLES_EQUAL(200.f, final, 1.f);
+}
+
+TEST(HeaterMpcTests, OutputStaysWithinHeaterRange) {
+    hold_references(1000.f);
+    CHECK_EQUAL(100.f, mpc_iterate(&parameters, &state, parameters.model.ambient, references, control_period_s));
+    state = mpc_state_t();
+    hold_references(0.f);
+    CHECK_EQUAL(0.f, mpc_iterate(&parameters, &state, 200.f, references, control_period_s));
+}
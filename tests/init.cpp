@@ -17,6 +17,8 @@
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
 
+#include "simulation.h"
+
 extern "C" {
 #include "FreeRTOS.h"
 #include "task.h"
@@ -52,6 +54,7 @@ int main(int ac, char** av) {
       };
     TaskHandle_t loop_task_handle = NULL;
 
+    simulation_init();
     timer_init();
     CHECK_EQUAL(pdPASS,
       xTaskCreate(event_scheduler_loop, "ESLoop", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1,
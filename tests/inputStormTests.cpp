@@ -0,0 +1,115 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "encoder_decoder.h"
+#include "input_storm.h"
+}
+
+#define IDLE    ENCODER_LEVEL_IDLE
+#define PRESSED (ENCODER_LEVEL_IDLE & ~ENCODER_LEVEL_PUSH)
+
+TEST_GROUP(InputStormTests) {
+    input_storm_t storm;
+    microseconds  clock;
+
+    void setup() {
+        input_storm_init(&storm, IDLE);
+        clock = 1000000;
+    }
+
+    // Edges of the given interval for the given time, returns how many were admitted
+    unsigned edges(microseconds interval, microseconds duration) {
+        unsigned admitted = 0;
+        for (microseconds end = clock + duration; clock < end; clock += interval)
+            admitted += input_storm_admit(&storm, clock);
+        return admitted;
+    }
+
+    // Polls until the storm settles, returns the number of polls taken
+    unsigned poll_until_settled(uint8_t raw, uint8_t* levels) {
+        unsigned polls = 1;
+        while (input_storm_poll(&storm, clock += INPUT_POLL_PERIOD_US, raw, levels))
+            polls++;
+        return polls;
+    }
+};
+
+TEST(InputStormTests, BouncySpinStaysOnInterrupts) {
+    // 60 detents per second, every quadrature edge chattering three more times
+    for (unsigned edge = 0; edge < 480; edge++) {
+        CHECK_EQUAL(4U, edges(30, 120));
+        clock += 1000000 / 240 - 120;
+    }
+    CHECK_EQUAL(0U, storm.stats.storms);
+}
+
+TEST(InputStormTests, StormIsCutOffWithinTheBudget) {
+    // 50 kHz chatter, the pins would be masked at the first refusal
+    unsigned admitted = 0;
+    while (input_storm_admit(&storm, clock += 20))
+        admitted++;
+
+    CHECK(admitted <= INPUT_STORM_EDGES + 1);
+    CHECK(admitted >= INPUT_STORM_EDGES - 1);
+}
+
+TEST(InputStormTests, EdgeLoadStaysUnderTheCeiling) {
+    // Even with the pins never masked, a second of 50 kHz edges admits no more than the budget
+    const unsigned admitted = edges(20, 1000000);
+
+    CHECK(admitted * INPUT_HANDLER_COST_US <= INPUT_MAX_LOAD_PERMILLE * 1000U);
+}
+
+TEST(InputStormTests, PushButtonIsPassedThroughRaw) {
+    // The gesture recognizer debounces it, polling only samples the bounce
+    const uint8_t chatter[] = {PRESSED, IDLE, PRESSED, PRESSED, IDLE, PRESSED};
+    uint8_t levels = 0;
+
+    input_storm_begin_polling(&storm, clock, PRESSED, false);
+    for (uint8_t raw : chatter) {
+        CHECK(input_storm_poll(&storm, clock += INPUT_POLL_PERIOD_US, raw, &levels));
+        CHECK_EQUAL(raw, levels);
+    }
+    CHECK_EQUAL(INPUT_SETTLE_POLLS, poll_until_settled(PRESSED, &levels));
+    CHECK_EQUAL(PRESSED, levels);
+    CHECK_EQUAL(1U, storm.stats.debounces);
+}
+
+TEST(InputStormTests, RotationIsPassedThroughRaw) {
+    const uint8_t turning = IDLE & ~ENCODER_LEVEL_A;
+    uint8_t levels = 0;
+
+    input_storm_begin_polling(&storm, clock, IDLE, true);
+    CHECK(input_storm_poll(&storm, clock += INPUT_POLL_PERIOD_US, turning, &levels));
+    CHECK_EQUAL(turning, levels);
+}
+
+TEST(InputStormTests, PollingStopsOnceTheLinesSettle) {
+    uint8_t levels = 0;
+
+    edges(20, INPUT_STORM_WINDOW_US);
+    input_storm_begin_polling(&storm, clock, IDLE, true);
+    CHECK_EQUAL(INPUT_SETTLE_POLLS, poll_until_settled(IDLE, &levels));
+    CHECK_EQUAL(IDLE, levels);
+    CHECK_EQUAL(1U, storm.stats.storms);
+    CHECK_EQUAL(INPUT_SETTLE_POLLS * INPUT_POLL_PERIOD_US, storm.stats.polling_time);
+
+    // Back on interrupts with the whole budget
+    CHECK_EQUAL(INPUT_STORM_EDGES, edges(1, INPUT_STORM_EDGES));
+}
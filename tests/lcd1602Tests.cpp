@@ -0,0 +1,203 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "lcd1602/lcd1602.h"
+}
+
+enum : uint8_t {
+    PORT_RS        = 0,
+    PORT_ENABLE    = 2,
+    PORT_BACKLIGHT = 3,
+    PORT_D4        = 4,
+};
+
+// Stands in for an I2C bus with a PCF8574 backpack: counts the transactions
+// and latches the nibbles on every falling edge of enable like the controller.
+static struct {
+    unsigned transactions;
+    unsigned states;
+    unsigned pin_writes;
+    uint8_t  port;
+    bool     port_valid;
+    bool     rs_settled;     // RS unchanged in the state raising enable
+    bool     backlight_held;
+    unsigned since_fall;     // states since the last falling edge
+    unsigned shortest_gap;   // fewest states from the end of one byte to the start of the next
+    uint8_t  bytes[64];
+    bool     data[64];
+    unsigned count;
+    unsigned nibbles;
+    uint8_t  high;
+} bus;
+
+static bool i2c_write(const uint8_t* states, unsigned count) {
+    bus.transactions++;
+    for (unsigned i = 0; i < count; i++, bus.states++) {
+        uint8_t state = states[i];
+        bool enable = state & (1 << PORT_ENABLE);
+        bool was_enabled = bus.port & (1 << PORT_ENABLE);
+
+        bus.backlight_held &= (bool)(state & (1 << PORT_BACKLIGHT));
+        bus.since_fall++;
+        if (bus.port_valid && enable && !was_enabled) {
+            bus.rs_settled &= !((state ^ bus.port) & (1 << PORT_RS));
+            if (bus.nibbles % 2 == 0 && bus.count > 0 && bus.since_fall < bus.shortest_gap)
+                bus.shortest_gap = bus.since_fall;
+        }
+        if (bus.port_valid && !enable && was_enabled) {
+            uint8_t nibble = bus.port >> PORT_D4;
+            if (bus.nibbles++ % 2 == 0) {
+                bus.high = nibble;
+            } else {
+                bus.data[bus.count] = bus.port & (1 << PORT_RS);
+                bus.bytes[bus.count++] = (uint8_t)(bus.high << 4 | nibble);
+            }
+            bus.since_fall = 0;
+        }
+        bus.port = state;
+        bus.port_valid = true;
+    }
+    return true;
+}
+
+static bool pin_set(pin_t pin, bool state) {
+    bus.pin_writes++;
+    return true;
+}
+
+static void wait(unsigned microseconds) {
+}
+
+TEST_GROUP(Lcd1602Tests) {
+    void setup() {
+    }
+
+    void teardown() {
+    }
+
+    void init(uint16_t byte_time) {
+        lcd1602_interface iface = {};
+
+        iface.pins = { PORT_RS, PORT_ENABLE, PORT_D4, PORT_D4 + 1, PORT_D4 + 2, PORT_D4 + 3 };
+        iface.port = { i2c_write, 1 << PORT_BACKLIGHT, byte_time };
+        start(iface);
+    }
+
+    void start(lcd1602_interface iface) {
+        lcd16x2_init_4bits(iface);
+        while (LCD1602_IDLE != lcd16x2_runStep())
+            ;
+        memset(&bus, 0, sizeof(bus));
+        bus.rs_settled = bus.backlight_held = true;
+        bus.shortest_gap = UINT32_MAX;
+    }
+
+    void run() {
+        while (LCD1602_IDLE != lcd16x2_runStep())
+            ;
+    }
+};
+
+TEST(Lcd1602Tests, CharacterIsOneTransaction) {
+    init(90);
+    CHECK_TRUE(lcd16x2_putChar('A'));
+    run();
+
+    CHECK_EQUAL(1, bus.transactions);
+    CHECK_EQUAL(1, bus.count);
+    CHECK_EQUAL('A', bus.bytes[0]);
+    CHECK_TRUE(bus.data[0]);
+    CHECK_TRUE(bus.backlight_held);
+}
+
+TEST(Lcd1602Tests, LineIsOneTransaction) {
+    const char* line = "Reflow 183/245C";
+
+    init(90);
+    CHECK_TRUE(lcd16x2_setCursor(1, 0));
+    CHECK_TRUE(lcd16x2_printf("%s", line));
+    run();
+
+    CHECK_EQUAL(1, bus.transactions);
+    CHECK_EQUAL(1 + strlen(line), bus.count);
+    CHECK_EQUAL(0xC0, bus.bytes[0]);
+    CHECK_FALSE(bus.data[0]);
+    for (unsigned i = 0; i < strlen(line); i++) {
+        CHECK_EQUAL(line[i], bus.bytes[1 + i]);
+        CHECK_TRUE(bus.data[1 + i]);
+    }
+    // RS changed once, in a state of its own ahead of enable
+    CHECK_EQUAL(4 * (1 + strlen(line)) + 1, bus.states);
+    CHECK_TRUE(bus.rs_settled);
+}
+
+TEST(Lcd1602Tests, FullLineIsAccepted) {
+    const char* line = "0123456789ABCDEF";
+
+    init(90);
+    CHECK_TRUE(lcd16x2_printf("%s", line));
+    CHECK_FALSE(lcd16x2_printf("%s0", line));
+    run();
+
+    CHECK_EQUAL(LCD1602_MAX_LINE_LEN, bus.count);
+    for (unsigned i = 0; i < LCD1602_MAX_LINE_LEN; i++)
+        CHECK_EQUAL(line[i], bus.bytes[i]);
+}
+
+TEST(Lcd1602Tests, FastBusIsPaddedToTheExecutionTime) {
+    const unsigned byte_time = 10;
+
+    init(byte_time);
+    CHECK_TRUE(lcd16x2_printf("%s", "0123"));
+    run();
+
+    CHECK_EQUAL(1, bus.transactions);
+    CHECK_EQUAL(4, bus.count);
+    CHECK_TRUE(bus.shortest_gap * byte_time >= LCD1602_EXECUTION_US);
+}
+
+TEST(Lcd1602Tests, LongStepEndsTheTransaction) {
+    init(90);
+    CHECK_TRUE(lcd16x2_clear());
+    CHECK_TRUE(lcd16x2_putChar('A'));
+
+    CHECK_EQUAL(LCD1602_LONG_EXECUTION_US, lcd16x2_runStep());
+    CHECK_EQUAL(1, bus.transactions);
+    CHECK_EQUAL(LCD1602_EXECUTION_US, lcd16x2_runStep());
+    CHECK_EQUAL(2, bus.transactions);
+    CHECK_EQUAL(LCD1602_IDLE, lcd16x2_runStep());
+    CHECK_EQUAL(0x01, bus.bytes[0]);
+    CHECK_EQUAL('A', bus.bytes[1]);
+}
+
+TEST(Lcd1602Tests, PinByPinWithoutPort) {
+    lcd1602_interface iface = {};
+
+    iface.pins = { 1, 4, 9, 6, 3, 2 };
+    iface.pin_set = pin_set;
+    iface.wait = wait;
+    start(iface);
+    CHECK_TRUE(lcd16x2_putChar('A'));
+    run();
+
+    CHECK_EQUAL(0, bus.transactions);
+    CHECK_EQUAL(13, bus.pin_writes);
+}
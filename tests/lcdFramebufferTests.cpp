@@ -0,0 +1,144 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "lcd_framebuffer.h"
+}
+
+// Stands in for the controller: DDRAM rows, the address counter and the
+// number of transfers it received.
+static struct {
+    uint8_t  cells[LCD_FRAMEBUFFER_ROWS][LCD_FRAMEBUFFER_COLUMNS];
+    unsigned row;
+    unsigned column;
+    unsigned transfers;
+    unsigned clears;
+} controller;
+
+static bool set_cursor(uint8_t row, uint8_t column) {
+    controller.row    = row;
+    controller.column = column;
+    controller.transfers++;
+    return true;
+}
+
+static bool put(uint8_t cell) {
+    if (controller.column < LCD_FRAMEBUFFER_COLUMNS)
+        controller.cells[controller.row][controller.column] = cell;
+    controller.column++;
+    controller.transfers++;
+    return true;
+}
+
+static bool clear(void) {
+    memset(controller.cells, LCD_FRAMEBUFFER_BLANK, sizeof(controller.cells));
+    controller.row = controller.column = 0;
+    controller.transfers++;
+    controller.clears++;
+    return true;
+}
+
+TEST_GROUP(LcdFramebufferTests) {
+    lcd_framebuffer_t displayed;
+    lcd_framebuffer_t shadow;
+    lcd_framebuffer_output_t output;
+
+    void setup() {
+        lcd_framebuffer_clear(&displayed);
+        lcd_framebuffer_clear(&shadow);
+        memset(&controller, 0, sizeof(controller));
+        memset(controller.cells, LCD_FRAMEBUFFER_BLANK, sizeof(controller.cells));
+        output = { set_cursor, put, clear, 41 };
+    }
+
+    void teardown() {
+    }
+
+    void print(unsigned row, unsigned column, const char* text) {
+        lcd_framebuffer_write(&shadow, row, column, reinterpret_cast<const uint8_t*>(text), strlen(text));
+    }
+
+    unsigned flush() {
+        unsigned transfers = lcd_framebuffer_flush(&displayed, &shadow, &output);
+        CHECK_EQUAL(0, memcmp(displayed.cells, shadow.cells, sizeof(shadow.cells)));
+        CHECK_EQUAL(0, memcmp(controller.cells, shadow.cells, sizeof(shadow.cells)));
+        CHECK_EQUAL(controller.transfers, transfers);
+        controller.transfers = 0;
+        return transfers;
+    }
+};
+
+TEST(LcdFramebufferTests, UnchangedScreenIsNotSent) {
+    print(0, 0, "Set");
+    flush();
+    CHECK_EQUAL(0, flush());
+}
+
+TEST(LcdFramebufferTests, ChangedDigitIsOneMoveAndOneWrite) {
+    print(0, 0, "Set");
+    print(1, 0, "temperature:200");
+    flush();
+    print(1, 12, "201");
+    CHECK_EQUAL(2, flush());
+}
+
+TEST(LcdFramebufferTests, AdjacentCellsShareTheCursorMove) {
+    print(1, 0, "temperature:199");
+    flush();
+    print(1, 12, "200");
+    CHECK_EQUAL(4, flush());
+}
+
+TEST(LcdFramebufferTests, WriteIsClippedAtTheRowEnd) {
+    CHECK_EQUAL(4, lcd_framebuffer_write(&shadow, 0, 12, reinterpret_cast<const uint8_t*>("ThermoPlate"), 11));
+    CHECK_EQUAL(0, lcd_framebuffer_write(&shadow, 2, 0, reinterpret_cast<const uint8_t*>("x"), 1));
+    flush();
+}
+
+TEST(LcdFramebufferTests, ClearIsUsedWhenCheaper) {
+    print(0, 0, "Constant");
+    print(1, 0, "temperature");
+    flush();
+    lcd_framebuffer_clear(&shadow);
+    print(0, 0, "JEDEC");
+    output.clear_cost = 1;
+    CHECK_EQUAL(7, flush());
+    CHECK_EQUAL(1, controller.clears);
+}
+
+// Editing the constant temperature used to redraw the whole screen after a
+// clear on every encoder step
+TEST(LcdFramebufferTests, TemperatureEditNeedsTenTimesFewerTransfers) {
+    const unsigned redraw = 1 + (1 + 3) + (1 + 12) + (1 + 3);
+    unsigned legacy = 0, transfers = 0;
+    char value[4];
+
+    print(0, 0, "Set");
+    print(1, 0, "temperature:180");
+    flush();
+    for (unsigned temperature = 181; temperature <= 260; temperature++) {
+        snprintf(value, sizeof(value), "%u", temperature);
+        print(1, 12, value);
+        transfers += flush();
+        legacy    += redraw;
+    }
+    CHECK_TRUE(legacy > 10 * transfers);
+}
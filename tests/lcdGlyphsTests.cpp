@@ -0,0 +1,170 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "lcd_glyphs.h"
+}
+
+// Stands in for CGRAM
+static struct {
+    uint8_t  cgram[LCD_GLYPH_SLOTS][LCD_GLYPH_ROWS];
+    unsigned uploads;
+    unsigned accepted; // uploads going through before the queue runs full
+} controller;
+
+static bool upload(uint8_t slot, const uint8_t bitmap[LCD_GLYPH_ROWS]) {
+    if (controller.uploads == controller.accepted)
+        return false;
+    memcpy(controller.cgram[slot], bitmap, LCD_GLYPH_ROWS);
+    controller.uploads++;
+    return true;
+}
+
+TEST_GROUP(LcdGlyphsTests) {
+    lcd_glyph_cache_t cache;
+    lcd_framebuffer_t screen;
+    lcd_framebuffer_t displayed;
+
+    void setup() {
+        lcd_glyph_cache_init(&cache);
+        lcd_framebuffer_clear(&displayed);
+        memset(&controller, 0, sizeof(controller));
+        controller.accepted = UINT32_MAX;
+    }
+
+    void teardown() {
+    }
+
+    // Resolves a screen showing the glyphs in its first row and displays it
+    bool show(const uint8_t* glyphs, unsigned count) {
+        lcd_framebuffer_clear(&screen);
+        lcd_framebuffer_write(&screen, 0, 0, glyphs, count);
+        bool uploaded = lcd_glyph_resolve(&cache, &screen, &displayed, upload);
+        displayed = screen;
+        return uploaded;
+    }
+
+    // Glyph the controller shows in a cell
+    const uint8_t* shown(unsigned column) {
+        uint8_t cell = displayed.cells[0][column];
+        return cell < LCD_GLYPH_SLOTS ? controller.cgram[cell] : nullptr;
+    }
+};
+
+TEST(LcdGlyphsTests, LoadedGlyphsAreNotUploadedAgain) {
+    const uint8_t glyphs[] = { LCD_GLYPH_HEART, LCD_GLYPH_ARROW_UP, LCD_GLYPH_HEART };
+
+    CHECK_TRUE(show(glyphs, sizeof(glyphs)));
+    CHECK_EQUAL(2, controller.uploads);
+    CHECK_TRUE(show(glyphs, sizeof(glyphs)));
+    CHECK_EQUAL(2, controller.uploads);
+
+    CHECK_EQUAL(displayed.cells[0][0], displayed.cells[0][2]);
+    CHECK_EQUAL(0, memcmp(lcd_glyph_bitmap(LCD_GLYPH_HEART), shown(0), LCD_GLYPH_ROWS));
+    CHECK_EQUAL(0, memcmp(lcd_glyph_bitmap(LCD_GLYPH_ARROW_UP), shown(1), LCD_GLYPH_ROWS));
+}
+
+TEST(LcdGlyphsTests, LeastRecentlyUsedIsEvicted) {
+    for (uint8_t glyph = LCD_GLYPH_FIRST; glyph < LCD_GLYPH_FIRST + LCD_GLYPH_SLOTS; glyph++)
+        CHECK_TRUE(show(&glyph, 1));
+    const uint8_t recent = LCD_GLYPH_HEART;
+    CHECK_TRUE(show(&recent, 1));
+    CHECK_EQUAL(LCD_GLYPH_SLOTS, controller.uploads);
+
+    // Only the heart on display, the plate program icon is the oldest one
+    const uint8_t missing = LCD_GLYPH_LEVEL_7;
+    CHECK_TRUE(show(&missing, 1));
+    CHECK_EQUAL(LCD_GLYPH_SLOTS + 1, controller.uploads);
+    const uint8_t evicted = LCD_GLYPH_PLATE_PROGRAM;
+    CHECK_TRUE(show(&evicted, 1));
+    CHECK_EQUAL(LCD_GLYPH_SLOTS + 2, controller.uploads);
+    CHECK_TRUE(show(&recent, 1));
+    CHECK_EQUAL(LCD_GLYPH_SLOTS + 2, controller.uploads);
+}
+
+TEST(LcdGlyphsTests, DisplayedSlotsAreEvictedLast) {
+    const uint8_t first[] = { LCD_GLYPH_HEART, LCD_GLYPH_ARROW_UP, LCD_GLYPH_ARROW_DOWN, LCD_GLYPH_BAR_1,
+                              LCD_GLYPH_BAR_2, LCD_GLYPH_BAR_3, LCD_GLYPH_BAR_4, LCD_GLYPH_LEVEL_1 };
+    CHECK_TRUE(show(first, sizeof(first)));
+    const uint8_t heart = displayed.cells[0][0];
+    CHECK_TRUE(show(first + 1, sizeof(first) - 1));
+
+    // A flush cut short left the heart on display, the least recently used slot
+    lcd_framebuffer_clear(&displayed);
+    displayed.cells[0][0] = heart;
+    lcd_framebuffer_clear(&screen);
+    screen.cells[0][0] = LCD_GLYPH_LEVEL_2;
+    CHECK_TRUE(lcd_glyph_resolve(&cache, &screen, &displayed, upload));
+    CHECK_TRUE(heart != screen.cells[0][0]);
+    CHECK_EQUAL(0, memcmp(lcd_glyph_bitmap(LCD_GLYPH_HEART), shown(0), LCD_GLYPH_ROWS));
+}
+
+TEST(LcdGlyphsTests, EvictedCellsDifferFromTheScreen) {
+    const uint8_t first[] = { LCD_GLYPH_HEART, LCD_GLYPH_ARROW_UP, LCD_GLYPH_ARROW_DOWN, LCD_GLYPH_BAR_1,
+                              LCD_GLYPH_BAR_2, LCD_GLYPH_BAR_3, LCD_GLYPH_BAR_4, LCD_GLYPH_LEVEL_1 };
+    const uint8_t second[] = { LCD_GLYPH_LEVEL_2, LCD_GLYPH_ARROW_UP, LCD_GLYPH_ARROW_DOWN, LCD_GLYPH_BAR_1,
+                               LCD_GLYPH_BAR_2, LCD_GLYPH_BAR_3, LCD_GLYPH_BAR_4, LCD_GLYPH_LEVEL_1 };
+    CHECK_TRUE(show(first, sizeof(first)));
+    CHECK_TRUE(show(second, sizeof(second)));
+
+    for (unsigned column = 0; column < sizeof(second); column++)
+        CHECK_EQUAL(0, memcmp(lcd_glyph_bitmap(static_cast<lcd_glyph>(second[column])), shown(column),
+                              LCD_GLYPH_ROWS));
+}
+
+TEST(LcdGlyphsTests, GlyphsBeyondTheSlotsAreBlanked) {
+    uint8_t glyphs[LCD_GLYPH_SLOTS + 1];
+    for (unsigned i = 0; i < sizeof(glyphs); i++)
+        glyphs[i] = static_cast<uint8_t>(LCD_GLYPH_FIRST + i);
+
+    CHECK_TRUE(show(glyphs, sizeof(glyphs)));
+    CHECK_EQUAL(LCD_GLYPH_SLOTS, controller.uploads);
+    CHECK_EQUAL(LCD_FRAMEBUFFER_BLANK, displayed.cells[0][LCD_GLYPH_SLOTS]);
+}
+
+TEST(LcdGlyphsTests, FailedUploadIsRetried) {
+    const uint8_t glyphs[] = { LCD_GLYPH_HEART, LCD_GLYPH_ARROW_UP };
+
+    controller.accepted = 1;
+    CHECK_FALSE(show(glyphs, sizeof(glyphs)));
+    CHECK_EQUAL(LCD_FRAMEBUFFER_BLANK, displayed.cells[0][1]);
+    controller.accepted = UINT32_MAX;
+    CHECK_TRUE(show(glyphs, sizeof(glyphs)));
+    CHECK_EQUAL(2, controller.uploads);
+    CHECK_EQUAL(0, memcmp(lcd_glyph_bitmap(LCD_GLYPH_ARROW_UP), shown(1), LCD_GLYPH_ROWS));
+}
+
+TEST(LcdGlyphsTests, BarAndLevelCells) {
+    uint8_t bar[4];
+
+    lcd_glyph_bar(bar, sizeof(bar), 450);
+    CHECK_EQUAL(LCD_GLYPH_FULL, bar[0]);
+    CHECK_EQUAL(LCD_GLYPH_BAR_4, bar[1]);
+    CHECK_EQUAL(LCD_FRAMEBUFFER_BLANK, bar[2]);
+    lcd_glyph_bar(bar, sizeof(bar), 1000);
+    CHECK_EQUAL(LCD_GLYPH_FULL, bar[3]);
+
+    CHECK_EQUAL(LCD_FRAMEBUFFER_BLANK, lcd_glyph_level(0));
+    CHECK_EQUAL(LCD_GLYPH_LEVEL_3, lcd_glyph_level(3));
+    CHECK_EQUAL(LCD_GLYPH_FULL, lcd_glyph_level(LCD_GLYPH_LEVEL_STEPS));
+    CHECK_EQUAL(0x1F, lcd_glyph_bitmap(LCD_GLYPH_LEVEL_3)[LCD_GLYPH_ROWS - 1]);
+    CHECK_EQUAL(0, lcd_glyph_bitmap(LCD_GLYPH_LEVEL_3)[LCD_GLYPH_ROWS - 4]);
+    CHECK_EQUAL(0x1C, lcd_glyph_bitmap(LCD_GLYPH_BAR_3)[0]);
+}
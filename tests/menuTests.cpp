@@ -16,39 +16,249 @@
 
 #include "CppUTest/TestHarness.h"
 #include "CppUTestExt/MockSupport.h"
-#include "encoder.h"
+#include <cstring>
 #include <unistd.h>
 
 extern "C" {
 #include "FreeRTOS.h"
 #include "task.h"
+#include "encoder_velocity.h"
+#include "heat_controller_interface.h"
 #include "menu.h"
+#include "menu_definitions.h"
 #include "utilities/scheduler.h"
 }
 
+static heater_request last_request;
+
+static void capture_request(void* args) {
+    last_request = *static_cast<heater_request*>(args);
+}
+
 TEST_GROUP(MenuTests) {
+    encoder_velocity_t tracker;
+    miliseconds        clock;
+
     void setup() {
-        mock().expectNCalls(1, "lcd_send_request_string").andReturnValue(ERROR_ANY);
+        memset(&tracker, 0, sizeof(tracker));
+        clock = 0;
+        mock().expectNCalls(1, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
         menu_init();
     }
 
     void teardown() {
     }
+
+    void send(menu_event_type type) {
+        menu_event_t event = {type, 0};
+        scheduler_enqueue(SchedulerQueueMenu, &event);
+    }
+
+    // Synthetic encoder: detents the given interval apart, timed like encoder.c does
+    void spin(unsigned detents, miliseconds interval, bool clockwise) {
+        for (unsigned i = 0; i < detents; i++) {
+            clock += interval;
+            menu_event_t event = {clockwise ? MENU_EVENT_ENCODER_UP : MENU_EVENT_ENCODER_DOWN,
+                                  encoder_velocity_update(&tracker, clock, clockwise)};
+            scheduler_enqueue(SchedulerQueueMenu, &event);
+        }
+    }
 };
 
-error_status_t lcd_send_request_string(unsigned line, unsigned position, const char* str, ...) {
-    return static_cast<error_status_t>(mock().actualCall("lcd_send_request_string").returnIntValue());
+TEST(MenuTests, GoToJedecTest) {
+    mock().expectNCalls(2, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_DOWN);
+
+    mock().checkExpectations();
+    mock().clear();
 }
 
-TEST(MenuTests, GoToJedecTest) {
-    encoder_event_type push = ENCODER_EVENT_PUSH;
-    encoder_event_type down = ENCODER_EVENT_DOWN;
-    mock().expectNCalls(2, "lcd_send_clean").andReturnValue(ERROR_ANY);
-    mock().expectNCalls(3, "lcd_send_request_string").andReturnValue(ERROR_ANY);
+TEST(MenuTests, RunningStatusIsRateLimited) {
+    mock().expectNCalls(3, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    mock().expectOneCall("thermocouple_sampler_latest").ignoreOtherParameters().andReturnValue(false);
+    mock().expectOneCall("heat_controller_get_status").ignoreOtherParameters().andReturnValue(false);
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_DOWN);
+    send(MENU_EVENT_ENCODER_PUSH);
+    // Right after the first draw, the tick is within the cap and touches nothing
+    send(MENU_EVENT_STATUS_TICK);
+
+    mock().checkExpectations();
+    mock().clear();
 
-    scheduler_enqueue(SchedulerQueueMenu, &push);
-    scheduler_enqueue(SchedulerQueueMenu, &down);
+    mock().expectOneCall("lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    send(MENU_EVENT_REQUEST_DONE);
+    // Ticks left in the queue after the heating are dropped
+    send(MENU_EVENT_STATUS_TICK);
 
     mock().checkExpectations();
     mock().clear();
 }
+
+TEST(MenuTests, LongPressCancelsRunningHeating) {
+    mock().expectNCalls(3, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    mock().expectOneCall("thermocouple_sampler_latest").ignoreOtherParameters().andReturnValue(false);
+    mock().expectOneCall("heat_controller_get_status").ignoreOtherParameters().andReturnValue(false);
+    CHECK(scheduler_subscribe(SchedulerQueueHeatControlerInterface, capture_request));
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_DOWN);
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_CANCEL);
+
+    CHECK(scheduler_unsubscribe(SchedulerQueueHeatControlerInterface, capture_request));
+    CHECK_EQUAL(HEATING_REQUEST_CANCEL, last_request.type);
+    mock().checkExpectations();
+    mock().clear();
+
+    // The cancelled job finishes like any other
+    mock().expectOneCall("lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    send(MENU_EVENT_REQUEST_DONE);
+    mock().checkExpectations();
+    mock().clear();
+}
+
+TEST(MenuTests, DoubleClickStepsBackAndLongPressLeavesValueEntry) {
+    mock().expectNCalls(5, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_BACK);
+    send(MENU_EVENT_ENCODER_CANCEL);
+
+    mock().checkExpectations();
+    mock().clear();
+}
+
+TEST(MenuTests, FastSpinsAccelerateValueEntry) {
+    // Entering both values and the running screen, the turns in between don't redraw within the cap
+    mock().expectNCalls(5, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    mock().expectOneCall("thermocouple_sampler_latest").ignoreOtherParameters().andReturnValue(false);
+    mock().expectOneCall("heat_controller_get_status").ignoreOtherParameters().andReturnValue(false);
+    CHECK(scheduler_subscribe(SchedulerQueueHeatControlerInterface, capture_request));
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    // The first detent of a spin is a single step, the rest runs at 50 per second
+    spin(6, 20, true);
+    send(MENU_EVENT_ENCODER_PUSH);
+    spin(12, 20, true);
+    // After a pause single steps are back
+    spin(2, 500, false);
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_REQUEST_DONE);
+
+    CHECK(scheduler_unsubscribe(SchedulerQueueHeatControlerInterface, capture_request));
+    CHECK_EQUAL(HEATING_REQUEST_CONSTANT, last_request.type);
+    CHECK_EQUAL(250U, last_request.constant.const_temperature);
+    CHECK_EQUAL(598U, last_request.constant.duration);
+    mock().checkExpectations();
+    mock().clear();
+}
+
+TEST(MenuTests, SlowTurnsStepByOneAndSnapAfterSpins) {
+    mock().expectNCalls(2, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    spin(3, 300, true);
+    // 15 detents per second step by 10, snapping to the grid first
+    spin(3, 66, false);
+    spin(5, 66, true);
+    spin(1, 300, true);
+
+    mock().checkExpectations();
+    mock().clear();
+
+    mock().expectNCalls(1, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    mock().expectOneCall("thermocouple_sampler_latest").ignoreOtherParameters().andReturnValue(false);
+    mock().expectOneCall("heat_controller_get_status").ignoreOtherParameters().andReturnValue(false);
+    CHECK(scheduler_subscribe(SchedulerQueueHeatControlerInterface, capture_request));
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    CHECK(scheduler_unsubscribe(SchedulerQueueHeatControlerInterface, capture_request));
+    CHECK_EQUAL(41U, last_request.constant.const_temperature);
+    mock().checkExpectations();
+    mock().clear();
+
+    mock().expectNCalls(1, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    send(MENU_EVENT_REQUEST_DONE);
+    mock().checkExpectations();
+    mock().clear();
+}
+
+TEST(MenuTests, ValueEntryStopsAtItsRange) {
+    mock().expectNCalls(4, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    mock().expectOneCall("thermocouple_sampler_latest").ignoreOtherParameters().andReturnValue(false);
+    mock().expectOneCall("heat_controller_get_status").ignoreOtherParameters().andReturnValue(false);
+    CHECK(scheduler_subscribe(SchedulerQueueHeatControlerInterface, capture_request));
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    spin(30, 20, true);
+    send(MENU_EVENT_ENCODER_PUSH);
+    spin(3, 300, false);
+    send(MENU_EVENT_ENCODER_PUSH);
+
+    CHECK(scheduler_unsubscribe(SchedulerQueueHeatControlerInterface, capture_request));
+    CHECK_EQUAL(HEATING_REQUEST_CONSTANT, last_request.type);
+    CHECK_EQUAL(300U, last_request.constant.const_temperature);
+    CHECK_EQUAL(0U, last_request.constant.duration);
+    mock().checkExpectations();
+    mock().clear();
+
+    mock().expectOneCall("lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    send(MENU_EVENT_REQUEST_DONE);
+    mock().checkExpectations();
+    mock().clear();
+}
+
+TEST(MenuTests, SkippedRedrawIsDeferred) {
+    mock().expectNCalls(2, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+
+    send(MENU_EVENT_ENCODER_PUSH);
+    send(MENU_EVENT_ENCODER_PUSH);
+    spin(10, 20, true);
+
+    mock().checkExpectations();
+    mock().clear();
+
+    // The last value shows up once the cap expires
+    mock().expectNCalls(1, "lcd_submit_screen").ignoreOtherParameters().andReturnValue(ERROR_ANY);
+    vTaskDelay(pdMS_TO_TICKS(2 * MENU_VALUE_MIN_PERIOD_MS));
+
+    mock().checkExpectations();
+    mock().clear();
+}
+
+TEST_GROUP(EncoderVelocityTests) {
+    encoder_velocity_t tracker;
+
+    void setup() {
+        memset(&tracker, 0, sizeof(tracker));
+    }
+};
+
+TEST(EncoderVelocityTests, SlowDetentsReadZero) {
+    for (miliseconds now = 300; now < 3000; now += 300)
+        CHECK_EQUAL(0U, encoder_velocity_update(&tracker, now, true));
+}
+
+TEST(EncoderVelocityTests, SpinReadsDetentsPerSecond) {
+    CHECK_EQUAL(0U, encoder_velocity_update(&tracker, 1000, true));
+    CHECK_EQUAL(50U, encoder_velocity_update(&tracker, 1020, true));
+    CHECK_EQUAL(50U, encoder_velocity_update(&tracker, 1040, true));
+    // Slowing down is followed through the average
+    CHECK_EQUAL(30U, encoder_velocity_update(&tracker, 1140, true));
+}
+
+TEST(EncoderVelocityTests, ReversalStartsANewRun) {
+    encoder_velocity_update(&tracker, 1000, true);
+    encoder_velocity_update(&tracker, 1020, true);
+    CHECK_EQUAL(0U, encoder_velocity_update(&tracker, 1040, false));
+    CHECK_EQUAL(50U, encoder_velocity_update(&tracker, 1060, false));
+}
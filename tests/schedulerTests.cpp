@@ -16,7 +16,10 @@
 
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
-#include <atomic>
+
+#include <memory>
+
+#include "simulation.h"
 
 extern "C" {
 #include <stdio.h>
@@ -26,18 +29,18 @@ extern "C" {
 #include "utilities/scheduler.h"
 }
 
-static std::atomic<bool> is_test_finished(false);
+static constexpr miliseconds test_timeout_ms(1000);
 
 static inline void set_test_end(void) {
-    std::atomic_store_explicit(&is_test_finished, true, std::memory_order_relaxed);
+    simulation_signal_done();
 };
 
 static inline void set_test_start(void) {
-    std::atomic_store_explicit(&is_test_finished, false, std::memory_order_relaxed);
+    simulation_reset_done();
 };
 
-static inline bool get_test_status(void) {
-    return std::atomic_load_explicit(&is_test_finished, std::memory_order_relaxed);
+static inline bool wait_for_test_end(miliseconds timeout = test_timeout_ms) {
+    return simulation_wait_done(timeout);
 };
 
 TEST_GROUP(EventSchedulerTests) {
@@ -63,7 +66,7 @@ TEST(EventSchedulerTests, SendOneEventCustomStructCallOneCallback) {
         .payload_two  = -1
     });
     CHECK_EQUAL(true, scheduler_enqueue(SchedulerQueueTestStruct, &custom_struct));
-    while (!get_test_status());
+    CHECK(wait_for_test_end());
     CHECK_EQUAL(true, scheduler_unsubscribe(SchedulerQueueTestStruct, send_callback));
 }
 
@@ -85,6 +88,6 @@ TEST(EventSchedulerTests, SendMultipleEventUnsignedCallOneCallback) {
     while (no_of_messages-- > 0)
         CHECK_EQUAL(true, scheduler_enqueue(SchedulerQueueTest, std::make_unique<unsigned>(0xDEADBEEF).get()));
 
-    while (!get_test_status());
+    CHECK(wait_for_test_end());
     CHECK_EQUAL(true, scheduler_unsubscribe(SchedulerQueueTest, send_callback));
 }
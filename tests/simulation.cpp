@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "simulation.h"
+
+#include <csignal>
+
+extern "C" {
+#include "task.h"
+#include "semphr.h"
+}
+
+static struct {
+    StaticSemaphore_t done_resource;
+    SemaphoreHandle_t done;
+    TickType_t        pending_jump;
+} ctx;
+
+void simulation_init(void) {
+    ctx.done = xSemaphoreCreateBinaryStatic(&ctx.done_resource);
+}
+
+miliseconds simulation_now(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+void simulation_reset_done(void) {
+    (void) xSemaphoreTake(ctx.done, 0);
+}
+
+void simulation_signal_done(void) {
+    (void) xSemaphoreGive(ctx.done);
+}
+
+bool simulation_wait_done(miliseconds timeout) {
+    return pdTRUE == xSemaphoreTake(ctx.done, pdMS_TO_TICKS(timeout));
+}
+
+#if (configSIMULATION_VIRTUAL_TIME == 1)
+
+// The timer daemon is the first task to run once the scheduler is started, so
+// this is the earliest point the tick signal installed by the port can be
+// silenced. From now on the tick count moves only in simulation_idle_hook().
+extern "C" void vApplicationDaemonTaskStartupHook(void) {
+    std::signal(SIGALRM, SIG_IGN);
+}
+
+// Invoked by the idle task with the scheduler suspended, after the kernel made
+// sure no task is ready and nothing unblocks for the next ulExpectedIdleTime
+// ticks. Ticks can't be caught up while suspended, so the jump is only noted
+// here and performed by the following simulation_idle_hook() call.
+extern "C" void vSimulationSuppressTicksAndSleep(unsigned long ulExpectedIdleTime) {
+    ctx.pending_jump = ulExpectedIdleTime;
+}
+
+void simulation_idle_hook(void) {
+    // No pending jump means the kernel expects something to unblock within a
+    // tick (below configEXPECTED_IDLE_TIME_BEFORE_SLEEP), so step just one.
+    TickType_t jump = ctx.pending_jump != 0 ? ctx.pending_jump : 1;
+
+    ctx.pending_jump = 0;
+    (void) xTaskCatchUpTicks(jump);
+}
+
+#else
+
+void simulation_idle_hook(void) {
+}
+
+#endif // if (configSIMULATION_VIRTUAL_TIME == 1)
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TESTS_SIMULATION_
+#define _TESTS_SIMULATION_
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "utilities/types.h"
+}
+
+// Must be called before vTaskStartScheduler().
+void simulation_init(void);
+
+// Called from vApplicationIdleHook(); advances the virtual clock when enabled.
+void simulation_idle_hook(void);
+
+miliseconds simulation_now(void);
+
+// Completion event used by tests instead of spinning on a flag, so the calling
+// task blocks and lets the idle task move the virtual clock forward.
+void simulation_reset_done(void);
+void simulation_signal_done(void);
+bool simulation_wait_done(miliseconds timeout);
+
+#endif // _TESTS_SIMULATION_
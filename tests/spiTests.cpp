@@ -0,0 +1,243 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+#include <cstring>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "task.h"
+#include "driver/spi_master.h"
+#include "nvs.h"
+#include "spi.h"
+#include "utilities/timer.h"
+}
+
+// Stands in for the ESP-IDF master driver: a transaction stays queued until
+// the test finishes it on the bus, and a device holding one can't be removed.
+struct spi_device_t {
+    spi_device_interface_config_t config;
+    spi_transaction_t*            queued;
+    spi_transaction_t*            done;  // until spi_device_get_trans_result()
+    bool                          is_added;
+};
+
+static struct {
+    spi_device_t device[6];
+    uint8_t      frame[2];   // MAX6675 readout of 400 degC
+} bus;
+
+static struct {
+    unsigned       count;
+    error_status_t status;
+    temperature_t  hot;
+} readouts;
+
+extern "C" {
+esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t*, spi_dma_chan_t) {
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle) {
+    for (spi_device_t& device : bus.device) {
+        if (!device.is_added) {
+            device = { *config, NULL, NULL, true };
+            *handle = &device;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+    if (handle->queued != NULL || handle->done != NULL)
+        return ESP_ERR_INVALID_STATE;
+    handle->is_added = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t) {
+    if (handle->queued != NULL || handle->done != NULL)
+        return ESP_ERR_TIMEOUT;
+    handle->queued = trans_desc;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc, TickType_t) {
+    if (handle->done == NULL)
+        return ESP_ERR_TIMEOUT;
+    *trans_desc  = handle->done;
+    handle->done = NULL;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t, spi_transaction_t* trans_desc) {
+    memcpy(trans_desc->rx_buffer, bus.frame, trans_desc->rxlength / CHAR_BIT);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char*, nvs_open_mode_t, nvs_handle_t*) {
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t, const char*, uint8_t*) {
+    return ESP_ERR_NOT_FOUND;
+}
+
+void nvs_close(nvs_handle_t) {
+}
+}
+
+static void on_readout(spi_dev_t, error_status_t status, const void* data, void*) {
+    readouts.count++;
+    readouts.status = status;
+    readouts.hot    = static_cast<const thermocouple_reading_t*>(data)->hot;
+}
+
+static void idle_routine(void*, uint32_t) {
+}
+
+TEST_GROUP(SpiTests) {
+    void setup() {
+        memset(&bus, 0, sizeof(bus));
+        memset(&readouts, 0, sizeof(readouts));
+        bus.frame[0] = 0x0C;
+        bus.frame[1] = 0x80;
+        CHECK_EQUAL(ERROR_ANY, spi_init());
+    }
+
+    void teardown() {
+        CHECK_EQUAL(1U, added_devices());
+        CHECK_TRUE(in_flight() == NULL);
+    }
+
+    unsigned added_devices() {
+        unsigned count = 0;
+        for (const spi_device_t& device : bus.device)
+            count += device.is_added;
+        return count;
+    }
+
+    // Newest device with a transaction on the bus
+    spi_device_t* in_flight() {
+        spi_device_t* found = NULL;
+        for (spi_device_t& device : bus.device)
+            found = device.is_added && device.queued != NULL ? &device : found;
+        return found;
+    }
+
+    // The bus finished the transaction, the interrupt runs post_cb unless it got lost
+    void finish(spi_device_t* device, bool is_interrupted = true) {
+        spi_transaction_t* transaction = device->queued;
+        memcpy(transaction->rx_buffer, bus.frame, transaction->rxlength / CHAR_BIT);
+        device->queued = NULL;
+        device->done   = transaction;
+        is_interrupted ? device->config.post_cb(transaction) : (void) 0;
+    }
+
+    // Every tick and oneshot shares the timer command queue, a burst of them leaves no room
+    void fill_timer_queue() {
+        while (ERROR_ANY == timer_soft_irq(idle_routine, NULL, 0)) {
+        }
+    }
+};
+
+TEST(SpiTests, FinishedReadIsDelivered) {
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+    CHECK_EQUAL(ERROR_ACTION_ALREADY_REQUESTED, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+
+    finish(in_flight());
+    vTaskDelay(1);
+
+    CHECK_EQUAL(1U, readouts.count);
+    CHECK_EQUAL(ERROR_ANY, readouts.status);
+    CHECK_EQUAL(400, readouts.hot);
+    CHECK_EQUAL(ERROR_ANY, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(1U, readouts.count);
+}
+
+TEST(SpiTests, LostDeliveryIsCollected) {
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+
+    vTaskSuspendAll();
+    fill_timer_queue();
+    finish(in_flight());
+    xTaskResumeAll();
+    vTaskDelay(1);
+    CHECK_EQUAL(0U, readouts.count);
+
+    CHECK_EQUAL(ERROR_ANY, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(1U, readouts.count);
+    CHECK_EQUAL(ERROR_ANY, readouts.status);
+    CHECK_EQUAL(400, readouts.hot);
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+    finish(in_flight());
+    vTaskDelay(1);
+    CHECK_EQUAL(2U, readouts.count);
+}
+
+TEST(SpiTests, OverdueReadIsCollectedWithoutInterrupt) {
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+    finish(in_flight(), false);
+
+    vTaskDelay(pdMS_TO_TICKS(SPI_ASYNC_READ_TIMEOUT_MS / 2));
+    CHECK_EQUAL(ERROR_ANY, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(0U, readouts.count);
+
+    vTaskDelay(pdMS_TO_TICKS(SPI_ASYNC_READ_TIMEOUT_MS));
+    CHECK_EQUAL(ERROR_ANY, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(1U, readouts.count);
+    CHECK_EQUAL(ERROR_ANY, readouts.status);
+}
+
+TEST(SpiTests, OverdueReadHeldByDriverIsGivenUp) {
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+    spi_device_t* wedged = in_flight();
+
+    vTaskDelay(pdMS_TO_TICKS(SPI_ASYNC_READ_TIMEOUT_MS));
+    CHECK_EQUAL(ERROR_TIMEOUT, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(ERROR_ANY, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(2U, added_devices());
+
+    // The next read goes to the device added again while the driver still holds the old one
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+    spi_device_t* replacement = in_flight();
+    CHECK_TRUE(replacement != wedged);
+    finish(replacement);
+    vTaskDelay(1);
+    CHECK_EQUAL(1U, readouts.count);
+    CHECK_EQUAL(ERROR_ANY, readouts.status);
+
+    // Given back late, the abandoned read is dropped and its device removed
+    finish(wedged);
+    vTaskDelay(1);
+    CHECK_EQUAL(1U, readouts.count);
+}
+
+TEST(SpiTests, AbandonedReadIsReclaimedOnCollect) {
+    CHECK_EQUAL(ERROR_ANY, spi_read_async(SpiDeviceThermocoupleAfe, on_readout, NULL));
+    spi_device_t* wedged = in_flight();
+
+    vTaskDelay(pdMS_TO_TICKS(SPI_ASYNC_READ_TIMEOUT_MS));
+    CHECK_EQUAL(ERROR_TIMEOUT, spi_collect_async(SpiDeviceThermocoupleAfe));
+
+    finish(wedged, false);
+    CHECK_EQUAL(ERROR_ANY, spi_collect_async(SpiDeviceThermocoupleAfe));
+    CHECK_EQUAL(0U, readouts.count);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "status_screen.h"
+}
+
+TEST_GROUP(StatusScreenTests) {
+    lcd_framebuffer_t screen;
+    status_screen_t   status;
+
+    void setup() {
+        memset(&status, 0, sizeof(status));
+    }
+
+    void check_row(unsigned row, const char* expected) {
+        char text[LCD_FRAMEBUFFER_COLUMNS + 1] = {0};
+        memcpy(text, screen.cells[row], LCD_FRAMEBUFFER_COLUMNS);
+        STRCMP_EQUAL(expected, text);
+    }
+};
+
+TEST(StatusScreenTests, RunningHeatingShowsAllFields) {
+    status.has_temperature = true;
+    status.temperature     = temperature_from_celcius(183) + TEMPERATURE_ONE / 2;
+    status.is_heating      = true;
+    status.setpoint        = 245;
+    status.power           = 45;
+    status.stage           = 1;
+    status.remaining       = 151;
+    status_screen_render(&status, &screen);
+
+    check_row(0, "183.5C /245C S2 ");
+    check_row(1, "P 45%  ETA 02:31");
+}
+
+TEST(StatusScreenTests, MissingDataIsDashed) {
+    status_screen_render(&status, &screen);
+
+    check_row(0, "---.-C /---C    ");
+    check_row(1, "P --%  ETA --:--");
+}
+
+TEST(StatusScreenTests, LongRemainingTimeSaturates) {
+    status.is_heating = true;
+    status.power      = 250;
+    status.remaining  = 200 * 60;
+    status_screen_render(&status, &screen);
+
+    check_row(1, "P100%  ETA 99:59");
+}
+
+TEST(StatusScreenTests, LayoutDoesNotMoveWithTheValues) {
+    lcd_framebuffer_t hot;
+
+    status.has_temperature = true;
+    status.is_heating      = true;
+    status.temperature     = temperature_from_celcius(25);
+    status.setpoint        = 50;
+    status_screen_render(&status, &screen);
+    status.temperature     = temperature_from_celcius(217);
+    status.setpoint        = 217;
+    status_screen_render(&status, &hot);
+
+    check_row(0, " 25.0C / 50C S1 ");
+    for (unsigned column : {3U, 5U, 6U, 7U, 11U, 12U, 13U})
+        BYTES_EQUAL(screen.cells[0][column], hot.cells[0][column]);
+}
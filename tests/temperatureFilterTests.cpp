@@ -0,0 +1,63 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "temperature.h"
+#include "temperature_filter.h"
+}
+
+TEST_GROUP(TemperatureFilterTests) {
+    temperature_filter_t filter;
+
+    void setup() {
+    }
+
+    void teardown() {
+    }
+};
+
+TEST(TemperatureFilterTests, MedianRejectsSingleSpike) {
+    const temperature_t trace[] = { 400, 401, 480, 399, 400 };
+
+    temperature_filter_init(&filter, { 3, 0 });
+    for (temperature_t sample : trace)
+        CHECK_TRUE(temperature_filter_apply(&filter, sample) <= 401);
+}
+
+TEST(TemperatureFilterTests, IirSettlesOnStep) {
+    temperature_t output = 0;
+
+    temperature_filter_init(&filter, { 1, 2 });
+    CHECK_EQUAL(100, temperature_filter_apply(&filter, 100));
+    for (unsigned i = 0; i < 64; i++)
+        output = temperature_filter_apply(&filter, 200);
+    CHECK_EQUAL(200, output);
+}
+
+TEST(TemperatureFilterTests, DisabledStagesPassSamplesThrough) {
+    temperature_filter_init(&filter, { 1, 0 });
+    CHECK_EQUAL(-7, temperature_filter_apply(&filter, -7));
+    CHECK_EQUAL(1023, temperature_filter_apply(&filter, 1023));
+}
+
+TEST(TemperatureFilterTests, ConversionsKeepQuarterDegrees) {
+    CHECK_EQUAL(1000, temperature_from_celcius(250));
+    DOUBLES_EQUAL(-1.25f, temperature_to_float(-5), 1e-6f);
+    CHECK_EQUAL(25025, temperature_to_centi(1001));
+    CHECK_EQUAL(INT16_MAX, temperature_to_centi(temperature_from_celcius(400)));
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "thermocouple_driver.h"
+}
+
+TEST_GROUP(ThermocoupleDriverTests) {
+    thermocouple_reading_t reading;
+
+    void setup() {
+        reading = {};
+    }
+
+    void teardown() {
+    }
+
+    bool decode(thermocouple_driver_id id, const uint8_t* frame) {
+        const thermocouple_driver_t* driver = thermocouple_driver_get(id);
+        CHECK_TRUE(driver != NULL);
+        return thermocouple_decode(driver, frame, &reading);
+    }
+};
+
+TEST(ThermocoupleDriverTests, UnknownDriverIsRejected) {
+    CHECK_TRUE(thermocouple_driver_get(THERMOCOUPLE_DRIVER_LAST) == NULL);
+}
+
+TEST(ThermocoupleDriverTests, OnlyMax31856NeedsMosi) {
+    CHECK_FALSE(thermocouple_driver_needs_mosi(thermocouple_driver_get(THERMOCOUPLE_MAX6675)));
+    CHECK_FALSE(thermocouple_driver_needs_mosi(thermocouple_driver_get(THERMOCOUPLE_MAX31855)));
+    CHECK_TRUE(thermocouple_driver_needs_mosi(thermocouple_driver_get(THERMOCOUPLE_MAX31856)));
+    CHECK_TRUE(thermocouple_driver_needs_mosi(thermocouple_driver_get(THERMOCOUPLE_MAX31856_VOLTAGE)));
+}
+
+TEST(ThermocoupleDriverTests, Max6675Readout) {
+    const uint8_t frame[] = { 0x0C, 0x80 };
+
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX6675, frame));
+    CHECK_EQUAL(400, reading.hot);
+    CHECK_FALSE(reading.has_cold_junction);
+}
+
+TEST(ThermocoupleDriverTests, Max6675OpenThermocouple) {
+    const uint8_t frame[] = { 0x00, 0x04 };
+
+    CHECK_FALSE(decode(THERMOCOUPLE_MAX6675, frame));
+    CHECK_EQUAL(THERMOCOUPLE_FAULT_OPEN, reading.faults);
+}
+
+TEST(ThermocoupleDriverTests, Max31855Readout) {
+    const uint8_t room[]     = { 0x01, 0x90, 0x19, 0x00 };
+    const uint8_t hot[]      = { 0x64, 0x00, 0x00, 0x00 };
+    const uint8_t cold[]     = { 0xF0, 0x60, 0x00, 0x00 };
+    const uint8_t negative[] = { 0xFF, 0xFC, 0xFF, 0xF0 };
+
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31855, room));
+    CHECK_EQUAL(100, reading.hot);
+    CHECK_EQUAL(100, reading.cold_junction);
+    CHECK_TRUE(reading.has_cold_junction);
+    CHECK_EQUAL(0, reading.voltage);
+    CHECK_TRUE(reading.has_voltage);
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31855, hot));
+    CHECK_EQUAL(6400, reading.hot);
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31855, cold));
+    CHECK_EQUAL(-1000, reading.hot);
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31855, negative));
+    CHECK_EQUAL(-1, reading.hot);
+    CHECK_EQUAL(-1, reading.cold_junction);
+}
+
+TEST(ThermocoupleDriverTests, Max31855OpenThermocouple) {
+    const uint8_t frame[] = { 0x00, 0x01, 0x00, 0x01 };
+
+    CHECK_FALSE(decode(THERMOCOUPLE_MAX31855, frame));
+    CHECK_TRUE(reading.faults & THERMOCOUPLE_FAULT_OPEN);
+}
+
+TEST(ThermocoupleDriverTests, Max31856Readout) {
+    const uint8_t room[] = { 0x19, 0x00, 0x06, 0x40, 0x00, 0x00 };
+    const uint8_t hot[]  = { 0x19, 0x00, 0x64, 0x00, 0x00, 0x00 };
+    const uint8_t open[] = { 0x19, 0x00, 0x06, 0x40, 0x00, 0x01 };
+
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31856, room));
+    CHECK_EQUAL(100, reading.cold_junction);
+    CHECK_EQUAL(400, reading.hot);
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31856, hot));
+    CHECK_EQUAL(6400, reading.hot);
+    CHECK_FALSE(decode(THERMOCOUPLE_MAX31856, open));
+    CHECK_TRUE(reading.faults & THERMOCOUPLE_FAULT_OPEN);
+}
+
+// 250 degC against a 25 degC cold junction at the fixed 41.276 uV/degC of the part
+TEST(ThermocoupleDriverTests, Max31855RecoversVoltage) {
+    const uint8_t frame[] = { 0x0F, 0xA0, 0x19, 0x00 };
+
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31855, frame));
+    CHECK_EQUAL(1000, reading.hot);
+    CHECK_EQUAL(9287, reading.voltage);
+}
+
+TEST(ThermocoupleDriverTests, Max31856VoltageModeReadout) {
+    const uint8_t frame[] = { 0x19, 0x00, 0x08, 0x51, 0x40, 0x00 };
+
+    CHECK_TRUE(decode(THERMOCOUPLE_MAX31856_VOLTAGE, frame));
+    CHECK_EQUAL(100, reading.cold_junction);
+    CHECK_TRUE(reading.has_voltage);
+    CHECK_EQUAL(10153, reading.voltage);
+}
@@ -16,7 +16,8 @@
 
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
-#include <atomic>
+
+#include "simulation.h"
 
 extern "C" {
 #include <stdio.h>
@@ -26,18 +27,18 @@ extern "C" {
 #include "utilities/timer.h"
 }
 
-static std::atomic<bool> is_test_finished(false);
+static constexpr miliseconds test_timeout_ms(1000);
 
 static inline void set_test_end(void) {
-    std::atomic_store_explicit(&is_test_finished, true, std::memory_order_relaxed);
+    simulation_signal_done();
 };
 
 static inline void set_test_start(void) {
-    std::atomic_store_explicit(&is_test_finished, false, std::memory_order_relaxed);
+    simulation_reset_done();
 };
 
-static inline bool get_test_status(void) {
-    return std::atomic_load_explicit(&is_test_finished, std::memory_order_relaxed);
+static inline bool wait_for_test_end(miliseconds timeout = test_timeout_ms) {
+    return simulation_wait_done(timeout);
 };
 
 TEST_GROUP(TimerTests) {
@@ -62,5 +63,31 @@ TEST(TimerTests, OneSecondTimerFireFiveTimes) {
 
     CHECK_EQUAL(ERROR_ANY, timer_register_callback(periodic_timer_ten_msec, timer_callback, NULL));
 
-    while (!get_test_status());
+    CHECK(wait_for_test_end());
+}
+
+static miliseconds first_tick_time = 0;
+static miliseconds last_tick_time  = 0;
+static unsigned long_run_counter   = 0;
+// One JEDEC profile run (230 s) worth of heat_controller_tick periods.
+constexpr unsigned long_run_ticks(230000 / 5000);
+
+TEST(TimerTests, FiveSecondTimerCoversJedecProfileInVirtualTime) {
+#if (configSIMULATION_VIRTUAL_TIME == 1)
+    periodic_timer_callback_t timer_callback = [](void*) {
+          last_tick_time = simulation_now();
+          if (long_run_counter++ == 0)
+              first_tick_time = last_tick_time;
+          if (long_run_counter == long_run_ticks)
+              set_test_end();
+      };
+
+    CHECK_EQUAL(ERROR_ANY, timer_register_callback(periodic_timer_five_sec, timer_callback, NULL));
+    CHECK(wait_for_test_end(2 * long_run_ticks * periodic_get_period(periodic_timer_five_sec)));
+    CHECK_EQUAL(ERROR_ANY, timer_unregister_callback(periodic_timer_five_sec, timer_callback));
+
+    CHECK_EQUAL((long_run_ticks - 1) * periodic_get_period(periodic_timer_five_sec), last_tick_time - first_tick_time);
+#else
+    TEST_IGNORE_MESSAGE("Requires configSIMULATION_VIRTUAL_TIME");
+#endif
 }
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "temperature.h"
+#include "thermocouple_type_k.h"
+}
+
+// NIST Monograph 175 type K reference function, E in mV
+static double reference_voltage(double t) {
+    static const double negative[] = {
+        0.0, 3.94501280250e-02, 2.36223735980e-05, -3.28589067840e-07, -4.99048287770e-09, -6.75090591730e-11,
+        -5.74103274280e-13, -3.10888728940e-15, -1.04516093650e-17, -1.98892668780e-20, -1.63226974860e-23,
+    };
+    static const double positive[] = {
+        -1.76004136860e-02, 3.89212049750e-02, 1.85587700320e-05, -9.94575928740e-08, 3.18409457190e-10,
+        -5.60728448890e-13, 5.60750590590e-16, -3.20207200030e-19, 9.71511471520e-23, -1.21047212750e-26,
+    };
+    const double* c = t < 0.0 ? negative : positive;
+    const int order = t < 0.0 ? 10 : 9;
+    double e = 0.0;
+
+    for (int i = order; i >= 0; i--)
+        e = e * t + c[i];
+    return t < 0.0 ? e : e + 1.185976e-01 * std::exp(-1.183432e-04 * (t - 1.269686e+02) * (t - 1.269686e+02));
+}
+
+static int32_t reference_microvolts(double t) {
+    return static_cast<int32_t>(std::lround(1000.0 * reference_voltage(t)));
+}
+
+TEST_GROUP(TypeKTests) {
+    void setup() {
+    }
+
+    void teardown() {
+    }
+};
+
+TEST(TypeKTests, MatchesNistTablePoints) {
+    CHECK_EQUAL(0, type_k_temperature_to_voltage(0));
+    CHECK_EQUAL(4096, type_k_temperature_to_voltage(temperature_from_celcius(100)));
+    CHECK_EQUAL(10153, type_k_temperature_to_voltage(temperature_from_celcius(250)));
+    CHECK_EQUAL(41276, type_k_temperature_to_voltage(temperature_from_celcius(1000)));
+    CHECK_EQUAL(temperature_from_celcius(100), type_k_voltage_to_temperature(4096));
+    CHECK_EQUAL(temperature_from_celcius(250), type_k_voltage_to_temperature(10153));
+    CHECK_EQUAL(temperature_from_celcius(1000), type_k_voltage_to_temperature(41276));
+}
+
+// Within one Q10.2 step of the reference over the whole span, every 0.25 degC
+TEST(TypeKTests, VoltageToTemperatureFollowsReference) {
+    for (int t = TYPE_K_MIN_TEMPERATURE; t <= TYPE_K_MAX_TEMPERATURE; t++) {
+        const double celsius = static_cast<double>(t) / TEMPERATURE_ONE;
+        const temperature_t converted = type_k_voltage_to_temperature(reference_microvolts(celsius));
+        CHECK_TRUE(std::abs(converted - t) <= 1);
+    }
+}
+
+// Within 2 uV, about 0.05 degC, of the reference
+TEST(TypeKTests, TemperatureToVoltageFollowsReference) {
+    for (int t = TYPE_K_MIN_TEMPERATURE; t <= TYPE_K_MAX_TEMPERATURE; t++) {
+        const double celsius = static_cast<double>(t) / TEMPERATURE_ONE;
+        CHECK_TRUE(std::abs(type_k_temperature_to_voltage(static_cast<temperature_t>(t))
+                            - reference_microvolts(celsius)) <= 2);
+    }
+}
+
+TEST(TypeKTests, ColdJunctionIsCompensated) {
+    // 250 degC hot junction against a 25 degC cold junction
+    const int32_t measured = reference_microvolts(250.0) - reference_microvolts(25.0);
+
+    CHECK_EQUAL(temperature_from_celcius(250), type_k_compensate(measured, temperature_from_celcius(25)));
+    CHECK_EQUAL(temperature_from_celcius(25), type_k_compensate(0, temperature_from_celcius(25)));
+}
+
+TEST(TypeKTests, SaturatesOutsideTheSpan) {
+    CHECK_EQUAL(TYPE_K_MIN_TEMPERATURE, type_k_voltage_to_temperature(-10000));
+    CHECK_EQUAL(TYPE_K_MAX_TEMPERATURE, type_k_voltage_to_temperature(60000));
+}
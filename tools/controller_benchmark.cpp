@@ -0,0 +1,216 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares PID, PID with setpoint feedforward and MPC from heater_calculator.c
+// on the nominal plant model: identifies the first order plus dead time model
+// the MPC and the feedforward run on, prints it in the heater_definitions.h
+// format and reports tracking quality and the per iteration cost of every
+// controller on every heating profile. Fails when either mode HEATER_CONTROL_MODE
+// selects, PID with the configured feedforward or MPC, misses the monte_carlo
+// acceptance criteria on the nominal plant. PID with the feedforward toggled
+// is listed for comparison only, the gains are swept for one setting.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "simulation/plant_spread.hpp"
+
+extern "C" {
+#include "heater_calculator.h"
+#include "heating_profile.h"
+#include "simulation/plant_model.h"
+}
+
+namespace {
+
+struct benchmark_options {
+    float               period             = 5.f;
+    float               step_percent       = 30.f;
+    seconds             step_duration      = 3600;
+    unsigned            horizon            = heater_calculator_mpc_parameters().horizon;
+    float               move_penalty       = heater_calculator_mpc_parameters().move_penalty;
+    float               lookahead          = heater_calculator_feedforward_parameters().lookahead;
+    bool                feedforward        = heater_calculator_feedforward_parameters().is_enabled;
+    unsigned            timing_repetitions = 2000;
+    celcius             const_temperature  = 200;
+    seconds             const_duration     = 600;
+    acceptance_criteria acceptance;
+};
+
+struct recording_controller {
+    heater_calculator_t calculator;
+    std::vector<float>  measurements;
+};
+
+float run_recording_controller(void* context, float measured, const heating_profile* profile, seconds time,
+  float period) {
+    auto* controller = static_cast<recording_controller*>(context);
+
+    controller->measurements.push_back(measured);
+    return heater_calculator_iterate(&controller->calculator, measured, profile, time, period);
+}
+
+// Replays the recorded sensor trace, so both controllers take the same branches
+// they took in closed loop while the timer only sees the controller itself.
+double nanoseconds_per_iteration(const benchmark_options& options, const heater_calculator_t& initial,
+  const heating_profile& profile, const std::vector<float>& measurements) {
+    volatile float sink = 0.f;
+    auto started = std::chrono::steady_clock::now();
+
+    for (unsigned repetition = 0; repetition < options.timing_repetitions; repetition++) {
+        heater_calculator_t calculator = initial;
+        seconds time = 0;
+        for (float measured : measurements) {
+            sink  = heater_calculator_iterate(&calculator, measured, &profile, time, options.period);
+            time += static_cast<seconds>(options.period);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    (void) sink;
+    return elapsed.count() / static_cast<double>(options.timing_repetitions * measurements.size());
+}
+
+// Returns whether the run met the acceptance criteria, always for runs that aren't gated
+bool run_benchmark(const benchmark_options& options, const plant_parameters& parameters, const char* name,
+  const heating_profile& profile, const heater_calculator_t& initial, bool is_gated) {
+    recording_controller controller = { initial, {} };
+    plant_model plant;
+
+    plant_init(&plant, &parameters, 1);
+    plant_run_result result = plant_run_profile(&plant, &profile, options.period, options.acceptance.liquidus,
+        run_recording_controller, &controller);
+    const bool is_accepted = !options.acceptance.is_failure(profile, result);
+    const char* verdict    = is_gated ? (is_accepted ? "pass" : "FAIL") : (is_accepted ? "(pass)" : "(fail)");
+
+    std::printf("  %-6s %12.0f %10.1f %8.1f %10.1f %10.1f %10.1f %8s\n", name, result.ise, result.overshoot,
+      result.peak, result.time_above_liquidus, result.final_error,
+      nanoseconds_per_iteration(options, initial, profile, controller.measurements), verdict);
+    return is_accepted || !is_gated;
+}
+
+bool parse_window(const char* text, acceptance_window& window) {
+    return 2 == std::sscanf(text, "%f:%f", &window.min, &window.max) && window.min <= window.max;
+}
+
+void print_usage(const char* name) {
+    std::printf("usage: %s [options]\n"
+      "  --period s               control window length\n"
+      "  --liquidus degC          solder liquidus used for time above liquidus\n"
+      "  --peak min:max           accepted reflow peak temperature\n"
+      "  --tal min:max            accepted reflow time above liquidus\n"
+      "  --step percent:seconds   duty and length of the identification step\n"
+      "  --horizon n              MPC prediction horizon in control windows\n"
+      "  --move-penalty w         MPC weight of power changes\n"
+      "  --lookahead s            PID feedforward setpoint lookahead\n"
+      "  --feedforward on|off     PID feedforward, defaults to heater_definitions.h\n"
+      "  --constant temp:seconds  setpoint used for the constant heating profile\n", name);
+}
+
+bool parse_options(int ac, char** av, benchmark_options& options) {
+    for (int i = 1; i < ac; i++) {
+        const char* value = i + 1 < ac ? av[i + 1] : nullptr;
+        bool ok = value != nullptr;
+
+        if (!std::strcmp(av[i], "--period") && ok)
+            options.period = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--liquidus") && ok)
+            options.acceptance.liquidus = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--peak") && ok)
+            ok = parse_window(value, options.acceptance.reflow_peak);
+        else if (!std::strcmp(av[i], "--tal") && ok)
+            ok = parse_window(value, options.acceptance.reflow_tal);
+        else if (!std::strcmp(av[i], "--step") && ok)
+            ok = 2 == std::sscanf(value, "%f:%u", &options.step_percent, &options.step_duration);
+        else if (!std::strcmp(av[i], "--horizon") && ok)
+            options.horizon = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--move-penalty") && ok)
+            options.move_penalty = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--lookahead") && ok)
+            options.lookahead = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--feedforward") && ok) {
+            options.feedforward = !std::strcmp(value, "on");
+            ok = options.feedforward || !std::strcmp(value, "off");
+        }
+        else if (!std::strcmp(av[i], "--constant") && ok)
+            ok = 2 == std::sscanf(value, "%u:%u", &options.const_temperature, &options.const_duration);
+        else
+            return false;
+
+        if (!ok)
+            return false;
+        i++;
+    }
+    return options.period > 0.f && options.step_percent > 0.f && options.horizon > 0
+           && options.horizon <= MPC_MAX_HORIZON;
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    benchmark_options options;
+
+    if (!parse_options(ac, av, options)) {
+        print_usage(av[0]);
+        return EXIT_FAILURE;
+    }
+
+    plant_parameters parameters;
+    plant_default_parameters(&parameters);
+
+    mpc_params_t mpc = {
+        plant_identify_fopdt(&parameters, options.step_percent, options.period, options.step_duration),
+        options.horizon,
+        options.move_penalty,
+    };
+    std::printf("#define HEATER_MODEL_GAIN          %.4ff\n#define HEATER_MODEL_TIME_CONSTANT %.1ff\n"
+      "#define HEATER_MODEL_DEAD_TIME     %.1ff\n#define HEATER_MODEL_AMBIENT       %.1ff\n"
+      "#define HEATER_MPC_HORIZON         %uU\n#define HEATER_MPC_MOVE_PENALTY    %.2ff\n\n", mpc.model.gain,
+      mpc.model.time_constant, mpc.model.dead_time, mpc.model.ambient, mpc.horizon, mpc.move_penalty);
+
+    // In heating_profile_id order, the C designators aren't C++
+    static_assert(HEATING_PROFILE_CONSTANT == 0 && HEATING_PROFILE_JEDEC == 1 && HEATING_PROFILE_LAST == 2,
+      "profile tables below follow heating_profile_id");
+    temperature_stage constant_stage;
+    const heating_profile profiles[HEATING_PROFILE_LAST] = {
+        heating_profile_constant(&constant_stage, options.const_temperature, options.const_duration),
+        *heating_profile_get(HEATING_PROFILE_JEDEC),
+    };
+    const char* profile_names[HEATING_PROFILE_LAST] = { "constant", "jedec" };
+    bool is_signed_off = true;
+
+    for (unsigned profile = 0; profile < HEATING_PROFILE_LAST; profile++) {
+        heater_calculator_t pid, pid_toggled, model_predictive;
+
+        heater_calculator_reset(&pid, heater_calculator_gains(static_cast<heating_profile_id>(profile)));
+        pid_toggled = pid;
+        heater_calculator_set_feedforward(&pid, { options.feedforward, mpc.model, options.lookahead });
+        heater_calculator_set_feedforward(&pid_toggled, { !options.feedforward, mpc.model, options.lookahead });
+        heater_calculator_reset_mpc(&model_predictive, mpc);
+
+        std::printf("%s:\n  %-6s %12s %10s %8s %10s %10s %10s %8s\n", profile_names[profile], "", "ISE [K2s]",
+          "over [K]", "peak", "TAL [s]", "final [K]", "ns/iter", "accepted");
+        is_signed_off &= run_benchmark(options, parameters, options.feedforward ? "pid+ff" : "pid", profiles[profile],
+          pid, true);
+        run_benchmark(options, parameters, options.feedforward ? "pid" : "pid+ff", profiles[profile], pid_toggled,
+          false);
+        is_signed_off &= run_benchmark(options, parameters, "mpc", profiles[profile], model_predictive, true);
+    }
+
+    return is_signed_off ? EXIT_SUCCESS : EXIT_FAILURE;
+}
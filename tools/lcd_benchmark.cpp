@@ -0,0 +1,486 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs screen updates through the HD44780 step queue of lcd1602.c against a
+// counting pin interface. Reports, per update, how long the queueing side
+// (the scheduler task on the device) is busy, how long the bus is busy
+// executing the steps (the LCD task) and, for comparison, how long the
+// scheduler task was blocked when every nibble waited 20 + 50 us and clear
+// slept 5 ms inline. Then replays a menu session, every screen drawn as a
+// clear plus its strings and through the lcd_framebuffer.c diff, and compares
+// the bus transfers and bus time of both. Finally writes characters through the
+// per pin interface and through the bus_write hook and compares the interface
+// calls and step execution cycles per character, and does the same over a mock
+// I2C bus to a PCF8574 backpack, one transaction per pin change against the
+// batched port writes. Last, replays the menu session through the HD44780
+// model of tools/simulation over every transport and reports the bus
+// operations, blocking time and timing violations per screen, and animates a
+// temperature sparkline and progress bar with the lcd_glyphs.c CGRAM cache
+// against uploading every glyph of every frame, in CGRAM writes per frame.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+extern "C" {
+#include "lcd1602/lcd1602.h"
+#include "lcd_framebuffer.h"
+#include "lcd_glyphs.h"
+#include "lcd_definitions.h"
+#include "simulation/hd44780_model.h"
+}
+
+namespace {
+
+struct benchmark_options {
+    unsigned updates = 1000;
+    bool     clear   = true;
+};
+
+struct bus_counters {
+    unsigned long pin_writes;
+    unsigned long bus_writes;
+    unsigned long waits;
+    unsigned long waited;
+};
+
+bus_counters bus;
+
+bool count_pin_set(pin_t pin, bool state) {
+    bus.pin_writes++;
+    return true;
+}
+
+bool count_bus_write(uint8_t nibble, bool rs) {
+    bus.bus_writes++;
+    return true;
+}
+
+void count_wait(unsigned microseconds) {
+    bus.waits++;
+    bus.waited += microseconds;
+}
+
+uint64_t timestamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Line contents of a typical menu screen
+const char* const lines[] = { "Reflow 183/245C", "Preheat  02:31" };
+
+struct update_result {
+    double        queueing;       // us per update on the queueing side
+    double        bus_time;       // us per update the controller needs
+    unsigned long steps;
+    unsigned long pin_writes;
+    unsigned long legacy_blocked; // us per update under the inline waits
+};
+
+update_result run_benchmark(const benchmark_options& options) {
+    std::chrono::steady_clock::duration queueing{};
+    unsigned long steps = 0, bus_time = 0;
+
+    for (unsigned update = 0; update < options.updates; update++) {
+        auto started = std::chrono::steady_clock::now();
+        if (options.clear)
+            lcd16x2_clear();
+        for (unsigned line = 0; line < 2; line++) {
+            lcd16x2_setCursor(line, 0);
+            lcd16x2_printf("%s", lines[line]);
+        }
+        queueing += std::chrono::steady_clock::now() - started;
+
+        for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); steps++)
+            bus_time += execution_time;
+    }
+    bus_time += bus.waited;
+
+    const unsigned long bytes_per_update = steps / options.updates;
+    return {
+        std::chrono::duration<double, std::micro>(queueing).count() / options.updates,
+        static_cast<double>(bus_time) / options.updates,
+        bytes_per_update,
+        bus.pin_writes / options.updates,
+        bytes_per_update * 2 * (20 + 50) + (options.clear ? 5000 : 0),
+    };
+}
+
+struct text {
+    unsigned    row;
+    unsigned    column;
+    std::string value;
+};
+
+struct screen {
+    const char*       kind;
+    std::vector<text> texts;
+};
+
+// Screens of menu.c in the order a user setting up a constant heating sees them
+std::vector<screen> menu_session(void) {
+    std::vector<screen> session = {
+        { "navigation", { { 0, 3, "ThermoPlate" } } },
+        { "navigation", { { 0, 0, "Constant" }, { 1, 0, "temperature" } } },
+        { "navigation", { { 0, 0, "JEDEC" } } },
+        { "navigation", { { 0, 0, "Constant" }, { 1, 0, "temperature" } } },
+    };
+    // Every encoder step redraws the value, entering the setting is a navigation
+    for (unsigned temperature = 180; temperature <= 240; temperature++)
+        session.push_back({ temperature == 180 ? "navigation" : "value edit", { { 0, 0, "Set" },
+                            { 1, 0, "temperature:" }, { 1, 13, std::to_string(temperature) } } });
+    for (unsigned time = 60; time <= 120; time++)
+        session.push_back({ time == 60 ? "navigation" : "value edit", { { 0, 0, "Set" }, { 1, 0, "time:" },
+                            { 1, 6, std::to_string(time) } } });
+    session.push_back({ "navigation", { { 0, 0, "Running..." } } });
+    session.push_back({ "navigation", { { 0, 0, "Done" } } });
+    return session;
+}
+
+struct bus_load {
+    unsigned long transfers;
+    unsigned long time;
+};
+
+bus_load run_steps(void) {
+    bus_load load = {};
+    unsigned long waited = bus.waited;
+
+    for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); load.transfers++)
+        load.time += execution_time;
+    load.time += bus.waited - waited;
+    return load;
+}
+
+bool set_cursor(uint8_t row, uint8_t column) {
+    return lcd16x2_setCursor(row, column);
+}
+
+void run_menu_session(void) {
+    const lcd_framebuffer_output_t output = {
+        set_cursor, lcd16x2_putChar, lcd16x2_clear, LCD_CLEAR_COST
+    };
+    lcd_framebuffer_t shadow, displayed;
+    struct totals {
+        const char* kind;
+        unsigned    screens;
+        bus_load    redraw;
+        bus_load    diff;
+    } totals[] = { { "navigation" }, { "value edit" } };
+
+    lcd_framebuffer_clear(&shadow);
+    lcd_framebuffer_clear(&displayed);
+    for (const screen& screen : menu_session()) {
+        lcd16x2_clear();
+        lcd_framebuffer_clear(&shadow);
+        for (const text& text : screen.texts) {
+            lcd16x2_setCursor(text.row, text.column);
+            lcd16x2_printf("%s", text.value.c_str());
+            lcd_framebuffer_write(&shadow, text.row, text.column,
+              reinterpret_cast<const uint8_t*>(text.value.data()), text.value.size());
+        }
+        bus_load redraw = run_steps();
+        lcd_framebuffer_flush(&displayed, &shadow, &output);
+        bus_load diff = run_steps();
+
+        for (auto& total : totals) {
+            if (std::strcmp(total.kind, screen.kind))
+                continue;
+            total.screens++;
+            total.redraw.transfers += redraw.transfers;
+            total.redraw.time      += redraw.time;
+            total.diff.transfers   += diff.transfers;
+            total.diff.time        += diff.time;
+        }
+    }
+
+    // A one digit edit can't go below a cursor move and a write, so the value
+    // edit ratio stays under 10x while a redraw takes fewer than 20 operations
+    std::printf("menu session, per screen, clear weighed as %u transfers\n"
+      "  %-12s %8s %12s %12s %12s %12s %10s %10s %8s\n", LCD_CLEAR_COST, "", "screens", "redraw ops", "diff ops",
+      "redraw us", "diff us", "ops ratio", "us ratio", "ops 10x");
+    for (const auto& total : totals) {
+        const double ops_ratio =
+          static_cast<double>(total.redraw.transfers) / static_cast<double>(total.diff.transfers);
+        std::printf("  %-12s %8u %12.1f %12.1f %12.0f %12.0f %10.1f %10.1f %8s\n", total.kind, total.screens,
+          static_cast<double>(total.redraw.transfers) / total.screens,
+          static_cast<double>(total.diff.transfers) / total.screens,
+          static_cast<double>(total.redraw.time) / total.screens,
+          static_cast<double>(total.diff.time) / total.screens,
+          ops_ratio,
+          static_cast<double>(total.redraw.time) / static_cast<double>(total.diff.time),
+          ops_ratio > 10.0 ? "met" : "missed");
+    }
+}
+
+// PCF8574 backpack behind a 100 kHz I2C bus, pin_set rewrites the whole port
+struct i2c_counters {
+    unsigned long transactions;
+    unsigned long bytes;
+    uint8_t       port;
+};
+
+i2c_counters i2c;
+
+bool i2c_port_write(const uint8_t* states, unsigned count) {
+    i2c.transactions++;
+    i2c.bytes += count;
+    return true;
+}
+
+bool i2c_pin_set(pin_t pin, bool state) {
+    i2c.port = state ? i2c.port | 1 << pin : i2c.port & ~(1 << pin);
+    return i2c_port_write(&i2c.port, 1);
+}
+
+struct character_result {
+    double calls;  // pin_set and bus_write calls per character
+    double waits;  // wait calls per character, the enable pulse
+    double cycles; // lcd16x2_runStep() cycles per character
+};
+
+character_result run_characters(lcd1602_bus_write bus_write, unsigned characters) {
+    uint64_t cycles = 0;
+
+    lcd16x2_init_4bits({ { 1, 4, 9, 6, 3, 2 }, count_pin_set, count_wait, bus_write });
+    while (LCD1602_IDLE != lcd16x2_runStep())
+        ;
+    bus = {};
+
+    for (unsigned written = 0; written < characters; ) {
+        for (; written < characters && lcd16x2_putChar('0' + written % 10); written++)
+            ;
+        uint64_t started = timestamp();
+        while (LCD1602_IDLE != lcd16x2_runStep())
+            ;
+        cycles += timestamp() - started;
+    }
+    return {
+        static_cast<double>(bus.pin_writes + bus.bus_writes) / characters,
+        static_cast<double>(bus.waits) / characters,
+        static_cast<double>(cycles) / characters,
+    };
+}
+
+// Start, address, stop and nine clocks per byte
+double i2c_wire_time(unsigned long transactions, unsigned long bytes) {
+    return (transactions * (1 + 9 + 1) + 9.0 * bytes) * 1e6 / 100000;
+}
+
+void run_i2c_comparison(unsigned characters) {
+    const struct {
+        const char*  name;
+        lcd1602_port port;
+    } interfaces[] = {
+        { "pin by pin", {} },
+        { "port", { i2c_port_write, 1 << 3, 90 } },
+    };
+
+    std::printf("%u characters over a PCF8574, per character\n  %-12s %12s %10s %10s\n", characters, "",
+      "transactions", "bytes", "wire us");
+    for (const auto& interface : interfaces) {
+        lcd16x2_init_4bits({ { 0, 2, 4, 5, 6, 7 }, i2c_pin_set, count_wait, nullptr, interface.port });
+        while (LCD1602_IDLE != lcd16x2_runStep())
+            ;
+        i2c = {};
+        for (unsigned written = 0; written < characters; ) {
+            for (; written < characters && lcd16x2_putChar('0' + written % 10); written++)
+                ;
+            while (LCD1602_IDLE != lcd16x2_runStep())
+                ;
+        }
+        std::printf("  %-12s %12.2f %10.2f %10.1f\n", interface.name,
+          static_cast<double>(i2c.transactions) / characters, static_cast<double>(i2c.bytes) / characters,
+          i2c_wire_time(i2c.transactions, i2c.bytes) / characters);
+    }
+}
+
+void run_bus_comparison(unsigned characters) {
+    const struct {
+        const char*       name;
+        lcd1602_bus_write bus_write;
+    } interfaces[] = { { "pin by pin", nullptr }, { "bus_write", count_bus_write } };
+
+    std::printf("%u characters, per character\n  %-12s %10s %10s %10s\n", characters, "", "bus calls",
+      "waits", "cycles");
+    for (const auto& interface : interfaces) {
+        character_result result = run_characters(interface.bus_write, characters);
+        std::printf("  %-12s %10.1f %10.1f %10.1f\n", interface.name, result.calls, result.waits, result.cycles);
+    }
+}
+
+void run_model_session(void) {
+    const lcd_framebuffer_output_t output = {
+        set_cursor, lcd16x2_putChar, lcd16x2_clear, LCD_CLEAR_COST
+    };
+    const pinset gpio = { 1, 4, 9, 6, 3, 2 }, port = { 0, 2, 4, 5, 6, 7 };
+    const struct {
+        const char*        name;
+        lcd1602_interface  iface;
+        hd44780_model_config config;
+    } transports[] = {
+        { "pin by pin", { gpio, hd44780_model_pin_set, hd44780_model_wait }, { gpio, 100, 0 } },
+        { "bus_write", { gpio, hd44780_model_pin_set, hd44780_model_wait, hd44780_model_bus_write },
+          { gpio, 100, 0 } },
+        { "pcf8574", { port, nullptr, nullptr, nullptr, { hd44780_model_port_write, 1 << 3, 90 } },
+          { port, 0, 90000 } },
+    };
+    const std::vector<screen> session = menu_session();
+
+    std::printf("menu session through the HD44780 model, per screen\n  %-12s %10s %12s %12s %10s\n", "",
+      "bus ops", "blocked us", "elapsed us", "violations");
+    for (const auto& transport : transports) {
+        hd44780_model model;
+        lcd_framebuffer_t shadow, displayed;
+
+        hd44780_model_init(&model, &transport.config);
+        hd44780_model_attach(&model);
+        lcd16x2_init_4bits(transport.iface);
+        for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); )
+            hd44780_model_wait(execution_time);
+        hd44780_model_reset_counters(&model);
+        int64_t started = model.now;
+
+        lcd_framebuffer_clear(&displayed);
+        for (const screen& screen : session) {
+            lcd_framebuffer_clear(&shadow);
+            for (const text& text : screen.texts)
+                lcd_framebuffer_write(&shadow, text.row, text.column,
+                  reinterpret_cast<const uint8_t*>(text.value.data()), text.value.size());
+            lcd_framebuffer_flush(&displayed, &shadow, &output);
+            for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); )
+                hd44780_model_wait(execution_time);
+        }
+        std::printf("  %-12s %10.1f %12.1f %12.1f %10lu\n", transport.name,
+          static_cast<double>(model.counters.operations) / session.size(),
+          model.counters.blocked / 1e3 / session.size(), (model.now - started) / 1e3 / session.size(),
+          hd44780_model_violations(&model));
+    }
+}
+
+// Heating screen: temperature, a sparkline of the last readings and the
+// progress of the run
+void heating_frame(lcd_framebuffer_t* screen, unsigned frame, unsigned frames) {
+    const unsigned history = 9;
+    auto temperature = [frames](unsigned at) { return 25 + 220 * at / frames; };
+
+    lcd_framebuffer_clear(screen);
+    lcd_framebuffer_print(screen, 0, 0, "%3uC", temperature(frame));
+    for (unsigned i = 0; i < history; i++) {
+        unsigned at = frame + i >= history ? frame + i - history + 1 : 0;
+        screen->cells[0][LCD_FRAMEBUFFER_COLUMNS - history + i] =
+          lcd_glyph_level(temperature(at) * (LCD_GLYPH_LEVEL_STEPS + 1) / 250);
+    }
+    lcd_glyph_bar(screen->cells[1], LCD_FRAMEBUFFER_COLUMNS, 1000 * frame / frames);
+}
+
+void run_glyph_session(unsigned frames) {
+    const lcd_framebuffer_output_t output = {
+        set_cursor, lcd16x2_putChar, lcd16x2_clear, LCD_CLEAR_COST
+    };
+    const pinset gpio = { 1, 4, 9, 6, 3, 2 };
+    const hd44780_model_config config = { gpio, 100, 0 };
+
+    std::printf("%u heating frames through the HD44780 model, per frame\n  %-12s %10s %10s %10s\n", frames, "",
+      "cgram", "transfers", "violations");
+    for (bool cached : { false, true }) {
+        hd44780_model model;
+        lcd_glyph_cache_t cache;
+        lcd_framebuffer_t screen, displayed;
+
+        hd44780_model_init(&model, &config);
+        hd44780_model_attach(&model);
+        lcd16x2_init_4bits({ gpio, hd44780_model_pin_set, hd44780_model_wait, hd44780_model_bus_write });
+        for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); )
+            hd44780_model_wait(execution_time);
+        hd44780_model_reset_counters(&model);
+        lcd_glyph_cache_init(&cache);
+        lcd_framebuffer_clear(&displayed);
+
+        for (unsigned frame = 0; frame < frames; frame++) {
+            heating_frame(&screen, frame, frames);
+            if (!cached)
+                lcd_glyph_cache_init(&cache);
+            lcd_glyph_resolve(&cache, &screen, &displayed, lcd16x2_createChar);
+            lcd_framebuffer_flush(&displayed, &screen, &output);
+            for (uint32_t execution_time; LCD1602_IDLE != (execution_time = lcd16x2_runStep()); )
+                hd44780_model_wait(execution_time);
+        }
+        std::printf("  %-12s %10.2f %10.2f %10lu\n", cached ? "lru cache" : "every frame",
+          static_cast<double>(model.counters.cgram_writes) / frames,
+          static_cast<double>(model.counters.instructions) / frames, hd44780_model_violations(&model));
+    }
+}
+
+void print_usage(const char* name) {
+    std::printf("usage: %s [options]\n"
+      "  --updates n              screen updates to run\n"
+      "  --no-clear               rewrite the lines without clearing first\n", name);
+}
+
+bool parse_options(int ac, char** av, benchmark_options& options) {
+    for (int i = 1; i < ac; i++) {
+        if (!std::strcmp(av[i], "--updates") && i + 1 < ac)
+            options.updates = static_cast<unsigned>(std::strtoul(av[++i], nullptr, 10));
+        else if (!std::strcmp(av[i], "--no-clear"))
+            options.clear = false;
+        else
+            return false;
+    }
+    return options.updates > 0;
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    benchmark_options options;
+
+    if (!parse_options(ac, av, options)) {
+        print_usage(av[0]);
+        return EXIT_FAILURE;
+    }
+
+    lcd16x2_init_4bits({ { 1, 4, 9, 6, 3, 2 }, count_pin_set, count_wait });
+    while (LCD1602_IDLE != lcd16x2_runStep())
+        ;
+    bus = {};
+
+    update_result result = run_benchmark(options);
+    std::printf("%u updates, %lu bus transfers and %lu pin writes each%s\n"
+      "  scheduler task blocked, inline waits  %10.2f us\n"
+      "  scheduler task busy, step queue       %10.2f us\n"
+      "  bus busy in the LCD task              %10.0f us\n",
+      options.updates, result.steps, result.pin_writes, options.clear ? " with clear" : "",
+      static_cast<double>(result.legacy_blocked), result.queueing, result.bus_time);
+    run_menu_session();
+    run_bus_comparison(options.updates * LCD_FRAMEBUFFER_ROWS * LCD_FRAMEBUFFER_COLUMNS);
+    run_i2c_comparison(options.updates * LCD_FRAMEBUFFER_ROWS * LCD_FRAMEBUFFER_COLUMNS);
+    run_model_session();
+    run_glyph_session(std::max(options.updates, 100U));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Monte Carlo robustness check: runs every heating profile with the gains from
+// pid_gains.scf against thousands of randomized plant models and reports the
+// spread of peak temperature, time above liquidus and the failure rate.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "simulation/plant_spread.hpp"
+#include "simulation/thread_pool.hpp"
+
+extern "C" {
+#include "heater_calculator.h"
+#include "heating_profile.h"
+#include "simulation/plant_model.h"
+}
+
+namespace {
+
+struct monte_carlo_options {
+    unsigned            samples           = 4096;
+    unsigned            threads           = 0;
+    unsigned            seed              = 2024;
+    float               period            = 5.f;
+    acceptance_criteria acceptance;
+    celcius             const_temperature = 200;
+    seconds             const_duration    = 600;
+    float               max_failure_rate  = 1.f;
+};
+
+float run_controller(void* context, float measured, const heating_profile* profile, seconds time, float period) {
+    return heater_calculator_iterate(static_cast<heater_calculator_t*>(context), measured, profile, time, period);
+}
+
+float percentile(std::vector<float>& values, float fraction) {
+    std::size_t index = static_cast<std::size_t>(fraction * static_cast<float>(values.size() - 1) + 0.5f);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void print_distribution(const char* name, std::vector<float> values) {
+    double sum = 0.;
+    for (float value : values)
+        sum += value;
+
+    std::printf("  %-22s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, percentile(values, 0.f),
+      percentile(values, 0.05f), percentile(values, 0.5f), percentile(values, 0.95f), percentile(values, 1.f),
+      sum / static_cast<double>(values.size()));
+}
+
+bool parse_window(const char* text, acceptance_window& window) {
+    return 2 == std::sscanf(text, "%f:%f", &window.min, &window.max) && window.min <= window.max;
+}
+
+void print_usage(const char* name) {
+    std::printf("usage: %s [options]\n"
+      "  --samples n              randomized plants per profile\n"
+      "  --seed n                 base seed, results are reproducible for a given seed\n"
+      "  --threads n              worker count, defaults to all cores\n"
+      "  --liquidus degC          solder liquidus used for time above liquidus\n"
+      "  --peak min:max           accepted reflow peak temperature\n"
+      "  --tal min:max            accepted reflow time above liquidus\n"
+      "  --constant temp:seconds  setpoint used for the constant heating profile\n"
+      "  --max-failure-rate r     exit with failure when any profile fails more often\n", name);
+}
+
+bool parse_options(int ac, char** av, monte_carlo_options& options) {
+    for (int i = 1; i < ac; i++) {
+        const char* value = i + 1 < ac ? av[i + 1] : nullptr;
+        bool ok = value != nullptr;
+
+        if (!std::strcmp(av[i], "--samples") && ok)
+            options.samples = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--seed") && ok)
+            options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--threads") && ok)
+            options.threads = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--liquidus") && ok)
+            options.acceptance.liquidus = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--peak") && ok)
+            ok = parse_window(value, options.acceptance.reflow_peak);
+        else if (!std::strcmp(av[i], "--tal") && ok)
+            ok = parse_window(value, options.acceptance.reflow_tal);
+        else if (!std::strcmp(av[i], "--constant") && ok)
+            ok = 2 == std::sscanf(value, "%u:%u", &options.const_temperature, &options.const_duration);
+        else if (!std::strcmp(av[i], "--max-failure-rate") && ok)
+            options.max_failure_rate = std::strtof(value, nullptr);
+        else
+            return false;
+
+        if (!ok)
+            return false;
+        i++;
+    }
+    return options.samples > 0;
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    monte_carlo_options options;
+
+    if (!parse_options(ac, av, options)) {
+        print_usage(av[0]);
+        return EXIT_FAILURE;
+    }
+
+    plant_parameters nominal;
+    plant_default_parameters(&nominal);
+
+    // In heating_profile_id order, the C designators aren't C++
+    static_assert(HEATING_PROFILE_CONSTANT == 0 && HEATING_PROFILE_JEDEC == 1 && HEATING_PROFILE_LAST == 2,
+      "profile tables below follow heating_profile_id");
+    temperature_stage constant_stage;
+    const heating_profile profiles[HEATING_PROFILE_LAST] = {
+        heating_profile_constant(&constant_stage, options.const_temperature, options.const_duration),
+        *heating_profile_get(HEATING_PROFILE_JEDEC),
+    };
+    const char* profile_names[HEATING_PROFILE_LAST] = { "constant", "jedec" };
+
+    work_stealing_pool pool(options.threads ? options.threads : std::thread::hardware_concurrency());
+    std::vector<plant_run_result> results(options.samples);
+    bool is_signed_off = true;
+
+    for (unsigned profile = 0; profile < HEATING_PROFILE_LAST; profile++) {
+        auto started = std::chrono::steady_clock::now();
+        pool.run(options.samples, [&](std::size_t sample) {
+            std::mt19937 generator = plant_sample_generator(options.seed, static_cast<unsigned>(sample), profile);
+            plant_parameters parameters = randomize_plant(nominal, generator);
+            plant_model plant;
+            heater_calculator_t calculator;
+
+            plant_init(&plant, &parameters, generator());
+            heater_calculator_reset(&calculator, heater_calculator_gains(static_cast<heating_profile_id>(profile)));
+            heater_calculator_set_feedforward(&calculator, heater_calculator_feedforward_parameters());
+            results[sample] = plant_run_profile(&plant, &profiles[profile], options.period, options.acceptance.liquidus,
+                run_controller, &calculator);
+        });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+        std::vector<float> peaks, tals, overshoots;
+        unsigned failures = 0;
+        for (const plant_run_result& result : results) {
+            peaks.push_back(result.peak);
+            tals.push_back(result.time_above_liquidus);
+            overshoots.push_back(result.overshoot);
+            failures += options.acceptance.is_failure(profiles[profile], result) ? 1 : 0;
+        }
+        float failure_rate = static_cast<float>(failures) / static_cast<float>(options.samples);
+        is_signed_off &= failure_rate <= options.max_failure_rate;
+
+        std::printf("%s: %u plants in %.3f s\n  %-22s %8s %8s %8s %8s %8s %8s\n", profile_names[profile],
+          options.samples, elapsed.count(), "", "min", "p5", "p50", "p95", "max", "mean");
+        print_distribution("peak [degC]", peaks);
+        print_distribution("above liquidus [s]", tals);
+        print_distribution("overshoot [K]", overshoots);
+        std::printf("  failure rate: %.2f%% (%u/%u)\n", 100.f * failure_rate, failures, options.samples);
+    }
+
+    return is_signed_off ? EXIT_SUCCESS : EXIT_FAILURE;
+}
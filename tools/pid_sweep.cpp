@@ -0,0 +1,391 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host gain sweep: simulates a grid of pid_params_t candidates against every
+// heating profile on the nominal plant model and a sample of the randomized
+// plants monte_carlo signs off on, ranks them by how many of those runs miss
+// its acceptance criteria, then by tracking cost on the nominal plant, and
+// writes the winners in the pid_gains.scf format used by heater_calculator.c.
+// Candidates run with the feedforward and integral hold of heater_definitions.h,
+// the configuration the gains ship with.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "simulation/plant_spread.hpp"
+#include "simulation/thread_pool.hpp"
+
+extern "C" {
+#include "heater_calculator.h"
+#include "heating_profile.h"
+#include "pid.h"
+#include "simulation/plant_model.h"
+}
+
+namespace {
+
+constexpr std::size_t batch_lanes = 64;
+
+struct gain_range {
+    float    min;
+    float    max;
+    unsigned count;
+
+    // Geometric from a positive min, kp matters over orders of magnitude, linear from 0
+    float at(unsigned i) const {
+        const float fraction = count > 1 ? static_cast<float>(i) / static_cast<float>(count - 1) : 0.f;
+        return min > 0.f ? min * std::pow(max / min, fraction) : min + (max - min) * fraction;
+    }
+};
+
+struct sweep_options {
+    gain_range  kp               = { 0.02f, 15.f, 32 };
+    gain_range  ki               = { 0.f, 0.1f, 21 };
+    gain_range  kd               = { 0.f, 30.f, 7 };
+    celcius     const_temperature = 200;
+    seconds     const_duration    = 600;
+    float       overshoot_weight  = 10.f;
+    float       period            = 5.f;
+    unsigned    plants            = 256;
+    unsigned    seed              = 7;
+    unsigned    threads           = 0;
+    unsigned    top               = 5;
+    const char* output            = nullptr;
+    acceptance_criteria acceptance;
+};
+
+// Nominal plant first, then the randomized ones with their noise seeds
+struct sweep_plant {
+    plant_parameters parameters;
+    uint32_t         seed;
+};
+
+struct candidate_score {
+    std::size_t candidate;
+    unsigned    failures; // runs over all plants missing the acceptance criteria
+    float       cost;     // on the nominal plant
+    float       overshoot;
+};
+
+// Structure of arrays holding one batch of candidates, laid out so that every
+// per-lane loop below maps onto vector registers.
+struct alignas(64) sweep_batch {
+    float kp[batch_lanes];
+    float ki[batch_lanes];
+    float kd[batch_lanes];
+    float integral[batch_lanes];
+    float previous_error[batch_lanes];
+    float on_steps[batch_lanes];
+    float plate[batch_lanes];
+    float junction[batch_lanes];
+    float ise[batch_lanes];
+    float peak[batch_lanes];
+    float above_liquidus[batch_lanes];
+    float final_error[batch_lanes];
+    float delay_line[PLANT_MAX_DEAD_TIME_STEPS][batch_lanes];
+};
+
+float cost_of(const sweep_options& options, float ise, float overshoot, seconds duration) {
+    return ise / static_cast<float>(duration) + options.overshoot_weight * overshoot * overshoot;
+}
+
+celcius highest_setpoint(const heating_profile& profile) {
+    celcius highest = 0;
+
+    for (unsigned i = 0; i < profile.stage_count; i++)
+        highest = std::max(highest, profile.stages[i].temperature);
+    return highest;
+}
+
+bool is_better(const candidate_score& a, const candidate_score& b) {
+    return a.failures != b.failures ? a.failures < b.failures : a.cost < b.cost;
+}
+
+// Mirrors plant_run_profile() driven by heater_calculator_iterate(), for
+// batch_lanes candidates at once. The readout noise draw is the same for every
+// lane, so it follows the scalar path given the seed plant_init() would get.
+void simulate_batch(const sweep_options& options, const sweep_plant& sample, const heating_profile& profile,
+  const std::vector<pid_params_t>& candidates, std::size_t first, plant_run_result* results) {
+    static thread_local sweep_batch batch;
+    const plant_parameters& plant = sample.parameters;
+    uint32_t noise_state = sample.seed ? sample.seed : 1;
+    const heater_feedforward_t feedforward = heater_calculator_feedforward_parameters();
+    const std::size_t lanes   = std::min(batch_lanes, candidates.size() - first);
+    const float substeps      = std::round(options.period / PLANT_STEP_S);
+    const float power         = plant_heater_power(&plant);
+    const float junction_gain = PLANT_STEP_S / (plant.sensor_lag + PLANT_STEP_S);
+    const unsigned delay_steps = std::min(static_cast<unsigned>(std::lround(plant.sensor_dead_time / PLANT_STEP_S)),
+        PLANT_MAX_DEAD_TIME_STEPS - 1);
+    unsigned head = 0;
+
+    for (std::size_t l = 0; l < batch_lanes; l++) {
+        const pid_params_t& gains = candidates[first + std::min(l, lanes - 1)];
+        batch.kp[l] = gains.kp;
+        batch.ki[l] = gains.ki;
+        batch.kd[l] = gains.kd;
+        batch.integral[l] = batch.previous_error[l] = batch.ise[l] = 0.f;
+        batch.above_liquidus[l] = batch.final_error[l] = 0.f;
+        batch.plate[l]    = batch.junction[l] = batch.peak[l] = plant.ambient;
+        for (unsigned d = 0; d < PLANT_MAX_DEAD_TIME_STEPS; d++)
+            batch.delay_line[d][l] = plant.ambient;
+    }
+
+    unsigned stage = 0;
+    seconds time   = 0;
+    while (heating_profile_stage_at(&profile, time, &stage)) {
+        const float setpoint = static_cast<float>(profile.stages[stage].temperature);
+        const float accumulate = plant_is_heating_stage(&profile, stage) ? 1.f : 0.f;
+        const float* measured_row = batch.delay_line[(head + PLANT_MAX_DEAD_TIME_STEPS - 1 - delay_steps)
+          % PLANT_MAX_DEAD_TIME_STEPS];
+        const float noise = plant.sensor_noise > 0.f ? plant.sensor_noise * plant_next_gaussian(&noise_state) : 0.f;
+
+        // Same for every lane, the integral is held as in heater_calculator.c
+        // while the heater saturates with the feedforward on and the first
+        // window seeds the previous error
+        const float open_loop = heater_calculator_feedforward(&feedforward, &profile, time);
+        const float hold      = feedforward.is_enabled ? 1.f : 0.f;
+        for (std::size_t l = 0; l < batch_lanes; l++) {
+            float reading    = measured_row[l] + noise;
+            float measured   = reading > 0.f ? std::floor(reading * 4.f) / 4.f : 0.f;
+            float error      = setpoint - measured;
+            float integral   = batch.integral[l] + error * options.period;
+            float previous   = time == 0 ? error : batch.previous_error[l];
+            float derivative = (error - previous) / options.period;
+            float output     = (batch.kp[l] * error) + (batch.ki[l] * integral) + (batch.kd[l] * derivative)
+              + open_loop;
+            float saturated  = output > 100.f || output < 0.f ? hold : 0.f;
+            batch.integral[l] = saturated * batch.integral[l] + (1.f - saturated) * integral;
+            batch.previous_error[l] = error;
+            float percent    = output < 5.f ? 0.f : output > 100.f ? 100.f : output;
+            batch.on_steps[l] = std::floor(percent / 100.f * substeps + 0.5f);
+        }
+
+        for (float step = 0.f; step < substeps; step += 1.f) {
+            float* delay_row = batch.delay_line[head];
+            for (std::size_t l = 0; l < batch_lanes; l++) {
+                float heat = step < batch.on_steps[l] ? power : 0.f;
+                batch.plate[l] += PLANT_STEP_S * plant_plate_derivative(batch.plate[l], heat, plant.heat_capacity,
+                    plant.convective_loss, plant.radiative_loss, plant.ambient);
+                batch.junction[l] += junction_gain * (batch.plate[l] - batch.junction[l]);
+                delay_row[l] = batch.junction[l];
+                float error  = setpoint - batch.plate[l];
+                batch.ise[l] += accumulate * error * error * PLANT_STEP_S;
+                batch.peak[l] = std::max(batch.peak[l], batch.plate[l]);
+                batch.above_liquidus[l] += batch.plate[l] >= options.acceptance.liquidus ? PLANT_STEP_S : 0.f;
+                batch.final_error[l] = accumulate * error + (1.f - accumulate) * batch.final_error[l];
+            }
+            head = (head + 1) % PLANT_MAX_DEAD_TIME_STEPS;
+        }
+        time += static_cast<seconds>(std::lround(options.period));
+    }
+
+    const float highest = static_cast<float>(highest_setpoint(profile));
+    for (std::size_t l = 0; l < lanes; l++)
+        results[l] = { batch.ise[l], std::max(0.f, batch.peak[l] - highest), batch.peak[l], batch.above_liquidus[l],
+                       batch.final_error[l], time };
+}
+
+float run_scalar_controller(void* context, float measured, const heating_profile* profile, seconds time,
+  float period) {
+    return heater_calculator_iterate(static_cast<heater_calculator_t*>(context), measured, profile, time, period);
+}
+
+// Reference path through pid.c and heater_calculator.c, used to validate the
+// batched kernel on the winners.
+candidate_score simulate_scalar(const sweep_options& options, const std::vector<sweep_plant>& plants,
+  const heating_profile& profile, const pid_params_t& gains, std::size_t candidate) {
+    candidate_score score = { candidate, 0, 0.f, 0.f };
+
+    for (std::size_t i = 0; i < plants.size(); i++) {
+        plant_model plant;
+        heater_calculator_t calculator;
+
+        plant_init(&plant, &plants[i].parameters, plants[i].seed);
+        heater_calculator_reset(&calculator, gains);
+        heater_calculator_set_feedforward(&calculator, heater_calculator_feedforward_parameters());
+        plant_run_result result = plant_run_profile(&plant, &profile, options.period, options.acceptance.liquidus,
+            run_scalar_controller, &calculator);
+        score.failures += options.acceptance.is_failure(profile, result) ? 1 : 0;
+        if (i == 0) {
+            score.cost      = cost_of(options, result.ise, result.overshoot, result.duration);
+            score.overshoot = result.overshoot;
+        }
+    }
+    return score;
+}
+
+std::vector<sweep_plant> sample_plants(const sweep_options& options, const plant_parameters& nominal,
+  unsigned profile) {
+    std::vector<sweep_plant> plants = { { nominal, 1 } };
+
+    for (unsigned sample = 0; sample < options.plants; sample++) {
+        std::mt19937 generator = plant_sample_generator(options.seed, sample, profile);
+        plant_parameters parameters = randomize_plant(nominal, generator);
+        plants.push_back({ parameters, static_cast<uint32_t>(generator()) });
+    }
+    return plants;
+}
+
+bool parse_range(const char* text, gain_range& range) {
+    return 3 == std::sscanf(text, "%f:%f:%u", &range.min, &range.max, &range.count) && range.count > 0;
+}
+
+void print_usage(const char* name) {
+    std::printf("usage: %s [options]\n"
+      "  --kp min:max:count       proportional gain grid, geometric unless min is 0\n"
+      "  --ki min:max:count       integral gain grid, geometric unless min is 0\n"
+      "  --kd min:max:count       derivative gain grid, geometric unless min is 0\n"
+      "  --constant temp:seconds  setpoint used for the constant heating profile\n"
+      "  --overshoot-weight w     cost = ISE / duration + w * overshoot^2, ranks equal failure counts\n"
+      "  --plants n               randomized plants every candidate has to pass besides the nominal one\n"
+      "  --seed n                 base seed of the randomized plants\n"
+      "  --threads n              worker count, defaults to all cores\n"
+      "  --top n                  candidates listed per profile\n"
+      "  --output file            write pid_gains.scf there instead of stdout\n", name);
+}
+
+bool parse_options(int ac, char** av, sweep_options& options) {
+    for (int i = 1; i < ac; i++) {
+        const char* value = i + 1 < ac ? av[i + 1] : nullptr;
+        bool ok = value != nullptr;
+
+        if (!std::strcmp(av[i], "--kp") && ok)
+            ok = parse_range(value, options.kp);
+        else if (!std::strcmp(av[i], "--ki") && ok)
+            ok = parse_range(value, options.ki);
+        else if (!std::strcmp(av[i], "--kd") && ok)
+            ok = parse_range(value, options.kd);
+        else if (!std::strcmp(av[i], "--constant") && ok)
+            ok = 2 == std::sscanf(value, "%u:%u", &options.const_temperature, &options.const_duration);
+        else if (!std::strcmp(av[i], "--overshoot-weight") && ok)
+            options.overshoot_weight = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--plants") && ok)
+            options.plants = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--seed") && ok)
+            options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--threads") && ok)
+            options.threads = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--top") && ok)
+            options.top = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--output") && ok)
+            options.output = value;
+        else
+            return false;
+
+        if (!ok)
+            return false;
+        i++;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    sweep_options options;
+
+    if (!parse_options(ac, av, options)) {
+        print_usage(av[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<pid_params_t> candidates;
+    for (unsigned p = 0; p < options.kp.count; p++)
+        for (unsigned i = 0; i < options.ki.count; i++)
+            for (unsigned d = 0; d < options.kd.count; d++)
+                candidates.push_back({ options.kp.at(p), options.ki.at(i), options.kd.at(d) });
+
+    plant_parameters plant;
+    plant_default_parameters(&plant);
+
+    // In heating_profile_id order, the C designators aren't C++
+    static_assert(HEATING_PROFILE_CONSTANT == 0 && HEATING_PROFILE_JEDEC == 1 && HEATING_PROFILE_LAST == 2,
+      "profile tables below follow heating_profile_id");
+    temperature_stage constant_stage;
+    const heating_profile profiles[HEATING_PROFILE_LAST] = {
+        heating_profile_constant(&constant_stage, options.const_temperature, options.const_duration),
+        *heating_profile_get(HEATING_PROFILE_JEDEC),
+    };
+    const char* profile_names[HEATING_PROFILE_LAST] = { "HEATING_PROFILE_CONSTANT", "HEATING_PROFILE_JEDEC" };
+
+    work_stealing_pool pool(options.threads ? options.threads : std::thread::hardware_concurrency());
+    const std::size_t batches = (candidates.size() + batch_lanes - 1) / batch_lanes;
+    std::vector<sweep_plant> plants[HEATING_PROFILE_LAST];
+    std::vector<candidate_score> scores[HEATING_PROFILE_LAST];
+    std::vector<plant_run_result> results;
+
+    auto started = std::chrono::steady_clock::now();
+    for (unsigned profile = 0; profile < HEATING_PROFILE_LAST; profile++) {
+        const heating_profile& run = profiles[profile];
+        plants[profile] = sample_plants(options, plant, profile);
+        results.resize(plants[profile].size() * candidates.size());
+        pool.run(batches * plants[profile].size(), [&](std::size_t job) {
+            const std::size_t sample = job / batches, first = job % batches * batch_lanes;
+            simulate_batch(options, plants[profile][sample], run, candidates, first,
+              &results[sample * candidates.size() + first]);
+        });
+
+        scores[profile].resize(candidates.size());
+        for (std::size_t candidate = 0; candidate < candidates.size(); candidate++) {
+            const plant_run_result& nominal = results[candidate];
+            unsigned failures = 0;
+            for (std::size_t sample = 0; sample < plants[profile].size(); sample++)
+                failures += options.acceptance.is_failure(run, results[sample * candidates.size() + candidate]);
+            scores[profile][candidate] = { candidate, failures,
+                                           cost_of(options, nominal.ise, nominal.overshoot, nominal.duration),
+                                           nominal.overshoot };
+        }
+        std::sort(scores[profile].begin(), scores[profile].end(), is_better);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    std::fprintf(stderr, "%zu candidates x %u profiles x %u plants in %.3f s on %u workers\n", candidates.size(),
+      static_cast<unsigned>(HEATING_PROFILE_LAST), options.plants + 1, elapsed.count(), pool.size());
+
+    for (unsigned profile = 0; profile < HEATING_PROFILE_LAST; profile++) {
+        std::fprintf(stderr, "%s\n  %-4s %8s %8s %8s %8s %10s %10s %10s %10s\n", profile_names[profile], "rank", "kp",
+          "ki", "kd", "failures", "cost", "overshoot", "ref fails", "ref cost");
+        for (unsigned rank = 0; rank < std::min<std::size_t>(options.top, candidates.size()); rank++) {
+            const candidate_score& score = scores[profile][rank];
+            const pid_params_t& gains    = candidates[score.candidate];
+            candidate_score reference    = simulate_scalar(options, plants[profile], profiles[profile], gains,
+                score.candidate);
+            std::fprintf(stderr, "  %-4u %8.3f %8.4f %8.3f %8u %10.2f %10.2f %10u %10.2f\n", rank + 1, gains.kp,
+              gains.ki, gains.kd, score.failures, score.cost, score.overshoot, reference.failures, reference.cost);
+        }
+    }
+
+    FILE* output = options.output ? std::fopen(options.output, "w") : stdout;
+    if (output == nullptr) {
+        std::perror(options.output);
+        return EXIT_FAILURE;
+    }
+    for (unsigned profile = 0; profile < HEATING_PROFILE_LAST; profile++) {
+        const pid_params_t& gains = candidates[scores[profile].front().candidate];
+        std::fprintf(output, "PID_GAINS(%s, %.6ff, %.6ff, %.6ff)\n", profile_names[profile], gains.kp, gains.ki,
+          gains.kd);
+    }
+    if (output != stdout)
+        std::fclose(output);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "hd44780_model.h"
+
+#include <string.h>
+
+#define HD44780_NEVER              (INT64_MIN / 2)
+#define HD44780_EXECUTION_NS       37000
+#define HD44780_LONG_EXECUTION_NS  1520000
+#define HD44780_SECOND_LINE        0x40U
+
+static hd44780_model* attached;
+
+static uint32_t line_mask(pin_t pin) {
+    return (uint32_t) 1 << pin;
+}
+
+static uint32_t data_mask(const pinset* pins) {
+    return line_mask(pins->d4) | line_mask(pins->d5) | line_mask(pins->d6) | line_mask(pins->d7);
+}
+
+static uint8_t data_nibble(const pinset* pins, uint32_t lines) {
+    return (uint8_t) (((lines >> pins->d4) & 1) | ((lines >> pins->d5) & 1) << 1 |
+                      ((lines >> pins->d6) & 1) << 2 | ((lines >> pins->d7) & 1) << 3);
+}
+
+static void violation(hd44780_model* model, hd44780_violation kind) {
+    model->counters.violations[kind]++;
+}
+
+void hd44780_model_init(hd44780_model* model, const hd44780_model_config* config) {
+    memset(model, 0, sizeof(*model));
+    model->config       = *config;
+    model->rs_changed   = HD44780_NEVER;
+    model->data_changed = HD44780_NEVER;
+    model->enable_rose  = HD44780_NEVER;
+    model->enable_fell  = HD44780_NEVER;
+    model->busy_until   = HD44780_POWER_ON_NS;
+    model->increment    = true;
+    memset(model->ddram, ' ', sizeof(model->ddram));
+}
+
+void hd44780_model_attach(hd44780_model* model) {
+    attached = model;
+}
+
+void hd44780_model_reset_counters(hd44780_model* model) {
+    memset(&model->counters, 0, sizeof(model->counters));
+}
+
+unsigned long hd44780_model_violations(const hd44780_model* model) {
+    unsigned long violations = 0;
+
+    for (unsigned i = 0; i < HD44780_VIOLATION_LAST; i++)
+        violations += model->counters.violations[i];
+    return violations;
+}
+
+void hd44780_model_row(const hd44780_model* model, unsigned row, char* text) {
+    for (unsigned column = 0; column < HD44780_VISIBLE_COLUMNS; column++) {
+        unsigned offset = (column + model->display_offset) % HD44780_LINE_LENGTH;
+        text[column] = (char) model->ddram[row * HD44780_SECOND_LINE + offset];
+    }
+    text[HD44780_VISIBLE_COLUMNS] = '\0';
+}
+
+// The address counter skips the unused DDRAM between the lines
+static void move_address(hd44780_model* model, bool increment) {
+    if (model->cgram_selected) {
+        model->address = (model->address + (increment ? 1 : -1)) & (HD44780_CGRAM_SIZE - 1);
+        return;
+    }
+    unsigned line = model->address & HD44780_SECOND_LINE;
+    unsigned column = model->address & ~HD44780_SECOND_LINE;
+    if (increment && ++column == HD44780_LINE_LENGTH) {
+        column = 0;
+        line ^= HD44780_SECOND_LINE;
+    } else if (!increment && column-- == 0) {
+        column = HD44780_LINE_LENGTH - 1;
+        line ^= HD44780_SECOND_LINE;
+    }
+    model->address = (uint8_t) (line | column);
+}
+
+static void shift_display(hd44780_model* model, bool left) {
+    model->display_offset = (model->display_offset + (left ? 1 : HD44780_LINE_LENGTH - 1)) % HD44780_LINE_LENGTH;
+}
+
+static int64_t write_data(hd44780_model* model, uint8_t data) {
+    if (model->cgram_selected) {
+        model->cgram[model->address] = data & 0x1F;
+        model->counters.cgram_writes++;
+    } else {
+        model->ddram[model->address] = data;
+    }
+    move_address(model, model->increment);
+    if (model->shift_display && !model->cgram_selected)
+        shift_display(model, model->increment);
+    return HD44780_EXECUTION_NS;
+}
+
+// The reset sequence wants 4.1 ms after the first function set and 100 us
+// after the second one
+static int64_t function_set(hd44780_model* model, uint8_t command) {
+    int64_t execution = HD44780_EXECUTION_NS;
+
+    if (!model->four_bit) {
+        model->function_sets++;
+        execution = model->function_sets == 1 ? 4100000 : model->function_sets == 2 ? 100000 : execution;
+    }
+    model->four_bit = !(command & 0x10);
+    model->two_lines = command & 0x08;
+    return execution;
+}
+
+static int64_t write_command(hd44780_model* model, uint8_t command) {
+    if (command & 0x80) {
+        model->cgram_selected = false;
+        model->address = command & 0x7F;
+    } else if (command & 0x40) {
+        model->cgram_selected = true;
+        model->address = command & 0x3F;
+    } else if (command & 0x20) {
+        return function_set(model, command);
+    } else if (command & 0x10) {
+        (command & 0x08) ? shift_display(model, !(command & 0x04)) : move_address(model, command & 0x04);
+    } else if (command & 0x08) {
+        model->display_control = command & 0x07;
+    } else if (command & 0x04) {
+        model->increment = command & 0x02;
+        model->shift_display = command & 0x01;
+    } else if (command & 0x02) {
+        model->cgram_selected = false;
+        model->address = 0;
+        model->display_offset = 0;
+        return HD44780_LONG_EXECUTION_NS;
+    } else if (command & 0x01) {
+        memset(model->ddram, ' ', sizeof(model->ddram));
+        model->cgram_selected = false;
+        model->address = 0;
+        model->increment = true;
+        model->display_offset = 0;
+        return HD44780_LONG_EXECUTION_NS;
+    }
+    return HD44780_EXECUTION_NS;
+}
+
+// Falling edge of enable, in 8 bit mode D0-D3 are pulled low
+static void latch(hd44780_model* model, uint32_t lines) {
+    const pinset* pins = &model->config.pins;
+    uint8_t nibble = data_nibble(pins, lines);
+    bool rs = lines & line_mask(pins->rs);
+    uint8_t value;
+
+    if (!model->low_pending && model->now < model->busy_until)
+        violation(model, HD44780_VIOLATION_BUSY);
+    if (model->four_bit && !model->low_pending) {
+        model->high = nibble;
+        model->low_pending = true;
+        return;
+    }
+    value = model->four_bit ? (uint8_t) (model->high << 4 | nibble) : (uint8_t) (nibble << 4);
+    model->low_pending = false;
+    model->counters.instructions++;
+    model->busy_until = model->now + (rs ? write_data(model, value) : write_command(model, value));
+}
+
+static void apply(hd44780_model* model, uint32_t lines) {
+    const pinset* pins = &model->config.pins;
+    uint32_t enable = line_mask(pins->enable);
+    uint32_t changed = model->lines ^ lines;
+    int64_t now = model->now;
+
+    if ((changed & enable) && !(lines & enable)) {
+        if (now - model->enable_rose < HD44780_ENABLE_PULSE_NS)
+            violation(model, HD44780_VIOLATION_ENABLE_PULSE);
+        if (now - model->data_changed < HD44780_DATA_SETUP_NS)
+            violation(model, HD44780_VIOLATION_DATA_SETUP);
+        model->enable_fell = now;
+        latch(model, model->lines);
+    }
+    if (changed & (line_mask(pins->rs) | data_mask(pins))) {
+        if (now - model->enable_fell < HD44780_HOLD_NS)
+            violation(model, HD44780_VIOLATION_HOLD);
+        model->rs_changed = changed & line_mask(pins->rs) ? now : model->rs_changed;
+        model->data_changed = changed & data_mask(pins) ? now : model->data_changed;
+    }
+    if ((changed & enable) && (lines & enable)) {
+        if (now - model->rs_changed < HD44780_ADDRESS_SETUP_NS)
+            violation(model, HD44780_VIOLATION_ADDRESS_SETUP);
+        if (now - model->enable_rose < HD44780_ENABLE_CYCLE_NS)
+            violation(model, HD44780_VIOLATION_ENABLE_CYCLE);
+        model->enable_rose = now;
+    }
+    model->lines = lines;
+}
+
+bool hd44780_model_pin_set(pin_t pin, bool state) {
+    uint32_t lines = attached->lines & ~line_mask(pin);
+
+    attached->counters.operations++;
+    apply(attached, lines | (state ? line_mask(pin) : 0));
+    attached->now += attached->config.operation_time;
+    return true;
+}
+
+void hd44780_model_wait(unsigned microseconds) {
+    attached->counters.waits++;
+    attached->counters.blocked += (uint64_t) microseconds * 1000;
+    attached->now += (int64_t) microseconds * 1000;
+}
+
+bool hd44780_model_bus_write(uint8_t nibble, bool rs) {
+    const pinset* pins = &attached->config.pins;
+    uint32_t lines = attached->lines & ~(data_mask(pins) | line_mask(pins->rs));
+
+    lines |= (nibble & 0x1 ? line_mask(pins->d4) : 0) | (nibble & 0x2 ? line_mask(pins->d5) : 0) |
+             (nibble & 0x4 ? line_mask(pins->d6) : 0) | (nibble & 0x8 ? line_mask(pins->d7) : 0) |
+             (rs ? line_mask(pins->rs) : 0);
+    attached->counters.operations++;
+    apply(attached, lines);
+    attached->now += attached->config.operation_time;
+    return true;
+}
+
+bool hd44780_model_port_write(const uint8_t* states, unsigned count) {
+    attached->counters.operations++;
+    attached->now += attached->config.byte_time;
+    for (unsigned i = 0; i < count; i++) {
+        attached->counters.states++;
+        apply(attached, states[i]);
+        attached->now += attached->config.byte_time;
+    }
+    return true;
+}
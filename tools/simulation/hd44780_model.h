@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _TOOLS_SIMULATION_HD44780_MODEL_
+#define _TOOLS_SIMULATION_HD44780_MODEL_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd1602/lcd1602.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HD44780_DDRAM_SIZE       0x80U
+#define HD44780_CGRAM_SIZE       0x40U
+#define HD44780_LINE_LENGTH      40U
+#define HD44780_VISIBLE_COLUMNS  16U
+#define HD44780_ROWS             2U
+
+// Bus timing minimums of the datasheet at 5 V, nanoseconds
+#define HD44780_ENABLE_PULSE_NS  230
+#define HD44780_ENABLE_CYCLE_NS  500
+#define HD44780_ADDRESS_SETUP_NS 40
+#define HD44780_DATA_SETUP_NS    80
+#define HD44780_HOLD_NS          10
+// Internal reset, instructions before it are lost
+#define HD44780_POWER_ON_NS      40000000
+
+typedef enum {
+    HD44780_VIOLATION_ENABLE_PULSE,  // enable high shorter than its minimum width
+    HD44780_VIOLATION_ENABLE_CYCLE,  // enable rose again too early
+    HD44780_VIOLATION_ADDRESS_SETUP, // RS changed too shortly before enable rose
+    HD44780_VIOLATION_DATA_SETUP,    // D4-D7 changed too shortly before enable fell
+    HD44780_VIOLATION_HOLD,          // RS or D4-D7 changed too shortly after enable fell
+    HD44780_VIOLATION_BUSY,          // latched while the previous instruction was executing
+    HD44780_VIOLATION_LAST
+} hd44780_violation;
+
+typedef struct {
+    pinset   pins;           // line numbers, port bits when driven through hd44780_model_port_write()
+    uint32_t operation_time; // ns a pin_set or bus_write call takes
+    uint32_t byte_time;      // ns one port state takes on the wire, the address byte as long
+} hd44780_model_config;
+
+typedef struct {
+    unsigned long operations;   // pin_set, bus_write and port write calls
+    unsigned long states;       // port states written
+    unsigned long waits;
+    uint64_t      blocked;      // ns spent in wait
+    unsigned long instructions; // commands and data latched
+    unsigned long cgram_writes;
+    unsigned long violations[HD44780_VIOLATION_LAST];
+} hd44780_counters;
+
+// Controller behind the 4 bit interface of lcd1602.c, decodes the bus into
+// DDRAM and CGRAM contents and checks its timing against the minimums above.
+// Time only passes in the callbacks: a call takes operation_time, a port state
+// byte_time and wait() what it is asked for.
+typedef struct {
+    hd44780_model_config config;
+    int64_t  now;          // ns since power on
+    uint32_t lines;        // levels, bit n for line n
+    int64_t  rs_changed;
+    int64_t  data_changed;
+    int64_t  enable_rose;
+    int64_t  enable_fell;
+    int64_t  busy_until;
+    bool     four_bit;
+    bool     low_pending;  // high nibble latched, waiting for the low one
+    uint8_t  high;
+    unsigned function_sets; // 8 bit function sets, the init sequence times them
+    uint8_t  ddram[HD44780_DDRAM_SIZE];
+    uint8_t  cgram[HD44780_CGRAM_SIZE];
+    uint8_t  address;
+    bool     cgram_selected;
+    bool     increment;
+    bool     shift_display;
+    unsigned display_offset; // DDRAM column shown in the first visible column
+    uint8_t  display_control;
+    bool     two_lines;
+    hd44780_counters counters;
+} hd44780_model;
+
+void hd44780_model_init(hd44780_model* model, const hd44780_model_config* config);
+// Model the callbacks below drive, lcd1602_interface carries no context
+void hd44780_model_attach(hd44780_model* model);
+void hd44780_model_reset_counters(hd44780_model* model);
+unsigned long hd44780_model_violations(const hd44780_model* model);
+// Visible characters of a row with the display shift applied, text takes HD44780_VISIBLE_COLUMNS + 1
+void hd44780_model_row(const hd44780_model* model, unsigned row, char* text);
+
+bool hd44780_model_pin_set(pin_t pin, bool state);
+void hd44780_model_wait(unsigned microseconds);
+bool hd44780_model_bus_write(uint8_t nibble, bool rs);
+bool hd44780_model_port_write(const uint8_t* states, unsigned count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _TOOLS_SIMULATION_HD44780_MODEL_
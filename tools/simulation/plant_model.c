@@ -0,0 +1,171 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "plant_model.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void plant_default_parameters(plant_parameters* parameters) {
+    *parameters = (plant_parameters) {
+        .heat_capacity     = 350.f,
+        .convective_loss   = 1.2f,
+        .radiative_loss    = 1.1e-9f,
+        .heater_resistance = 44.f,
+        .mains_voltage     = 230.f,
+        .ambient           = 22.f,
+        .sensor_lag        = 3.f,
+        .sensor_dead_time  = 2.f,
+        .sensor_noise      = 0.f,
+    };
+}
+
+void plant_init(plant_model* plant, const plant_parameters* parameters, uint32_t seed) {
+    memset(plant, 0, sizeof(*plant));
+    plant->parameters  = *parameters;
+    plant->plate       = parameters->ambient;
+    plant->junction    = parameters->ambient;
+    plant->noise_state = seed ? seed : 1;
+
+    unsigned steps = (unsigned) lroundf(parameters->sensor_dead_time / PLANT_STEP_S);
+    plant->delay_steps = steps < PLANT_MAX_DEAD_TIME_STEPS ? steps : PLANT_MAX_DEAD_TIME_STEPS - 1;
+    for (unsigned i = 0; i < PLANT_MAX_DEAD_TIME_STEPS; i++)
+        plant->delay_line[i] = parameters->ambient;
+}
+
+void plant_step(plant_model* plant, bool heater_on, float dt) {
+    const plant_parameters* p = &plant->parameters;
+    float power = heater_on ? plant_heater_power(p) : 0.f;
+
+    plant->plate += dt * plant_plate_derivative(plant->plate, power, p->heat_capacity, p->convective_loss,
+        p->radiative_loss, p->ambient);
+    plant->junction += dt / (p->sensor_lag + dt) * (plant->plate - plant->junction);
+
+    plant->delay_line[plant->delay_head] = plant->junction;
+    plant->delay_head = (plant->delay_head + 1) % PLANT_MAX_DEAD_TIME_STEPS;
+}
+
+float plant_next_gaussian(uint32_t* state) {
+    // xorshift32 fed Box-Muller, deterministic for a given seed
+    float u[2];
+
+    for (unsigned i = 0; i < 2; i++) {
+        *state ^= *state << 13;
+        *state ^= *state >> 17;
+        *state ^= *state << 5;
+        u[i]    = ((float) (*state >> 8) + 1.f) / 16777217.f;
+    }
+    return sqrtf(-2.f * logf(u[0])) * cosf(6.2831853f * u[1]);
+}
+
+float plant_read_sensor(plant_model* plant) {
+    unsigned index = (plant->delay_head + PLANT_MAX_DEAD_TIME_STEPS - 1 - plant->delay_steps)
+      % PLANT_MAX_DEAD_TIME_STEPS;
+    float reading = plant->delay_line[index];
+
+    if (plant->parameters.sensor_noise > 0.f)
+        reading += plant->parameters.sensor_noise * plant_next_gaussian(&plant->noise_state);
+
+    return reading > 0.f ? floorf(reading * 4.f) / 4.f : 0.f;
+}
+
+static float crossing_time(const float* samples, unsigned count, float level, float period) {
+    for (unsigned i = 1; i < count; i++) {
+        if (samples[i] >= level) {
+            float fraction = samples[i] > samples[i - 1] ?
+              (level - samples[i - 1]) / (samples[i] - samples[i - 1]) : 0.f;
+            return ((float) (i - 1) + fraction) * period;
+        }
+    }
+    return (float) count * period;
+}
+
+fopdt_model_t plant_identify_fopdt(const plant_parameters* parameters, float percent, float period,
+  seconds duration) {
+    const unsigned substeps = (unsigned) lroundf(period / PLANT_STEP_S);
+    const unsigned on_steps = (unsigned) lroundf(percent / 100.f * (float) substeps);
+    const unsigned count    = (unsigned) lroundf((float) duration / period) + 1;
+    const unsigned tail     = count / 20 ? count / 20 : 1;
+    float* samples = malloc(count * sizeof(*samples));
+    plant_parameters quiet = *parameters;
+    plant_model plant;
+    float final = 0.f;
+
+    quiet.sensor_noise = 0.f;
+    plant_init(&plant, &quiet, 1);
+    for (unsigned i = 0; i < count; i++) {
+        samples[i] = plant_read_sensor(&plant);
+        for (unsigned step = 0; step < substeps; step++)
+            plant_step(&plant, step < on_steps, PLANT_STEP_S);
+    }
+    for (unsigned i = count - tail; i < count; i++)
+        final += samples[i] / (float) tail;
+
+    float rise          = final - samples[0];
+    float time_28       = crossing_time(samples, count, samples[0] + 0.283f * rise, period);
+    float time_63       = crossing_time(samples, count, samples[0] + 0.632f * rise, period);
+    float time_constant = 1.5f * (time_63 - time_28);
+
+    free(samples);
+    return (fopdt_model_t) {
+        .gain          = rise / percent,
+        .time_constant = time_constant,
+        .dead_time     = time_63 - time_constant > 0.f ? time_63 - time_constant : 0.f,
+        .ambient       = parameters->ambient,
+    };
+}
+
+bool plant_is_heating_stage(const heating_profile* profile, unsigned stage) {
+    return stage == 0 || profile->stages[stage].temperature >= profile->stages[stage - 1].temperature;
+}
+
+plant_run_result plant_run_profile(plant_model* plant, const heating_profile* profile, float period,
+  float liquidus, plant_controller controller, void* context) {
+    plant_run_result result = { .peak = plant->plate };
+    celcius highest_setpoint = 0;
+    const unsigned substeps  = (unsigned) lroundf(period / PLANT_STEP_S);
+    unsigned stage = 0;
+    seconds time   = 0;
+
+    for (unsigned i = 0; i < profile->stage_count; i++)
+        highest_setpoint = profile->stages[i].temperature > highest_setpoint ?
+          profile->stages[i].temperature : highest_setpoint;
+
+    while (heating_profile_stage_at(profile, time, &stage)) {
+        float setpoint = (float) profile->stages[stage].temperature;
+        float percent  = controller(context, plant_read_sensor(plant), profile, time, period);
+        unsigned on_steps = (unsigned) lroundf(percent / 100.f * (float) substeps);
+        bool accumulate   = plant_is_heating_stage(profile, stage);
+
+        for (unsigned step = 0; step < substeps; step++) {
+            plant_step(plant, step < on_steps, PLANT_STEP_S);
+            float error = setpoint - plant->plate;
+            result.ise += accumulate ? error * error * PLANT_STEP_S : 0.f;
+            result.peak = plant->plate > result.peak ? plant->plate : result.peak;
+            result.time_above_liquidus += plant->plate >= liquidus ? PLANT_STEP_S : 0.f;
+            result.final_error = accumulate ? error : result.final_error;
+        }
+        time += (seconds) lroundf(period);
+    }
+    result.duration  = time;
+    result.overshoot = result.peak > highest_setpoint ? result.peak - highest_setpoint : 0.f;
+    return result;
+}
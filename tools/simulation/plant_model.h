@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 WJKPK
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _TOOLS_SIMULATION_PLANT_MODEL_
+#define _TOOLS_SIMULATION_PLANT_MODEL_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "heating_profile.h"
+#include "heater_mpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLANT_STEP_S                 0.1f
+#define PLANT_MAX_DEAD_TIME_STEPS    128U
+#define PLANT_KELVIN_OFFSET          273.15f
+
+// Lumped thermal model of the heating plate, the thermocouple and its amplifier.
+typedef struct {
+    float heat_capacity;     // J/K, plate and heater mass
+    float convective_loss;   // W/K
+    float radiative_loss;    // W/K^4, emissivity * Stefan-Boltzmann constant * area
+    float heater_resistance; // Ohm
+    float mains_voltage;     // V rms
+    float ambient;           // degC
+    float sensor_lag;        // s, first order lag of the thermocouple junction
+    float sensor_dead_time;  // s, transport delay plus amplifier conversion latency
+    float sensor_noise;      // degC, standard deviation of the readout noise
+} plant_parameters;
+
+typedef struct {
+    plant_parameters parameters;
+    float            plate;
+    float            junction;
+    float            delay_line[PLANT_MAX_DEAD_TIME_STEPS];
+    unsigned         delay_steps;
+    unsigned         delay_head;
+    uint32_t         noise_state;
+} plant_model;
+
+typedef struct {
+    float   ise;                 // K^2*s, accumulated over heating stages only
+    float   overshoot;           // K, plate peak above the highest setpoint
+    float   peak;                // degC
+    float   time_above_liquidus; // s
+    float   final_error;         // K, setpoint minus plate at the end of the last heating stage
+    seconds duration;            // s
+} plant_run_result;
+
+// Returns heater power in percent for the next control window.
+typedef float (*plant_controller)(void* context, float measured, const heating_profile* profile, seconds time,
+  float period);
+
+void plant_default_parameters(plant_parameters* parameters);
+void plant_init(plant_model* plant, const plant_parameters* parameters, uint32_t seed);
+void plant_step(plant_model* plant, bool heater_on, float dt);
+// Thermocouple amplifier readout in 0.25 degC steps, as returned by spi_read()
+float plant_read_sensor(plant_model* plant);
+// Standard normal draw behind the readout noise, advances the seed plant_init() took
+float plant_next_gaussian(uint32_t* state);
+
+plant_run_result plant_run_profile(plant_model* plant, const heating_profile* profile, float period,
+  float liquidus, plant_controller controller, void* context);
+
+// Two point (28.3 % and 63.2 % of the final rise) first order plus dead time
+// fit of the sensor response to a constant duty step from ambient, the same
+// experiment one would run on the device to calibrate the MPC model.
+fopdt_model_t plant_identify_fopdt(const plant_parameters* parameters, float percent, float period,
+  seconds duration);
+
+// Same stage classification as plant_run_profile(): error is only accumulated
+// while the setpoint is not below the previous stage, passive cooldown is skipped.
+bool plant_is_heating_stage(const heating_profile* profile, unsigned stage);
+
+static inline float plant_heater_power(const plant_parameters* parameters) {
+    return parameters->mains_voltage * parameters->mains_voltage / parameters->heater_resistance;
+}
+
+static inline float plant_plate_derivative(float plate, float power, float heat_capacity, float convective_loss,
+  float radiative_loss, float ambient) {
+    float plate_k   = plate + PLANT_KELVIN_OFFSET;
+    float ambient_k = ambient + PLANT_KELVIN_OFFSET;
+    float losses    = convective_loss * (plate - ambient)
+      + radiative_loss * (plate_k * plate_k * plate_k * plate_k - ambient_k * ambient_k * ambient_k * ambient_k);
+
+    return (power - losses) / heat_capacity;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _TOOLS_SIMULATION_PLANT_MODEL_
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TOOLS_SIMULATION_PLANT_SPREAD_
+#define _TOOLS_SIMULATION_PLANT_SPREAD_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+extern "C" {
+#include "heating_profile.h"
+#include "simulation/plant_model.h"
+}
+
+// Production spread of the plant and what a run on it has to achieve, shared
+// by the tools so gains are picked and signed off against the same criteria.
+
+struct acceptance_window {
+    float min;
+    float max;
+
+    bool contains(float value) const {
+        return value >= min && value <= max;
+    }
+};
+
+struct acceptance_criteria {
+    float             liquidus           = 217.f;
+    acceptance_window reflow_peak        = { 235.f, 260.f };
+    acceptance_window reflow_tal         = { 30.f, 150.f };
+    float             constant_overshoot = 10.f;
+    float             constant_error     = 5.f;
+
+    static bool is_reflow_profile(const heating_profile& profile) {
+        return profile.stage_count > 1;
+    }
+
+    bool is_failure(const heating_profile& profile, const plant_run_result& result) const {
+        if (is_reflow_profile(profile))
+            return !reflow_peak.contains(result.peak) || !reflow_tal.contains(result.time_above_liquidus);
+
+        return result.overshoot > constant_overshoot || std::fabs(result.final_error) > constant_error;
+    }
+};
+
+// Seeded per sample and profile, so results don't depend on the worker count
+inline std::mt19937 plant_sample_generator(unsigned seed, unsigned sample, unsigned profile) {
+    return std::mt19937(seed + sample * 7919U + profile);
+}
+
+// Production spread around plant_default_parameters(): plate mass and
+// insulation, thermocouple mounting, mains voltage and room temperature.
+inline plant_parameters randomize_plant(const plant_parameters& nominal, std::mt19937& generator) {
+    std::normal_distribution<float> mass(1.f, 0.12f);
+    std::normal_distribution<float> losses(1.f, 0.2f);
+    std::uniform_real_distribution<float> dead_time(1.f, 4.f);
+    std::uniform_real_distribution<float> lag(1.5f, 5.f);
+    std::uniform_real_distribution<float> noise(0.f, 1.f);
+    std::uniform_real_distribution<float> mains(207.f, 253.f);
+    std::uniform_real_distribution<float> ambient(15.f, 35.f);
+    plant_parameters plant = nominal;
+
+    plant.heat_capacity    *= std::max(0.5f, mass(generator));
+    plant.convective_loss  *= std::max(0.3f, losses(generator));
+    plant.radiative_loss   *= std::max(0.3f, losses(generator));
+    plant.sensor_dead_time  = dead_time(generator);
+    plant.sensor_lag        = lag(generator);
+    plant.sensor_noise      = noise(generator);
+    plant.mains_voltage     = mains(generator);
+    plant.ambient           = ambient(generator);
+    return plant;
+}
+
+#endif // _TOOLS_SIMULATION_PLANT_SPREAD_
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TOOLS_SIMULATION_THREAD_POOL_
+#define _TOOLS_SIMULATION_THREAD_POOL_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers, each owning a deque of job indices. A worker pops from
+// the back of its own deque and, once empty, steals from the front of the
+// others, so uneven simulation lengths still keep every core busy.
+class work_stealing_pool {
+public:
+    explicit work_stealing_pool(unsigned workers = std::thread::hardware_concurrency())
+        : queues(workers ? workers : 1) {
+        for (unsigned i = 0; i < queues.size(); i++)
+            threads.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    ~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            stopping = true;
+        }
+        state_changed.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    unsigned size(void) const {
+        return static_cast<unsigned>(queues.size());
+    }
+
+    // Runs job(0) ... job(count - 1) and blocks until all of them returned.
+    void run(std::size_t count, const std::function<void(std::size_t)>& job) {
+        if (count == 0)
+            return;
+
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            remaining = count;
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            auto& queue = queues[i * queues.size() / count];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.jobs.push_back({ &job, i });
+        }
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            generation++;
+        }
+        state_changed.notify_all();
+
+        std::unique_lock<std::mutex> guard(state_lock);
+        state_changed.wait(guard, [this] { return remaining == 0; });
+    }
+
+private:
+    // Every entry carries its routine, a worker still draining the previous
+    // run can't pair a fresh index with a stale routine.
+    struct pending_job {
+        const std::function<void(std::size_t)>* routine;
+        std::size_t                             index;
+    };
+
+    struct worker_queue {
+        std::mutex              lock;
+        std::deque<pending_job> jobs;
+    };
+
+    bool pop_local(unsigned worker, pending_job& job) {
+        auto& queue = queues[worker];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.jobs.empty())
+            return false;
+
+        job = queue.jobs.back();
+        queue.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned thief, pending_job& job) {
+        for (unsigned offset = 1; offset < queues.size(); offset++) {
+            auto& victim = queues[(thief + offset) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.front();
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(unsigned worker) {
+        std::size_t seen_generation = 0;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(state_lock);
+                state_changed.wait(guard, [&] { return stopping || generation != seen_generation; });
+                if (stopping)
+                    return;
+
+                seen_generation = generation;
+            }
+
+            pending_job job;
+            while (pop_local(worker, job) || steal(worker, job)) {
+                (*job.routine)(job.index);
+                std::lock_guard<std::mutex> guard(state_lock);
+                if (--remaining == 0)
+                    state_changed.notify_all();
+            }
+        }
+    }
+
+    std::vector<worker_queue> queues;
+    std::vector<std::thread>  threads;
+    std::mutex                state_lock;
+    std::condition_variable   state_changed;
+    std::size_t               remaining  = 0;
+    std::size_t               generation = 0;
+    bool                      stopping   = false;
+};
+
+#endif // _TOOLS_SIMULATION_THREAD_POOL_
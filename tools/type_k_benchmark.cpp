@@ -0,0 +1,209 @@
+/*
+ * Copyright 2023 WJKPK
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the type K conversion of thermocouple_type_k.c with evaluating the
+// NIST ITS-90 polynomials at run time, in float as firmware would and in
+// double as the reference. Every conversion turns a measured EMF and a cold
+// junction temperature into the hot junction temperature. Reports the worst
+// error against the true temperature and the cost per conversion. The host
+// has a floating point unit, on the C3 the polynomial columns run in soft
+// float and are several times slower still.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+extern "C" {
+#include "temperature.h"
+#include "thermocouple_type_k.h"
+}
+
+namespace {
+
+struct benchmark_options {
+    unsigned samples     = 4096;
+    unsigned repetitions = 200;
+    float    minimum     = 0.f;
+    float    maximum     = 400.f;
+    unsigned seed        = 2024;
+};
+
+template <typename T> T forward(T t) {
+    static const T negative[] = {
+        0.0, 3.94501280250e-02, 2.36223735980e-05, -3.28589067840e-07, -4.99048287770e-09, -6.75090591730e-11,
+        -5.74103274280e-13, -3.10888728940e-15, -1.04516093650e-17, -1.98892668780e-20, -1.63226974860e-23,
+    };
+    static const T positive[] = {
+        -1.76004136860e-02, 3.89212049750e-02, 1.85587700320e-05, -9.94575928740e-08, 3.18409457190e-10,
+        -5.60728448890e-13, 5.60750590590e-16, -3.20207200030e-19, 9.71511471520e-23, -1.21047212750e-26,
+    };
+    const T* c = t < T(0) ? negative : positive;
+    T e = T(0);
+
+    for (int i = t < T(0) ? 10 : 9; i >= 0; i--)
+        e = e * t + c[i];
+    const T a = t - T(1.269686e+02);
+    return t < T(0) ? e : e + T(1.185976e-01) * std::exp(T(-1.183432e-04) * a * a);
+}
+
+template <typename T> T inverse(T e) {
+    static const T negative[] = {
+        0.0, 2.5173462e+01, -1.1662878e+00, -1.0833638e+00, -8.9773540e-01, -3.7342377e-01, -8.6632643e-02,
+        -1.0450598e-02, -5.1920577e-04,
+    };
+    static const T low[] = {
+        0.0, 2.508355e+01, 7.860106e-02, -2.503131e-01, 8.315270e-02, -1.228034e-02, 9.804036e-04, -4.413030e-05,
+        1.057734e-06, -1.052755e-08,
+    };
+    static const T high[] = {
+        -1.318058e+02, 4.830222e+01, -1.646031e+00, 5.464731e-02, -9.650715e-04, 8.802193e-06, -3.110810e-08,
+    };
+    const T* d = e < T(0) ? negative : e < T(20.644) ? low : high;
+    T t = T(0);
+
+    for (int i = e < T(0) ? 8 : e < T(20.644) ? 9 : 6; i >= 0; i--)
+        t = t * e + d[i];
+    return t;
+}
+
+struct sample {
+    double        hot;
+    int32_t       voltage;
+    temperature_t cold_junction;
+};
+
+std::vector<sample> make_samples(const benchmark_options& options) {
+    std::mt19937 generator(options.seed);
+    std::uniform_real_distribution<double> hot(options.minimum, options.maximum);
+    std::uniform_real_distribution<double> cold(15., 45.);
+    std::vector<sample> result;
+
+    for (unsigned i = 0; i < options.samples; i++) {
+        sample s;
+        s.hot           = hot(generator);
+        s.cold_junction = static_cast<temperature_t>(std::lround(cold(generator) * TEMPERATURE_ONE));
+        s.voltage       = static_cast<int32_t>(std::lround(1000. * (forward(s.hot)
+          - forward(static_cast<double>(temperature_to_float(s.cold_junction))))));
+        result.push_back(s);
+    }
+    return result;
+}
+
+uint64_t timestamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct conversion_result {
+    double worst;
+    double per_conversion;
+};
+
+template <typename Convert>
+conversion_result run_benchmark(const benchmark_options& options, const std::vector<sample>& samples,
+  Convert convert) {
+    std::vector<double> output(samples.size());
+
+    uint64_t started = timestamp();
+    for (unsigned repetition = 0; repetition < options.repetitions; repetition++) {
+        for (std::size_t i = 0; i < samples.size(); i++)
+            output[i] = convert(samples[i]);
+    }
+    double per_conversion = static_cast<double>(timestamp() - started)
+      / static_cast<double>(options.repetitions * samples.size());
+
+    double worst = 0.;
+    for (std::size_t i = 0; i < samples.size(); i++)
+        worst = std::max(worst, std::fabs(output[i] - samples[i].hot));
+    return { worst, per_conversion };
+}
+
+void print_usage(const char* name) {
+    std::printf("usage: %s [options]\n"
+      "  --samples n              conversions per repetition\n"
+      "  --min degC               lowest hot junction temperature\n"
+      "  --max degC               highest hot junction temperature\n"
+      "  --seed n                 sample seed\n", name);
+}
+
+bool parse_options(int ac, char** av, benchmark_options& options) {
+    for (int i = 1; i < ac; i++) {
+        const char* value = i + 1 < ac ? av[i + 1] : nullptr;
+        bool ok = value != nullptr;
+
+        if (!std::strcmp(av[i], "--samples") && ok)
+            options.samples = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (!std::strcmp(av[i], "--min") && ok)
+            options.minimum = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--max") && ok)
+            options.maximum = std::strtof(value, nullptr);
+        else if (!std::strcmp(av[i], "--seed") && ok)
+            options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else
+            return false;
+
+        if (!ok)
+            return false;
+        i++;
+    }
+    return options.samples > 0 && options.minimum >= -200.f && options.maximum <= 1372.f
+      && options.minimum < options.maximum;
+}
+
+} // namespace
+
+int main(int ac, char** av) {
+    benchmark_options options;
+
+    if (!parse_options(ac, av, options)) {
+        print_usage(av[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<sample> samples = make_samples(options);
+    const conversion_result results[] = {
+        run_benchmark(options, samples, [](const sample& s) {
+            return static_cast<double>(temperature_to_float(type_k_compensate(s.voltage, s.cold_junction)));
+        }),
+        run_benchmark(options, samples, [](const sample& s) {
+            float cold = forward(temperature_to_float(s.cold_junction));
+            return static_cast<double>(inverse(static_cast<float>(s.voltage) / 1000.f + cold));
+        }),
+        run_benchmark(options, samples, [](const sample& s) {
+            double cold = forward(static_cast<double>(temperature_to_float(s.cold_junction)));
+            return inverse(static_cast<double>(s.voltage) / 1000. + cold);
+        }),
+    };
+    const char* names[] = { "table Q10.2", "float poly", "double poly" };
+
+    std::printf("%u conversions, %.0f..%.0f degC hot, 15..45 degC cold junction\n  %-14s %10s %10s\n",
+      options.samples, options.minimum, options.maximum, "", "worst", "cycles");
+    for (std::size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+        std::printf("  %-14s %10.3f %10.1f\n", names[i], results[i].worst, results[i].per_conversion);
+
+    return EXIT_SUCCESS;
+}